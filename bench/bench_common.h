@@ -0,0 +1,86 @@
+#pragma once
+
+// Helpers shared by the benchmarks.
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mandelbulb.h"
+#include "mandelbulb_simd.h"
+
+// Sample points, in structure-of-arrays layout for mandelbulb_batch().
+struct PointSet {
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+
+	void add(const glm::vec3 pos) {
+		x.push_back(pos.x);
+		y.push_back(pos.y);
+		z.push_back(pos.z);
+	}
+
+	[[nodiscard]] glm::vec3 get(const int i) const {
+		return {x[i], y[i], z[i]};
+	}
+
+	[[nodiscard]] int size() const {
+		return static_cast<int>(x.size());
+	}
+};
+
+// Marches rays from random directions towards the origin and keeps the points where they hit,
+// which is where the renderer spends most of its distance estimator evaluations.
+inline PointSet surface_points(const MandelbulbParams& params, const int count, std::mt19937& rng) {
+	constexpr int max_steps = 256;
+	constexpr float threshold = 1e-4f;
+
+	std::normal_distribution<float> normal;
+	PointSet points;
+	while (points.size() < count) {
+		const glm::vec3 direction = glm::normalize(glm::vec3(normal(rng), normal(rng), normal(rng)));
+		glm::vec3 pos = direction * 1.5f;
+		for (int i = 0; i < max_steps; i++) {
+			float trap = 1e20f;
+			const float dist = mandelbulb(pos, params.power, params.iterations, params.escape_radius, trap);
+			if (dist < threshold) {
+				points.add(pos);
+				break;
+			}
+			pos -= direction * dist;
+		}
+	}
+	return points;
+}
+
+// The generic formula in double precision. Both float formulas are compared against it too, since
+// orbits close to the fractal's boundary are chaotic and any rounding difference can move their
+// escape iteration; the float generic formula's own error is the floor for the integer path's.
+inline double mandelbulb_reference(const glm::dvec3 pos, const double power, const int iterations, const double escape_radius, double& orbit_trap_dist) {
+	double x = pos.x;
+	double y = pos.y;
+	double z = pos.z;
+	double dr = 1.0;
+	double r = 0.0;
+
+	for (int i = 0; i < iterations; i++) {
+		r = std::sqrt(x * x + y * y + z * z);
+		if (r > escape_radius) break;
+
+		orbit_trap_dist = std::min(orbit_trap_dist, r - 0.5);
+
+		const double theta = std::acos(z / r) * power;
+		const double phi = std::atan2(y, x) * power;
+		dr = std::pow(r, power - 1.0) * power * dr + 1.0;
+
+		const double zr = std::pow(r, power);
+		x = zr * std::sin(theta) * std::cos(phi) + pos.x;
+		y = zr * std::sin(phi) * std::sin(theta) + pos.y;
+		z = zr * std::cos(theta) + pos.z;
+	}
+	return 0.5 * std::log(r) * r / dr;
+}
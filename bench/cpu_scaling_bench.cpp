@@ -0,0 +1,98 @@
+// Thread scaling of the CPU renderer. Renders the default view on 1, 2, 4, ... threads up to every
+// core and reports the frame time, the speedup and parallel efficiency over one thread, and how
+// busy the threads were. The first frame at each thread count plans its tiles by pixel count and
+// the following ones by the render times of the frame before, so both are shown. Per-thread
+// statistics of the last frame are printed for the highest thread count.
+//
+// Usage: cloven_cpu_bench [width height [frames]]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "app_settings.h"
+#include "camera.h"
+#include "cpu_renderer.h"
+#include "gradient_editor.h"
+
+namespace {
+
+constexpr int default_bench_width = 640;
+constexpr int default_bench_height = 360;
+constexpr int default_frames = 5;
+
+struct Measurement {
+	double first_seconds = 0.0;
+	// Fastest of the frames planned from the previous frame's costs
+	double seconds = 0.0;
+	CpuRenderStats stats;
+};
+
+Measurement measure(const unsigned int thread_count, const AppSettings& settings, const Camera& camera,
+	const std::vector<unsigned char>& gradient, const int width, const int height, const int frames) {
+	CpuRenderer renderer(thread_count);
+	Measurement measurement;
+	measurement.seconds = 1e30;
+	for (int frame = 0; frame < frames; frame++) {
+		(void)renderer.render(settings, camera, gradient, width, height);
+		const CpuRenderStats& stats = renderer.stats();
+		if (frame == 0) {
+			measurement.first_seconds = stats.seconds;
+		} else if (stats.seconds < measurement.seconds) {
+			measurement.seconds = stats.seconds;
+			measurement.stats = stats;
+		}
+	}
+	return measurement;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	const int width = argc > 2 ? std::atoi(argv[1]) : default_bench_width;
+	const int height = argc > 2 ? std::atoi(argv[2]) : default_bench_height;
+	const int frames = argc > 3 ? std::atoi(argv[3]) : default_frames;
+	if (width <= 0 || height <= 0 || frames < 2) {
+		fprintf(stderr, "Usage: %s [width height [frames]], with at least 2 frames\n", argv[0]);
+		return 1;
+	}
+
+	const AppSettings settings;
+	const Camera camera;
+	const GradientEditor gradient_editor;
+	const std::vector<unsigned char> gradient = gradient_editor.generate_gradient(settings.gradient_lut_size);
+
+	const unsigned int core_count = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<unsigned int> thread_counts;
+	for (unsigned int threads = 1; threads < core_count; threads *= 2) {
+		thread_counts.push_back(threads);
+	}
+	thread_counts.push_back(core_count);
+
+	printf("%dx%d, %d frames per thread count, %u cores\n\n", width, height, frames, core_count);
+	printf("%7s %10s %10s %8s %10s %9s %9s %7s %7s\n", "Threads", "First ms", "Best ms", "Speedup", "Efficiency", "Mean busy", "Min busy", "Tiles", "Stolen");
+
+	double single_thread_seconds = 0.0;
+	Measurement last;
+	for (const unsigned int threads : thread_counts) {
+		last = measure(threads, settings, camera, gradient, width, height, frames);
+		if (threads == 1) {
+			single_thread_seconds = last.seconds;
+		}
+		const double speedup = single_thread_seconds / std::max(last.seconds, 1e-12);
+		printf("%7u %10.2f %10.2f %8.2f %9.1f%% %8.1f%% %8.1f%% %7d %7d\n", threads, last.first_seconds * 1e3, last.seconds * 1e3,
+			speedup, 100.0 * speedup / threads, 100.0 * last.stats.mean_utilization, 100.0 * last.stats.min_utilization,
+			last.stats.tile_count, last.stats.stolen_tiles);
+	}
+
+	printf("\nThreads of the best frame on %u threads\n", thread_counts.back());
+	printf("%7s %10s %9s %7s %7s %7s\n", "Thread", "Busy ms", "Busy", "Tiles", "Stolen", "Steals");
+	for (size_t thread = 0; thread < last.stats.threads.size(); thread++) {
+		const TileWorkerStats& stats = last.stats.threads[thread];
+		printf("%7zu %10.2f %8.1f%% %7d %7d %7d\n", thread, stats.busy_seconds * 1e3, 100.0 * stats.utilization,
+			stats.tiles, stats.stolen_tiles, stats.steals);
+	}
+	return 0;
+}
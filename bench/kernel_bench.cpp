@@ -0,0 +1,168 @@
+// Side-by-side timing of the generic and integer-power Mandelbulb distance estimators at every
+// available SIMD level, and the error of the integer-power path against the generic formula.
+//
+// Usage: cloven_kernel_bench [iterations]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstddef>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "app_settings.h"
+#include "bench_common.h"
+#include "mandelbulb.h"
+#include "mandelbulb_simd.h"
+
+namespace {
+
+constexpr int surface_point_count = 1 << 14;
+constexpr int uniform_point_count = 1 << 14;
+constexpr int timing_runs = 5;
+// Relative errors are measured against at least this distance so points on the surface do not dominate.
+constexpr float min_relative_dist = 1e-4f;
+
+struct ErrorStats {
+	double max_abs = 0.0;
+	double p99_abs = 0.0;
+	double mean_abs = 0.0;
+	double max_relative = 0.0;
+	double max_trap_abs = 0.0;
+	int non_finite = 0;
+};
+
+PointSet uniform_points(std::mt19937& rng) {
+	std::uniform_real_distribution<float> uniform(-1.5f, 1.5f);
+	PointSet points;
+	for (int i = 0; i < uniform_point_count; i++) {
+		points.add(glm::vec3(uniform(rng), uniform(rng), uniform(rng)));
+	}
+	return points;
+}
+
+// Returns the fastest of timing_runs evaluations of all points in nanoseconds per point.
+double time_batch(const PointSet& points, const MandelbulbParams& params, std::vector<float>& dist, std::vector<float>& trap) {
+	double best_seconds = 1e30;
+	for (int run = 0; run < timing_runs; run++) {
+		const auto start = std::chrono::steady_clock::now();
+		mandelbulb_batch(points.x.data(), points.y.data(), points.z.data(), points.size(), params, dist.data(), trap.data());
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		best_seconds = std::min(best_seconds, elapsed.count());
+	}
+	return best_seconds * 1e9 / points.size();
+}
+
+// Distances and orbit trap distances of every point, in the same order.
+struct Evaluation {
+	std::vector<double> dist;
+	std::vector<double> trap;
+};
+
+template <typename Function>
+Evaluation evaluate(const PointSet& points, Function function) {
+	Evaluation evaluation;
+	for (int i = 0; i < points.size(); i++) {
+		double trap = 1e20;
+		evaluation.dist.push_back(function(points.get(i), trap));
+		evaluation.trap.push_back(trap);
+	}
+	return evaluation;
+}
+
+ErrorStats measure_error(const Evaluation& result, const Evaluation& expected) {
+	ErrorStats stats;
+	std::vector<double> abs_errors;
+	for (size_t i = 0; i < expected.dist.size(); i++) {
+		if (!std::isfinite(expected.dist[i])) continue;
+		if (!std::isfinite(result.dist[i])) {
+			stats.non_finite++;
+			continue;
+		}
+
+		const double abs_error = std::abs(result.dist[i] - expected.dist[i]);
+		abs_errors.push_back(abs_error);
+		stats.max_abs = std::max(stats.max_abs, abs_error);
+		stats.mean_abs += abs_error;
+		stats.max_relative = std::max(stats.max_relative, abs_error / std::max(std::abs(expected.dist[i]), static_cast<double>(min_relative_dist)));
+		stats.max_trap_abs = std::max(stats.max_trap_abs, std::abs(result.trap[i] - expected.trap[i]));
+	}
+	if (!abs_errors.empty()) {
+		stats.mean_abs /= static_cast<double>(abs_errors.size());
+		const auto p99 = abs_errors.begin() + static_cast<std::ptrdiff_t>(abs_errors.size() * 99 / 100);
+		std::nth_element(abs_errors.begin(), p99, abs_errors.end());
+		stats.p99_abs = *p99;
+	}
+	return stats;
+}
+
+void print_error(const char* name, const ErrorStats& stats) {
+	printf("  %-30s max %9.3g  p99 %9.3g  mean %9.3g  max rel %9.3g  trap max %9.3g  non-finite %d\n",
+		name, stats.max_abs, stats.p99_abs, stats.mean_abs, stats.max_relative, stats.max_trap_abs, stats.non_finite);
+}
+
+void report_error(const char* set_name, const PointSet& points, const MandelbulbParams& params) {
+	const Evaluation generic = evaluate(points, [&](const glm::vec3 pos, double& trap) {
+		float trap_float = 1e20f;
+		const float dist = mandelbulb(pos, params.power, params.iterations, params.escape_radius, trap_float);
+		trap = trap_float;
+		return static_cast<double>(dist);
+	});
+	const Evaluation integer = evaluate(points, [&](const glm::vec3 pos, double& trap) {
+		float trap_float = 1e20f;
+		const float dist = mandelbulb_integer_power(pos, params.integer_power, params.iterations, params.escape_radius, trap_float);
+		trap = trap_float;
+		return static_cast<double>(dist);
+	});
+	const Evaluation reference = evaluate(points, [&](const glm::vec3 pos, double& trap) {
+		return mandelbulb_reference(glm::dvec3(pos), params.power, params.iterations, params.escape_radius, trap);
+	});
+
+	printf("  %s points:\n", set_name);
+	print_error("Integer vs generic", measure_error(integer, generic));
+	print_error("Integer vs double reference", measure_error(integer, reference));
+	print_error("Generic vs double reference", measure_error(generic, reference));
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	const int iterations = argc > 1 ? std::atoi(argv[1]) : default_max_iterations;
+	if (iterations <= 0) {
+		fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+		return 1;
+	}
+
+	const SimdLevel max_level = detect_simd_level();
+	std::mt19937 rng(1);
+	std::vector<float> dist(std::max(surface_point_count, uniform_point_count));
+	std::vector<float> trap(dist.size());
+
+	for (int power = min_integer_power; power <= 8; power++) {
+		const MandelbulbParams integer_params = make_mandelbulb_params(static_cast<float>(power), iterations, static_cast<float>(default_escape_radius));
+		MandelbulbParams generic_params = integer_params;
+		generic_params.integer_power = 0;
+
+		const PointSet surface = surface_points(generic_params, surface_point_count, rng);
+		const PointSet uniform = uniform_points(rng);
+
+		printf("Power %d, %d iterations\n", power, iterations);
+		printf("  %-13s %14s %14s %8s\n", "Level", "Generic ns/pt", "Integer ns/pt", "Speedup");
+		for (int level = 0; level <= static_cast<int>(max_level); level++) {
+			set_simd_level(static_cast<SimdLevel>(level));
+			const double generic_ns = time_batch(surface, generic_params, dist, trap);
+			const double integer_ns = time_batch(surface, integer_params, dist, trap);
+			printf("  %-13s %14.1f %14.1f %7.2fx\n", simd_level_name(get_simd_level()), generic_ns, integer_ns, generic_ns / integer_ns);
+		}
+
+		printf("  Distance estimate errors (scalar):\n");
+		report_error("Near-surface", surface, integer_params);
+		report_error("Uniform", uniform, integer_params);
+		printf("\n");
+	}
+	return 0;
+}
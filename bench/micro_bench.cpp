@@ -0,0 +1,261 @@
+// Microbenchmarks of the CPU-side functions that run every frame or every gradient edit: gradient
+// interpolation and baking across stop counts, the camera matrices, uniform submission through
+// Shader and UniformRing, and the CPU distance estimators at several iteration counts. Each result
+// is the fastest of a few runs in nanoseconds per operation, plus the heap allocations and bytes
+// allocated per operation, counted by replacing the global operator new. Setup outside the timed
+// loop, such as building a shader variant, is not counted.
+//
+// The uniform benchmarks need an OpenGL context and the shaders in a shaders directory; they are
+// skipped if no window can be created.
+//
+// Usage: cloven_micro_bench [iterations per run]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "app_settings.h"
+#include "bench_common.h"
+#include "camera.h"
+#include "gradient_editor.h"
+#include "mandelbulb.h"
+#include "mandelbulb_simd.h"
+#include "render_params.h"
+#include "shader.h"
+#include "uniform_ring.h"
+#include "window.h"
+
+namespace {
+
+std::atomic<unsigned long long> allocation_count = 0;
+std::atomic<unsigned long long> allocation_bytes = 0;
+
+}
+
+void* operator new(const std::size_t size) {
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+	if (void* pointer = std::malloc(size != 0 ? size : 1)) {
+		return pointer;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+	std::free(pointer);
+}
+
+namespace {
+
+constexpr int default_operations = 100000;
+constexpr int timing_runs = 5;
+constexpr int stop_counts[] = {2, 8, 32, 128};
+constexpr int iteration_counts[] = {5, 10, 25, 50};
+constexpr int point_count = 1024;
+
+// Keeps results observable so the measured calls are not optimized away
+volatile float sink;
+
+struct Measurement {
+	double ns_per_op = 0.0;
+	double allocations_per_op = 0.0;
+	double bytes_per_op = 0.0;
+};
+
+// Runs function(i) for i in [0, operations) once to warm up, then timing_runs times. Allocations
+// are those of the last run.
+template <typename Function>
+Measurement measure(const int operations, Function function) {
+	for (int i = 0; i < operations; i++) {
+		function(i);
+	}
+
+	Measurement result;
+	double best_seconds = 1e30;
+	for (int run = 0; run < timing_runs; run++) {
+		const unsigned long long count_before = allocation_count.load(std::memory_order_relaxed);
+		const unsigned long long bytes_before = allocation_bytes.load(std::memory_order_relaxed);
+		const auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < operations; i++) {
+			function(i);
+		}
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		best_seconds = std::min(best_seconds, elapsed.count());
+		result.allocations_per_op = static_cast<double>(allocation_count.load(std::memory_order_relaxed) - count_before) / operations;
+		result.bytes_per_op = static_cast<double>(allocation_bytes.load(std::memory_order_relaxed) - bytes_before) / operations;
+	}
+	result.ns_per_op = best_seconds * 1e9 / operations;
+	return result;
+}
+
+void print_header(const char* group) {
+	printf("\n%-56s %12s %10s %10s\n", group, "ns/op", "allocs/op", "bytes/op");
+}
+
+void print_result(const std::string& name, const Measurement& measurement) {
+	printf("  %-54s %12.1f %10.2f %10.1f\n", name.c_str(), measurement.ns_per_op, measurement.allocations_per_op, measurement.bytes_per_op);
+}
+
+std::vector<ColorStop> random_stops(const int count, std::mt19937& rng) {
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<ColorStop> stops;
+	for (int i = 0; i < count; i++) {
+		stops.emplace_back(unit(rng), ImVec4(unit(rng), unit(rng), unit(rng), 1.0f));
+	}
+	return stops;
+}
+
+void bench_gradient(const int operations, std::mt19937& rng) {
+	print_header("Gradient");
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<float> positions(point_count);
+	for (float& position : positions) {
+		position = unit(rng);
+	}
+
+	for (const int stop_count : stop_counts) {
+		const std::vector<ColorStop> stops = random_stops(stop_count, rng);
+		GradientEditor editor;
+		editor.set_stops(stops);
+		const std::string suffix = " (" + std::to_string(stop_count) + " stops)";
+
+		print_result("interpolate" + suffix, measure(operations, [&](const int i) {
+			sink = editor.interpolate(positions[i % point_count]).x;
+		}));
+		// Baking is cached per version, so the cached case is what every frame pays
+		print_result("generate_gradient, cached" + suffix, measure(operations, [&](const int) {
+			sink = editor.generate_gradient(default_gradient_lut_size)[0];
+		}));
+		print_result("set_stops + bake" + suffix, measure(operations / 100 + 1, [&](const int) {
+			editor.set_stops(stops);
+			sink = editor.bake(default_gradient_lut_size)[0];
+		}));
+	}
+}
+
+void bench_camera(const int operations) {
+	print_header("Camera");
+	Camera camera;
+	const glm::mat4 projection_matrix = glm::perspective(glm::radians(camera.zoom), 16.0f / 9.0f, 0.1f, 100.0f);
+
+	print_result("view_matrix", measure(operations, [&](const int i) {
+		camera.position.x = static_cast<float>(i & 1) * 1e-3f;
+		sink = camera.view_matrix()[3][0];
+	}));
+	// What the renderer computes for the view of each frame
+	print_result("view_matrix + 2 inverses", measure(operations, [&](const int i) {
+		camera.position.x = static_cast<float>(i & 1) * 1e-3f;
+		const glm::mat4 inverse_view_matrix = glm::inverse(camera.view_matrix());
+		const glm::mat4 inverse_projection_matrix = glm::inverse(projection_matrix);
+		sink = inverse_view_matrix[3][0] + inverse_projection_matrix[0][0];
+	}));
+}
+
+void bench_distance_estimator(const int operations, std::mt19937& rng) {
+	print_header("Distance estimator");
+	for (const int iterations : iteration_counts) {
+		const MandelbulbParams params = make_mandelbulb_params(default_power, iterations, static_cast<float>(default_escape_radius));
+		const MandelbulbParams generic_params = make_mandelbulb_params(7.5f, iterations, static_cast<float>(default_escape_radius));
+		const PointSet points = surface_points(params, point_count, rng);
+		std::vector<float> dist(point_count);
+		const std::string suffix = " (" + std::to_string(iterations) + " iterations)";
+		const int scalar_operations = std::max(operations / iterations, point_count);
+
+		print_result("mandelbulb, power 7.5" + suffix, measure(scalar_operations, [&](const int i) {
+			float trap = 1e20f;
+			sink = mandelbulb(points.get(i % point_count), generic_params.power, iterations, generic_params.escape_radius, trap);
+		}));
+		print_result("mandelbulb_integer_power, power 8" + suffix, measure(scalar_operations, [&](const int i) {
+			float trap = 1e20f;
+			sink = mandelbulb_integer_power(points.get(i % point_count), params.integer_power, iterations, params.escape_radius, trap);
+		}));
+		// One operation is one point of a batch
+		const Measurement batch = measure(std::max(scalar_operations / point_count, 1), [&](const int) {
+			mandelbulb_batch(points.x.data(), points.y.data(), points.z.data(), point_count, params, dist.data());
+			sink = dist[0];
+		});
+		print_result("mandelbulb_batch, power 8, per point" + suffix, {batch.ns_per_op / point_count, batch.allocations_per_op / point_count, batch.bytes_per_op / point_count});
+	}
+}
+
+void bench_uniforms(const int operations) {
+	print_header("Uniforms");
+	Window* window;
+	try {
+		window = new Window("cloven_micro_bench", 1, 1, false);
+	} catch (std::exception& e) {
+		printf("  skipped: %s\n", e.what());
+		return;
+	}
+	if (glewInit() != GLEW_OK) {
+		printf("  skipped: GLEW could not be initialized\n");
+		delete window;
+		return;
+	}
+
+	{
+		Shader shader("shaders/shader.vert", "shaders/shader.frag");
+		// The geometry pass variant of the default settings
+		const ShaderDefines defines = {{"GEOMETRY_PASS", 1}, {"INTEGER_POWER", 8}, {"BACKGROUND_TYPE", 0}, {"NORMAL_METHOD", 0}};
+		shader.bind(defines);
+		const glm::mat4 matrix(1.0f);
+
+		print_result("Shader::bind, built variant", measure(operations, [&](const int) {
+			shader.bind(defines);
+		}));
+		// The uniforms set for the view of each pass
+		print_result("Shader::set_uniform_*, view uniforms", measure(operations, [&](const int i) {
+			shader.set_uniform_mat4("u_inverse_view_matrix", matrix);
+			shader.set_uniform_mat4("u_inverse_projection_matrix", matrix);
+			shader.set_uniform_2f("u_resolution", default_width, default_height);
+			shader.set_uniform_vec3("u_camera_pos", glm::vec3(static_cast<float>(i)));
+		}));
+
+		UniformRing ring(render_params_binding, sizeof(RenderParams));
+		AppSettings settings;
+		RenderParams params = make_render_params(settings);
+		print_result("UniformRing::update, unchanged", measure(operations, [&](const int) {
+			sink = ring.update(&params) ? 1.0f : 0.0f;
+		}));
+		print_result("UniformRing::update, changed", measure(operations / 10 + 1, [&](const int i) {
+			settings.power = default_power + static_cast<float>(i & 1);
+			params = make_render_params(settings);
+			sink = ring.update(&params) ? 1.0f : 0.0f;
+		}));
+		glFinish();
+	}
+	delete window;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	const int operations = argc > 1 ? std::atoi(argv[1]) : default_operations;
+	if (operations <= 0) {
+		fprintf(stderr, "Usage: %s [iterations per run]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%d operations per run, fastest of %d runs, %s\n", operations, timing_runs, simd_level_name(get_simd_level()));
+	std::mt19937 rng(1);
+	bench_gradient(operations, rng);
+	bench_camera(operations);
+	bench_distance_estimator(operations, rng);
+	bench_uniforms(operations);
+	return 0;
+}
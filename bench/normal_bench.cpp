@@ -0,0 +1,216 @@
+// Cost and accuracy of the surface normal methods of calculate_normal() in shaders/shader.frag:
+// central differences (6 distance estimates), tetrahedral differences (4) and the analytic
+// normal. Each method is timed per normal at surface points, the finite-difference methods also
+// batched as the CPU renderer evaluates them. Its angle is reported to the central-difference
+// normal the renderer used so far, and to the exact gradient of the distance estimate,
+// approximated with double-precision central differences over a much smaller step. The surface
+// has detail at every scale, so with many iterations the finite-difference normals are smoothed
+// versions of the exact one.
+//
+// Usage: cloven_normal_bench [iterations]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "app_settings.h"
+#include "bench_common.h"
+#include "mandelbulb.h"
+#include "mandelbulb_simd.h"
+
+namespace {
+
+constexpr int point_count = 1 << 13;
+constexpr int timing_runs = 5;
+constexpr float powers[] = {3.0f, 8.0f, 7.5f};
+constexpr double exact_epsilon = 1e-7;
+
+struct NormalMethod {
+	int method;
+	const char* name;
+};
+
+constexpr NormalMethod normal_methods[] = {
+	{normal_method_central_differences, "Central differences"},
+	{normal_method_tetrahedral, "Tetrahedral"},
+	{normal_method_analytic, "Analytic"}
+};
+
+struct AngleStats {
+	double max = 0.0;
+	double p99 = 0.0;
+	double mean = 0.0;
+	int non_finite = 0;
+};
+
+// The distance estimate the shader marches with for these parameters.
+float distance_estimate(const glm::vec3 pos, const MandelbulbParams& params) {
+	float trap = 1e20f;
+	return params.integer_power > 0
+		? mandelbulb_integer_power(pos, params.integer_power, params.iterations, params.escape_radius, trap)
+		: mandelbulb(pos, params.power, params.iterations, params.escape_radius, trap);
+}
+
+glm::vec3 normal(const glm::vec3 pos, const MandelbulbParams& params, const int method) {
+	if (method == normal_method_analytic) {
+		return mandelbulb_analytic_normal(pos, params.power, params.iterations, params.escape_radius);
+	}
+	glm::vec3 sum(0.0f);
+	for (const glm::vec3 direction : normal_taps(method)) {
+		sum += direction * distance_estimate(pos + normal_epsilon * direction, params);
+	}
+	return glm::normalize(sum);
+}
+
+glm::vec3 exact_normal(const glm::vec3 pos, const MandelbulbParams& params) {
+	const auto dist = [&](const glm::dvec3 offset) {
+		double trap = 1e20;
+		return mandelbulb_reference(glm::dvec3(pos) + offset, params.power, params.iterations, params.escape_radius, trap);
+	};
+	const glm::dvec3 gradient(
+		dist(glm::dvec3(exact_epsilon, 0.0, 0.0)) - dist(glm::dvec3(-exact_epsilon, 0.0, 0.0)),
+		dist(glm::dvec3(0.0, exact_epsilon, 0.0)) - dist(glm::dvec3(0.0, -exact_epsilon, 0.0)),
+		dist(glm::dvec3(0.0, 0.0, exact_epsilon)) - dist(glm::dvec3(0.0, 0.0, -exact_epsilon)));
+	return glm::vec3(glm::normalize(gradient));
+}
+
+std::vector<glm::vec3> normals(const PointSet& points, const MandelbulbParams& params, const int method) {
+	std::vector<glm::vec3> result(points.size());
+	for (int i = 0; i < points.size(); i++) {
+		result[i] = normal(points.get(i), params, method);
+	}
+	return result;
+}
+
+// Returns the fastest of timing_runs runs in nanoseconds per normal.
+template <typename Function>
+double time_per_normal(const int count, Function function) {
+	double best_seconds = 1e30;
+	for (int run = 0; run < timing_runs; run++) {
+		const auto start = std::chrono::steady_clock::now();
+		function();
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		best_seconds = std::min(best_seconds, elapsed.count());
+	}
+	return best_seconds * 1e9 / count;
+}
+
+// Evaluates every tap of every point with one mandelbulb_batch() call, like the CPU renderer.
+void batched_normals(const PointSet& points, const MandelbulbParams& params, const std::span<const glm::vec3> taps, PointSet& tap_points, std::vector<float>& dist, std::vector<glm::vec3>& result) {
+	const size_t tap_count = taps.size();
+	for (int i = 0; i < points.size(); i++) {
+		for (size_t tap = 0; tap < tap_count; tap++) {
+			const glm::vec3 pos = points.get(i) + normal_epsilon * taps[tap];
+			tap_points.x[i * tap_count + tap] = pos.x;
+			tap_points.y[i * tap_count + tap] = pos.y;
+			tap_points.z[i * tap_count + tap] = pos.z;
+		}
+	}
+	mandelbulb_batch(tap_points.x.data(), tap_points.y.data(), tap_points.z.data(), points.size() * static_cast<int>(tap_count), params, dist.data());
+
+	for (int i = 0; i < points.size(); i++) {
+		glm::vec3 sum(0.0f);
+		for (size_t tap = 0; tap < tap_count; tap++) {
+			sum += taps[tap] * dist[i * tap_count + tap];
+		}
+		result[i] = glm::normalize(sum);
+	}
+}
+
+AngleStats measure_angles(const std::vector<glm::vec3>& result, const std::vector<glm::vec3>& expected) {
+	AngleStats stats;
+	std::vector<double> angles;
+	for (size_t i = 0; i < expected.size(); i++) {
+		const glm::vec3 a = result[i];
+		const glm::vec3 b = expected[i];
+		if (!std::isfinite(b.x) || !std::isfinite(b.y) || !std::isfinite(b.z)) continue;
+		if (!std::isfinite(a.x) || !std::isfinite(a.y) || !std::isfinite(a.z)) {
+			stats.non_finite++;
+			continue;
+		}
+
+		// More accurate than the arc cosine of the dot product for small angles
+		const glm::dvec3 da(a);
+		const glm::dvec3 db(b);
+		const double angle = std::atan2(glm::length(glm::cross(da, db)), glm::dot(da, db)) * 180.0 / 3.14159265358979323846;
+		angles.push_back(angle);
+		stats.max = std::max(stats.max, angle);
+		stats.mean += angle;
+	}
+	if (!angles.empty()) {
+		stats.mean /= static_cast<double>(angles.size());
+		const auto p99 = angles.begin() + static_cast<std::ptrdiff_t>(angles.size() * 99 / 100);
+		std::nth_element(angles.begin(), p99, angles.end());
+		stats.p99 = *p99;
+	}
+	return stats;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	const int iterations = argc > 1 ? std::atoi(argv[1]) : default_max_iterations;
+	if (iterations <= 0) {
+		fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+		return 1;
+	}
+
+	std::mt19937 rng(1);
+	for (const float power : powers) {
+		const MandelbulbParams params = make_mandelbulb_params(power, iterations, static_cast<float>(default_escape_radius));
+		const PointSet points = surface_points(params, point_count, rng);
+		const std::vector<glm::vec3> central = normals(points, params, normal_method_central_differences);
+		std::vector<glm::vec3> exact(points.size());
+		for (int i = 0; i < points.size(); i++) {
+			exact[i] = exact_normal(points.get(i), params);
+		}
+
+		PointSet tap_points;
+		for (int i = 0; i < points.size() * 6; i++) {
+			tap_points.add(glm::vec3(0.0f));
+		}
+		std::vector<float> dist(tap_points.size());
+		std::vector<glm::vec3> result(points.size());
+
+		printf("Power %g (%s formula), %d iterations, %s\n", power, params.integer_power > 0 ? "integer" : "generic", iterations, simd_level_name(get_simd_level()));
+		printf("  %-20s %4s %10s %10s   %-26s   %-26s\n", "", "", "", "", "Degrees to central diff.", "Degrees to exact");
+		printf("  %-20s %4s %10s %10s %8s %8s %8s %8s %8s %8s\n", "Method", "DEs", "ns/normal", "batched", "mean", "p99", "max", "mean", "p99", "max");
+		for (const NormalMethod& method : normal_methods) {
+			const std::span<const glm::vec3> taps = normal_taps(method.method);
+			const double scalar_ns = time_per_normal(points.size(), [&] {
+				result = normals(points, params, method.method);
+			});
+			const AngleStats to_central = measure_angles(result, central);
+			const AngleStats to_exact = measure_angles(result, exact);
+
+			char batched[32] = "-";
+			if (!taps.empty()) {
+				const double batched_ns = time_per_normal(points.size(), [&] {
+					batched_normals(points, params, taps, tap_points, dist, result);
+				});
+				snprintf(batched, sizeof(batched), "%.1f", batched_ns);
+			}
+
+			char evaluations[24] = "1*";
+			if (!taps.empty()) {
+				snprintf(evaluations, sizeof(evaluations), "%zu", taps.size());
+			}
+			printf("  %-20s %4s %10.1f %10s %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f", method.name, evaluations, scalar_ns, batched,
+				to_central.mean, to_central.p99, to_central.max, to_exact.mean, to_exact.p99, to_exact.max);
+			if (to_exact.non_finite > 0) {
+				printf("  (%d non-finite)", to_exact.non_finite);
+			}
+			printf("\n");
+		}
+		printf("  * one evaluation on dual numbers\n\n");
+	}
+	return 0;
+}
@@ -0,0 +1,582 @@
+// Rendering benchmark: renders a fixed set of scenes offscreen at fixed resolutions with the GPU
+// renderer and reports the median and 95th percentile GPU time per frame, pixels per second and
+// the mean number of ray march steps per pixel. Frames are timed with GL_TIME_ELAPSED queries
+// around both passes after a few warm-up frames, which also build the shader variants. Ray steps
+// are counted by the shader in frames built with COLLECT_STATS, at each resolution after the timed
+// frames so that the counters do not slow those down.
+//
+// First, each scene is rendered with the specialized shader variants and with the generic variant
+// that reads the feature switches from uniforms. For both it reports the frame time and the time
+// spent building the variants the scene needed first, which is what startup and a settings change
+// cost, and how many of those came from the program binary cache.
+//
+// The results are written as JSON. Given a baseline written by an earlier run, each scene and
+// resolution is compared against it, and the exit code is 2 if any median frame time regressed by
+// more than the threshold.
+//
+// Adaptive anti-aliasing is then compared against supersampling every pixel with the same extra
+// rays, which is the adaptive pass with no threshold and no budget. For each scene it reports
+// the frame times, the extra rays per frame of both and the PSNR of the image with and without
+// adaptive anti-aliasing against the supersampled one. The compute ray marcher is then compared
+// against the fragment geometry pass, by frame time and by the PSNR of its image against theirs.
+// Last, the baked noise volume is compared against evaluating the noise per pixel: by the frame
+// time each adds to a frame without noise, by the PSNR of the baked image against the analytic one,
+// and by the time to bake each volume resolution and its RMS interpolation error.
+//
+// Usage: cloven_bench [--frames n] [--output results.json] [--baseline baseline.json] [--threshold percent]
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "app_settings.h"
+#include "camera.h"
+#include "framebuffer.h"
+#include "gradient_editor.h"
+#include "noise_volume.h"
+#include "renderer.h"
+#include "window.h"
+
+namespace {
+
+constexpr int warmup_frames = 5;
+constexpr int default_frames = 30;
+constexpr double default_threshold = 5.0; // percent
+
+struct Scene {
+	const char* name;
+	glm::vec3 position;
+	float yaw;
+	float pitch;
+	float zoom;
+	void (*configure)(AppSettings& settings);
+};
+
+struct Resolution {
+	int width;
+	int height;
+};
+
+struct Result {
+	std::string scene;
+	int width = 0;
+	int height = 0;
+	double median_ms = 0.0;
+	double p95_ms = 0.0;
+	double pixels_per_second = 0.0;
+	double ray_steps_per_pixel = 0.0;
+};
+
+// 0.001 above the surface, looking down at it
+constexpr glm::vec3 deep_zoom_position(0.1234f, 0.0567f, 0.7674f);
+constexpr float deep_zoom_fov = 1.0f;
+constexpr float deep_zoom_epsilon = 0.000001f;
+
+// Camera poses plus settings presets, covering the cheap and the expensive paths of the shader
+const Scene scenes[] = {
+	{"full_bulb", glm::vec3(0.0f, 0.0f, 2.0f), Camera::default_yaw, 0.0f, Camera::default_zoom, [](AppSettings&) {}},
+	{"close_up", glm::vec3(0.35f, 0.45f, 0.95f), -110.0f, -25.0f, 50.0f, [](AppSettings& settings) {
+		settings.max_iterations = 40;
+	}},
+	{"heavy_shadows", glm::vec3(1.2f, 0.6f, 1.4f), -130.0f, -15.0f, Camera::default_zoom, [](AppSettings& settings) {
+		settings.light_pos = glm::vec3(-1.5f, 2.5f, 0.5f);
+		settings.shadow_softness = 64.0f;
+		settings.shadow_min_step_size = 0.001f;
+		settings.shadow_max_step_size = 0.02f;
+		settings.shadow_max_iterations = 512;
+	}},
+	{"dynamic_background", glm::vec3(0.0f, 0.0f, 2.0f), Camera::default_yaw, 0.0f, Camera::default_zoom, [](AppSettings& settings) {
+		settings.background_type = 1;
+	}},
+	// A view about 1/100000 of the bulb across, where a pixel is a quarter of the spacing of floats
+	// at the camera. The same view in each precision; the ray steps of all three are those of float.
+	{"deep_zoom_fp32", deep_zoom_position, Camera::default_yaw, 0.0f, deep_zoom_fov, [](AppSettings& settings) {
+		settings.epsilon = deep_zoom_epsilon;
+		settings.precision_mode = precision_fp32;
+	}},
+	{"deep_zoom_df64", deep_zoom_position, Camera::default_yaw, 0.0f, deep_zoom_fov, [](AppSettings& settings) {
+		settings.epsilon = deep_zoom_epsilon;
+		settings.precision_mode = precision_df64;
+	}},
+	{"deep_zoom_fp64", deep_zoom_position, Camera::default_yaw, 0.0f, deep_zoom_fov, [](AppSettings& settings) {
+		settings.epsilon = deep_zoom_epsilon;
+		settings.precision_mode = precision_fp64;
+	}}
+};
+
+constexpr Resolution resolutions[] = {
+	{640, 360},
+	{1280, 720},
+	{1920, 1080}
+};
+constexpr Resolution comparison_resolution = {1280, 720};
+
+Camera make_camera(const Scene& scene) {
+	Camera camera;
+	camera.position = scene.position;
+	camera.zoom = scene.zoom;
+	camera.set_orientation(scene.yaw, scene.pitch);
+	return camera;
+}
+
+double percentile(std::vector<double> values, const double fraction) {
+	std::sort(values.begin(), values.end());
+	const int index = std::clamp(static_cast<int>(std::ceil(fraction * static_cast<double>(values.size()))) - 1, 0, static_cast<int>(values.size()) - 1);
+	return values[index];
+}
+
+// GPU milliseconds of each of frame_count frames, waiting for every result so that frames do not overlap
+std::vector<double> time_frames(Renderer& renderer, const AppSettings& settings, const Camera& camera, const GradientEditor& gradient_editor,
+	const int width, const int height, const int frame_count, Framebuffer& gbuffer, Framebuffer& framebuffer) {
+	const float aspect_ratio = static_cast<float>(width) / static_cast<float>(height);
+	const glm::mat4 projection_matrix = glm::perspective(glm::radians(camera.zoom), aspect_ratio, 0.1f, 100.0f);
+
+	GLuint query = 0;
+	glGenQueries(1, &query);
+	std::vector<double> times;
+	for (int frame = 0; frame < warmup_frames + frame_count; frame++) {
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		renderer.render_offscreen(settings, camera, gradient_editor, projection_matrix, width, height, gbuffer, framebuffer);
+		glEndQuery(GL_TIME_ELAPSED);
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+		if (frame >= warmup_frames) {
+			times.push_back(static_cast<double>(elapsed) * 1e-6);
+		}
+	}
+	glDeleteQueries(1, &query);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	return times;
+}
+
+// Mean ray march steps per pixel that the shader counts in a frame of settings at resolution
+double count_ray_steps(Renderer& renderer, AppSettings settings, const Camera& camera, const GradientEditor& gradient_editor,
+	const Resolution& resolution, Framebuffer& gbuffer, Framebuffer& framebuffer) {
+	settings.collect_ray_stats = true;
+	// Every frame waits for the GPU, so the counters of each frame are read when the next begins
+	(void)time_frames(renderer, settings, camera, gradient_editor, resolution.width, resolution.height, 1, gbuffer, framebuffer);
+	const RayStats& stats = renderer.get_ray_stats();
+	return static_cast<double>(stats.march_steps) / static_cast<double>(std::max(stats.pixels, 1ull));
+}
+
+// Renders scene with specialized shader variants and with the generic variant, and prints a row of
+// the comparison.
+void compare_specialization(Renderer& renderer, const Scene& scene, const GradientEditor& gradient_editor, const int frame_count,
+	Framebuffer& gbuffer, Framebuffer& framebuffer) {
+	AppSettings settings;
+	scene.configure(settings);
+	const Camera camera = make_camera(scene);
+	const int width = comparison_resolution.width;
+	const int height = comparison_resolution.height;
+	const ShaderBuildStats start = renderer.get_shader_build_stats();
+
+	settings.specialize_shaders = true;
+	const double specialized_ms = percentile(time_frames(renderer, settings, camera, gradient_editor, width, height, frame_count, gbuffer, framebuffer), 0.5);
+	const ShaderBuildStats specialized = renderer.get_shader_build_stats();
+
+	settings.specialize_shaders = false;
+	const double generic_ms = percentile(time_frames(renderer, settings, camera, gradient_editor, width, height, frame_count, gbuffer, framebuffer), 0.5);
+	const ShaderBuildStats generic = renderer.get_shader_build_stats();
+
+	char cached[32];
+	snprintf(cached, sizeof(cached), "%d/%d", generic.cached_variant_count - start.cached_variant_count, generic.variant_count - start.variant_count);
+	printf("%-20s %14.3f %10.3f %8.2fx %14.1f %16.1f %7s\n", scene.name, specialized_ms, generic_ms, generic_ms / std::max(specialized_ms, 1e-9),
+		specialized.total_build_time - start.total_build_time, generic.total_build_time - specialized.total_build_time, cached);
+}
+
+std::vector<unsigned char> read_pixels(const Framebuffer& framebuffer) {
+	std::vector<unsigned char> pixels(static_cast<size_t>(framebuffer.get_width()) * framebuffer.get_height() * 4);
+	framebuffer.bind();
+	glReadPixels(0, 0, framebuffer.get_width(), framebuffer.get_height(), GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	return pixels;
+}
+
+// Peak signal-to-noise ratio of the RGB channels of image against reference, in decibels
+double psnr(const std::vector<unsigned char>& image, const std::vector<unsigned char>& reference) {
+	double squared_error = 0.0;
+	for (size_t i = 0; i < image.size(); i++) {
+		if (i % 4 == 3) continue;
+		const double difference = static_cast<double>(image[i]) - static_cast<double>(reference[i]);
+		squared_error += difference * difference;
+	}
+	const double mean = squared_error / (static_cast<double>(image.size()) * 0.75);
+	return mean > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mean) : std::numeric_limits<double>::infinity();
+}
+
+// Renders scene without anti-aliasing, with adaptive anti-aliasing and supersampled, and prints a row
+// of the comparison.
+void compare_anti_aliasing(Renderer& renderer, const Scene& scene, const GradientEditor& gradient_editor, const int frame_count,
+	Framebuffer& gbuffer, Framebuffer& framebuffer) {
+	AppSettings settings;
+	scene.configure(settings);
+	const Camera camera = make_camera(scene);
+	const int width = comparison_resolution.width;
+	const int height = comparison_resolution.height;
+
+	settings.adaptive_aa = false;
+	const double none_ms = percentile(time_frames(renderer, settings, camera, gradient_editor, width, height, frame_count, gbuffer, framebuffer), 0.5);
+	const std::vector<unsigned char> none = read_pixels(framebuffer);
+
+	settings.adaptive_aa = true;
+	const double adaptive_ms = percentile(time_frames(renderer, settings, camera, gradient_editor, width, height, frame_count, gbuffer, framebuffer), 0.5);
+	const std::vector<unsigned char> adaptive = read_pixels(framebuffer);
+	// Counted by an earlier frame of the same settings, whose counters arrived while the last ones rendered
+	const AdaptiveAaStats adaptive_stats = renderer.get_adaptive_aa_stats();
+
+	// Every pixel is stronger than a negative threshold
+	settings.aa_threshold = -1.0f;
+	settings.aa_ray_budget = std::numeric_limits<int>::max();
+	const double ssaa_ms = percentile(time_frames(renderer, settings, camera, gradient_editor, width, height, frame_count, gbuffer, framebuffer), 0.5);
+	const std::vector<unsigned char> ssaa = read_pixels(framebuffer);
+	const AdaptiveAaStats ssaa_stats = renderer.get_adaptive_aa_stats();
+
+	printf("%-20s %8.3f %10.3f %8.3f %12llu %12llu %6.1f%% %11.1f %11.1f\n", scene.name, none_ms, adaptive_ms, ssaa_ms,
+		adaptive_stats.extra_rays, ssaa_stats.extra_rays, 100.0 * static_cast<double>(adaptive_stats.extra_rays) / static_cast<double>(std::max(ssaa_stats.extra_rays, 1ull)),
+		psnr(none, ssaa), psnr(adaptive, ssaa));
+}
+
+// Renders scene with the fragment and the compute geometry pass, and prints a row of the comparison.
+void compare_compute_march(Renderer& renderer, const Scene& scene, const GradientEditor& gradient_editor, const int frame_count,
+	Framebuffer& gbuffer, Framebuffer& framebuffer) {
+	AppSettings settings;
+	scene.configure(settings);
+	const Camera camera = make_camera(scene);
+	const int width = comparison_resolution.width;
+	const int height = comparison_resolution.height;
+
+	settings.compute_march = false;
+	const double fragment_ms = percentile(time_frames(renderer, settings, camera, gradient_editor, width, height, frame_count, gbuffer, framebuffer), 0.5);
+	const std::vector<unsigned char> fragment = read_pixels(framebuffer);
+
+	settings.compute_march = true;
+	const double compute_ms = percentile(time_frames(renderer, settings, camera, gradient_editor, width, height, frame_count, gbuffer, framebuffer), 0.5);
+	const std::vector<unsigned char> compute = read_pixels(framebuffer);
+
+	printf("%-20s %11.3f %10.3f %8.2fx %8.1f\n", scene.name, fragment_ms, compute_ms, fragment_ms / std::max(compute_ms, 1e-9), psnr(compute, fragment));
+}
+
+// Renders scene without noise, with analytic noise and with the baked noise volume, and prints a
+// row of the comparison.
+void compare_noise_volume(Renderer& renderer, const Scene& scene, const GradientEditor& gradient_editor, const int frame_count,
+	Framebuffer& gbuffer, Framebuffer& framebuffer) {
+	AppSettings settings;
+	scene.configure(settings);
+	const Camera camera = make_camera(scene);
+	const int width = comparison_resolution.width;
+	const int height = comparison_resolution.height;
+
+	settings.apply_noise = false;
+	const double plain_ms = percentile(time_frames(renderer, settings, camera, gradient_editor, width, height, frame_count, gbuffer, framebuffer), 0.5);
+
+	settings.apply_noise = true;
+	settings.baked_noise = false;
+	const double analytic_ms = percentile(time_frames(renderer, settings, camera, gradient_editor, width, height, frame_count, gbuffer, framebuffer), 0.5);
+	const std::vector<unsigned char> analytic = read_pixels(framebuffer);
+
+	// The first warm-up frame waits for the bake
+	settings.baked_noise = true;
+	const double baked_ms = percentile(time_frames(renderer, settings, camera, gradient_editor, width, height, frame_count, gbuffer, framebuffer), 0.5);
+	const std::vector<unsigned char> baked = read_pixels(framebuffer);
+
+	printf("%-20s %8.3f %11.3f %8.3f %12.3f %10.3f %8.1f\n", scene.name, plain_ms, analytic_ms, baked_ms,
+		analytic_ms - plain_ms, baked_ms - plain_ms, psnr(baked, analytic));
+}
+
+// Trilinear interpolation of volume at p in noise space, as the texture unit filters it
+float sample_noise_volume(const NoiseVolume& volume, const glm::vec3 p) {
+	const int size = volume.resolution;
+	const glm::vec3 texel = p / noise_volume_period * static_cast<float>(size) - 0.5f;
+	const glm::vec3 base = glm::floor(texel);
+	const glm::vec3 t = texel - base;
+	float value = 0.0f;
+	for (int corner = 0; corner < 8; corner++) {
+		const glm::ivec3 offset((corner & 1) != 0, (corner & 2) != 0, (corner & 4) != 0);
+		const glm::ivec3 index = (glm::ivec3(base) + offset + size) % size;
+		const glm::vec3 weights = glm::mix(1.0f - t, t, glm::vec3(offset));
+		value += weights.x * weights.y * weights.z * volume.samples[(static_cast<size_t>(index.z) * size + index.y) * size + index.x];
+	}
+	return value;
+}
+
+// Bakes the noise volume at resolution and prints its bake time and the RMS difference between
+// its interpolated samples and the noise it was sampled from, at random points of a period.
+void measure_noise_volume(const int resolution) {
+	const std::atomic<bool> cancel = false;
+	NoiseVolume volume;
+	(void)bake_noise_volume(resolution, 0, cancel, volume);
+	constexpr int points = 100000;
+	unsigned int state = 12345;
+	const auto random = [&state] {
+		state = state * 1664525u + 1013904223u;
+		return static_cast<float>(state >> 8) / static_cast<float>(1u << 24);
+	};
+	double squared_error = 0.0;
+	for (int i = 0; i < points; i++) {
+		const glm::vec3 p = glm::vec3(random(), random(), random()) * noise_volume_period;
+		const double difference = sample_noise_volume(volume, p) - periodic_surface_noise(p);
+		squared_error += difference * difference;
+	}
+	printf("%10d %10.1f %10.2f %10.4f\n", resolution, volume.bake_time * 1e3,
+		static_cast<double>(volume.samples.size() * sizeof(GLhalf)) / (1024.0 * 1024.0), std::sqrt(squared_error / points));
+}
+
+bool write_results(const std::string& path, const std::string& device, const int frame_count, const std::vector<Result>& results) {
+	std::ofstream file(path);
+	if (!file) {
+		fprintf(stderr, "Error opening results file: %s\n", path.c_str());
+		return false;
+	}
+	file << "{\n  \"device\": \"";
+	for (const char c : device) {
+		if (c == '"' || c == '\\') file << '\\';
+		file << c;
+	}
+	file << "\",\n  \"frames\": " << frame_count << ",\n  \"results\": [\n";
+	for (size_t i = 0; i < results.size(); i++) {
+		const Result& result = results[i];
+		file << "    {\"scene\": \"" << result.scene << "\", \"width\": " << result.width << ", \"height\": " << result.height
+			<< ", \"median_ms\": " << result.median_ms << ", \"p95_ms\": " << result.p95_ms
+			<< ", \"pixels_per_second\": " << result.pixels_per_second << ", \"ray_steps_per_pixel\": " << result.ray_steps_per_pixel
+			<< "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	file << "  ]\n}\n";
+	if (!file) {
+		fprintf(stderr, "Error writing results file: %s\n", path.c_str());
+		return false;
+	}
+	return true;
+}
+
+// Value of "key" in a flat JSON object, as written by write_results()
+bool find_value(const std::string& object, const char* key, std::string& value) {
+	const std::string quoted_key = std::string("\"") + key + "\"";
+	size_t pos = object.find(quoted_key);
+	if (pos == std::string::npos) return false;
+	pos = object.find(':', pos + quoted_key.size());
+	if (pos == std::string::npos) return false;
+	pos = object.find_first_not_of(" \t\r\n", pos + 1);
+	if (pos == std::string::npos) return false;
+	if (object[pos] == '"') {
+		const size_t end = object.find('"', pos + 1);
+		if (end == std::string::npos) return false;
+		value = object.substr(pos + 1, end - pos - 1);
+	} else {
+		const size_t end = object.find_first_of(",}", pos);
+		value = object.substr(pos, end - pos);
+	}
+	return true;
+}
+
+bool read_baseline(const std::string& path, std::vector<Result>& baseline) {
+	std::ifstream file(path);
+	if (!file) {
+		fprintf(stderr, "Error opening baseline file: %s\n", path.c_str());
+		return false;
+	}
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+	const std::string text = buffer.str();
+
+	size_t pos = text.find("\"results\"");
+	while (pos != std::string::npos && (pos = text.find('{', pos)) != std::string::npos) {
+		const size_t end = text.find('}', pos);
+		if (end == std::string::npos) break;
+		const std::string object = text.substr(pos, end - pos + 1);
+		pos = end;
+
+		Result result;
+		std::string width, height, median;
+		if (!find_value(object, "scene", result.scene) || !find_value(object, "width", width)
+			|| !find_value(object, "height", height) || !find_value(object, "median_ms", median)) {
+			fprintf(stderr, "Error reading baseline file: %s\n", path.c_str());
+			return false;
+		}
+		result.width = std::atoi(width.c_str());
+		result.height = std::atoi(height.c_str());
+		result.median_ms = std::atof(median.c_str());
+		baseline.push_back(result);
+	}
+	return true;
+}
+
+// Prints the change of every result against the baseline and returns whether any regressed.
+bool compare(const std::vector<Result>& results, const std::vector<Result>& baseline, const double threshold) {
+	printf("\n%-20s %11s %12s %12s %9s\n", "Scene", "Resolution", "Baseline ms", "Median ms", "Change");
+	bool regressed = false;
+	for (const Result& result : results) {
+		const auto match = std::find_if(baseline.begin(), baseline.end(), [&](const Result& b) {
+			return b.scene == result.scene && b.width == result.width && b.height == result.height;
+		});
+		char resolution[32];
+		snprintf(resolution, sizeof(resolution), "%dx%d", result.width, result.height);
+		if (match == baseline.end() || match->median_ms <= 0.0) {
+			printf("%-20s %11s %12s %12.3f %9s\n", result.scene.c_str(), resolution, "-", result.median_ms, "new");
+			continue;
+		}
+		const double change = (result.median_ms / match->median_ms - 1.0) * 100.0;
+		const bool is_regression = change > threshold;
+		regressed |= is_regression;
+		printf("%-20s %11s %12.3f %12.3f %+8.1f%%%s\n", result.scene.c_str(), resolution, match->median_ms, result.median_ms, change, is_regression ? "  REGRESSION" : "");
+	}
+	return regressed;
+}
+
+void print_usage(const char* program) {
+	fprintf(stderr, "Usage: %s [--frames n] [--output results.json] [--baseline baseline.json] [--threshold percent]\n", program);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	int frame_count = default_frames;
+	std::string output_path = "cloven_bench.json";
+	std::string baseline_path;
+	double threshold = default_threshold;
+
+	for (int i = 1; i < argc; i++) {
+		const bool has_value = i + 1 < argc;
+		if (std::strcmp(argv[i], "--frames") == 0 && has_value) {
+			frame_count = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--output") == 0 && has_value) {
+			output_path = argv[++i];
+		} else if (std::strcmp(argv[i], "--baseline") == 0 && has_value) {
+			baseline_path = argv[++i];
+		} else if (std::strcmp(argv[i], "--threshold") == 0 && has_value) {
+			threshold = std::atof(argv[++i]);
+		} else {
+			print_usage(argv[0]);
+			return 1;
+		}
+	}
+	if (frame_count <= 0 || threshold < 0.0) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	std::vector<Result> baseline;
+	if (!baseline_path.empty() && !read_baseline(baseline_path, baseline)) {
+		return 1;
+	}
+
+	// The window is never shown, it only provides the OpenGL context
+	Window* window;
+	try {
+		window = new Window("cloven_bench", 1, 1, false);
+	} catch (std::exception& e) {
+		fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+	const GLenum glew_error = glewInit();
+	if (glew_error != GLEW_OK) {
+		fprintf(stderr, "Error: %s\n", glewGetErrorString(glew_error));
+		delete window;
+		return 1;
+	}
+
+	const std::string device = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+	printf("%s, %d frames per scene and resolution\n", device.c_str(), frame_count);
+
+	std::vector<Result> results;
+	{
+		Renderer renderer;
+		GradientEditor gradient_editor;
+		Framebuffer gbuffer = Renderer::make_gbuffer();
+		Framebuffer framebuffer({GL_RGBA8});
+
+		// Before the other tables, so that the scenes' variants are not built yet
+		printf("\nSpecialized shader variants at %dx%d against the generic variant\n", comparison_resolution.width, comparison_resolution.height);
+		printf("%-20s %14s %10s %9s %14s %16s %7s\n", "Scene", "Specialized ms", "Generic ms", "Speedup", "Spec. build ms", "Generic build ms", "Cached");
+		for (const Scene& scene : scenes) {
+			compare_specialization(renderer, scene, gradient_editor, frame_count, gbuffer, framebuffer);
+		}
+
+		printf("\n%-20s %11s %10s %10s %14s %12s\n", "Scene", "Resolution", "Median ms", "p95 ms", "Pixels/s", "Steps/pixel");
+		for (const Scene& scene : scenes) {
+			AppSettings settings;
+			scene.configure(settings);
+			const Camera camera = make_camera(scene);
+
+			for (const Resolution& resolution : resolutions) {
+				const std::vector<double> times = time_frames(renderer, settings, camera, gradient_editor,
+					resolution.width, resolution.height, frame_count, gbuffer, framebuffer);
+
+				Result result;
+				result.scene = scene.name;
+				result.width = resolution.width;
+				result.height = resolution.height;
+				result.median_ms = percentile(times, 0.5);
+				result.p95_ms = percentile(times, 0.95);
+				result.pixels_per_second = static_cast<double>(resolution.width) * resolution.height / std::max(result.median_ms * 1e-3, 1e-12);
+				result.ray_steps_per_pixel = count_ray_steps(renderer, settings, camera, gradient_editor, resolution, gbuffer, framebuffer);
+				results.push_back(result);
+
+				char size[32];
+				snprintf(size, sizeof(size), "%dx%d", result.width, result.height);
+				printf("%-20s %11s %10.3f %10.3f %14.0f %12.1f\n", scene.name, size, result.median_ms, result.p95_ms, result.pixels_per_second, result.ray_steps_per_pixel);
+			}
+		}
+
+		printf("\nAdaptive anti-aliasing at %dx%d, %d extra rays per edge pixel, against supersampling every pixel\n",
+			comparison_resolution.width, comparison_resolution.height, default_aa_samples);
+		printf("%-20s %8s %10s %8s %12s %12s %7s %11s %11s\n", "Scene", "No AA ms", "Adaptive ms", "SSAA ms",
+			"Extra rays", "SSAA rays", "Rays", "PSNR no AA", "PSNR adapt.");
+		for (const Scene& scene : scenes) {
+			AppSettings settings;
+			scene.configure(settings);
+			// Extended precision turns anti-aliasing off
+			if (settings.precision_mode == precision_df64 || settings.precision_mode == precision_fp64) {
+				continue;
+			}
+			compare_anti_aliasing(renderer, scene, gradient_editor, frame_count, gbuffer, framebuffer);
+		}
+
+		printf("\nCompute ray marcher at %dx%d against the fragment geometry pass\n", comparison_resolution.width, comparison_resolution.height);
+		printf("%-20s %11s %10s %9s %8s\n", "Scene", "Fragment ms", "Compute ms", "Speedup", "PSNR");
+		for (const Scene& scene : scenes) {
+			AppSettings settings;
+			scene.configure(settings);
+			// The compute pass marches in float only
+			if (settings.precision_mode == precision_df64 || settings.precision_mode == precision_fp64) {
+				continue;
+			}
+			compare_compute_march(renderer, scene, gradient_editor, frame_count, gbuffer, framebuffer);
+		}
+
+		printf("\nBaked noise volume at %dx%d against analytic noise, at the default volume resolution of %d\n",
+			comparison_resolution.width, comparison_resolution.height, default_noise_volume_resolution);
+		printf("%-20s %8s %11s %8s %12s %10s %8s\n", "Scene", "Plain ms", "Analytic ms", "Baked ms", "Analytic +ms", "Baked +ms", "PSNR");
+		for (const Scene& scene : scenes) {
+			compare_noise_volume(renderer, scene, gradient_editor, frame_count, gbuffer, framebuffer);
+		}
+		printf("\n%10s %10s %10s %10s\n", "Resolution", "Bake ms", "MB", "RMS error");
+		for (const int resolution : noise_volume_resolutions) {
+			measure_noise_volume(resolution);
+		}
+	}
+	delete window;
+
+	if (!write_results(output_path, device, frame_count, results)) {
+		return 1;
+	}
+	printf("\nWrote %s\n", output_path.c_str());
+
+	if (!baseline_path.empty() && compare(results, baseline, threshold)) {
+		printf("\nMedian frame time regressed by more than %.1f%% against %s\n", threshold, baseline_path.c_str());
+		return 2;
+	}
+	return 0;
+}
@@ -122,64 +122,469 @@ float snoise(vec3 v) {
 The rest of the GLSL shader code in this file is licensed under the GNU General Public License v3.0.
 */
 
-// Output
+// Passes. The geometry pass (GEOMETRY_PASS defined) marches the rays and writes what it found to
+// the G-buffer; the shading pass colors and lights every pixel from the G-buffer, so lighting and
+// coloring changes do not march the rays again. Adaptive anti-aliasing adds two passes after the
+// shading pass: the edge pass (AA_EDGE_PASS) finds the pixels whose depth, normal or color differ
+// from a neighbor's, and the resolve pass (AA_RESOLVE_PASS) marches and shades extra rays through
+// the strongest of them.
+// Compute variants of the geometry pass append shaders/march.comp, which writes the G-buffer images
+#ifdef COMPUTE_PASS
+#elif defined(GEOMETRY_PASS) || defined(RECONSTRUCT_PASS)
+layout(location = 0) out vec4 g_position; // xyz: last ray position, w: ray progress
+layout(location = 1) out vec4 g_normal; // xyz: surface normal, w: orbit trap distance
+layout(location = 2) out float g_miss; // 1 if the ray exceeded the max distance
+#elif defined(AA_EDGE_PASS)
+layout(location = 0) out float aa_edge; // Edge strength bin plus one, over 255; 0 if it is no edge
+#else
 out vec4 frag_color;
+#endif
 
 // Constants
 const int background_type_solid = 0;
 const int background_type_dynamic = 1;
 const int coloring_method_orbit_trap = 0;
 const int coloring_method_distance_based = 1;
+const int normal_method_central_differences = 0;
+const int normal_method_tetrahedral = 1;
+const int normal_method_analytic = 2;
 
 // Uniforms: General
 uniform vec3 u_resolution;
 uniform vec3 u_camera_pos;
-uniform bool u_enable_normal_visualization;
+uniform mat4 u_inverse_view_matrix;
+uniform mat4 u_inverse_projection_matrix;
+
+// Uniforms: Coloring
+uniform sampler2D u_gradient_texture;
+
+// Uniforms: G-buffer, read by the shading pass
+uniform sampler2D u_gbuffer_position;
+uniform sampler2D u_gbuffer_normal;
+uniform sampler2D u_gbuffer_miss;
 
 // Uniforms: Fractal
-uniform int u_max_iterations;
-uniform int u_escape_radius;
-uniform int u_step_limit;
-uniform float u_max_distance;
-uniform float u_power;
-uniform float u_epsilon;
-uniform float u_ray_hit_threshold;
 uniform dvec2 u_trapping_point_offset;
 
-// Uniforms: Coloring
-uniform int u_coloring_method;
-uniform int u_background_type;
-uniform vec3 u_background_color;
-uniform sampler1D u_gradient_texture;
-
-// Uniforms: Lighting
-uniform vec3 u_light_pos;
-uniform float u_light_power;
-uniform float u_noise_scale;
-uniform float u_noise_amplitude;
-uniform float u_ambient_strength;
-uniform float u_diffuse_strength;
-uniform float u_specular_strength;
-uniform float u_specular_shininess;
-uniform float u_shadow_softness;
-uniform float u_shadow_min_distance;
-uniform float u_shadow_min_step_size;
-uniform float u_shadow_max_step_size;
-uniform int u_shadow_max_iterations;
-uniform float u_bloom_intensity_factor;
-uniform vec3 u_bloom_color;
-uniform float u_light_radius;
-uniform vec3 u_light_color;
-uniform bool u_show_light;
-uniform bool u_apply_noise;
-uniform bool u_apply_blinn_phong;
-uniform bool u_apply_soft_shadow;
-uniform bool u_apply_bloom;
-uniform bool u_apply_ambient_occlusion;
+// Render settings, mirrored by RenderParams in render_params.h. The members are ordered so that
+// every vec3 starts on a 16-byte boundary and is followed by a scalar, which keeps the std140
+// layout identical to the C++ struct.
+layout(std140, binding = 0) uniform RenderParams {
+    vec3 u_background_color;
+    float u_max_distance;
+    vec3 u_light_pos;
+    float u_light_power;
+    vec3 u_bloom_color;
+    float u_light_radius;
+    vec3 u_light_color;
+    float u_power;
+
+    int u_max_iterations;
+    int u_escape_radius;
+    int u_step_limit;
+    float u_epsilon;
+    float u_ray_hit_threshold;
+    float u_noise_scale;
+    float u_noise_amplitude;
+    float u_ambient_strength;
+    float u_diffuse_strength;
+    float u_specular_strength;
+    float u_specular_shininess;
+    float u_shadow_softness;
+    float u_shadow_min_distance;
+    float u_shadow_min_step_size;
+    float u_shadow_max_step_size;
+    int u_shadow_max_iterations;
+    float u_bloom_intensity_factor;
+
+    // Feature switches, only read by the generic variant
+    int u_integer_power;
+    int u_coloring_method;
+    int u_background_type;
+    bool u_enable_normal_visualization;
+    bool u_show_light;
+    bool u_apply_noise;
+    bool u_apply_blinn_phong;
+    bool u_apply_soft_shadow;
+    bool u_apply_bloom;
+    bool u_apply_ambient_occlusion;
+    int u_normal_method;
+    bool u_enable_step_heatmap;
+    int u_heatmap_max_steps;
+    int u_precise_iterations;
+    float u_mandelbox_folding_limit;
+
+    vec4 u_julia_c;
+    float u_mandelbox_scale;
+    float u_mandelbox_min_radius;
+    float u_mandelbox_fixed_radius;
+};
+
+// Formula, from the registry in formula.h. Every variant is built with FORMULA defined to one of
+// these, so DE() only contains that formula. The values must match Formula in formula.h.
+#define formula_mandelbulb 0
+#define formula_mandelbox 1
+#define formula_menger_sponge 2
+#define formula_quaternion_julia 3
+#ifndef FORMULA
+#define FORMULA formula_mandelbulb
+#endif
+
+// Feature switches. Each variant of this shader is compiled with these #defined to constants (see
+// geometry_defines() and shading_defines() in renderer.cpp), which removes disabled features and
+// their branches at compile time. A switch without a #define falls back to its RenderParams member,
+// as in the generic variant.
+#ifdef ENABLE_NORMAL_VISUALIZATION
+#define enable_normal_visualization bool(ENABLE_NORMAL_VISUALIZATION)
+#else
+#define enable_normal_visualization u_enable_normal_visualization
+#endif
+#ifdef INTEGER_POWER
+#define integer_power int(INTEGER_POWER)
+#else
+#define integer_power u_integer_power
+#endif
+#ifdef COLORING_METHOD
+#define coloring_method int(COLORING_METHOD)
+#else
+#define coloring_method u_coloring_method
+#endif
+#ifdef BACKGROUND_TYPE
+#define background_type int(BACKGROUND_TYPE)
+#else
+#define background_type u_background_type
+#endif
+#ifdef SHOW_LIGHT
+#define show_light bool(SHOW_LIGHT)
+#else
+#define show_light u_show_light
+#endif
+#ifdef APPLY_NOISE
+#define apply_noise bool(APPLY_NOISE)
+#else
+#define apply_noise u_apply_noise
+#endif
+#ifdef APPLY_BLINN_PHONG
+#define apply_blinn_phong bool(APPLY_BLINN_PHONG)
+#else
+#define apply_blinn_phong u_apply_blinn_phong
+#endif
+#ifdef APPLY_SOFT_SHADOW
+#define apply_soft_shadow bool(APPLY_SOFT_SHADOW)
+#else
+#define apply_soft_shadow u_apply_soft_shadow
+#endif
+#ifdef APPLY_BLOOM
+#define apply_bloom bool(APPLY_BLOOM)
+#else
+#define apply_bloom u_apply_bloom
+#endif
+#ifdef APPLY_AMBIENT_OCCLUSION
+#define apply_ambient_occlusion bool(APPLY_AMBIENT_OCCLUSION)
+#else
+#define apply_ambient_occlusion u_apply_ambient_occlusion
+#endif
+#ifdef NORMAL_METHOD
+#define normal_method int(NORMAL_METHOD)
+#else
+#define normal_method u_normal_method
+#endif
+#ifdef ENABLE_STEP_HEATMAP
+#define enable_step_heatmap bool(ENABLE_STEP_HEATMAP)
+#else
+#define enable_step_heatmap u_enable_step_heatmap
+#endif
+
+// Ray statistics, read back by RayStatsBuffer in ray_stats.h. Variants built with COLLECT_STATS
+// count into these per fragment and add the counts at the end of each pass. Every counter exists
+// once per bucket, and neighboring fragments use different buckets, which spreads the atomics
+// over many addresses; the CPU sums the buckets.
+#ifdef COLLECT_STATS
+const int stats_bucket_count = 64;
+const int stats_counter_count = 6;
+const int stats_pixels = 0;
+const int stats_march_steps = 1;
+const int stats_shadow_steps = 2;
+const int stats_de_evaluations = 3;
+const int stats_misses = 4;
+const int stats_step_limit_hits = 5;
+
+layout(std430, binding = 1) buffer RayStats {
+    uint stats_counters[];
+};
+
+int stats_march_step_count = 0;
+int stats_shadow_step_count = 0;
+int stats_de_evaluation_count = 0;
+
+void add_stat(int counter, int value) {
+    if (value <= 0) return;
+    int bucket = (int(gl_FragCoord.x) & 7) + (int(gl_FragCoord.y) & 7) * 8;
+    atomicAdd(stats_counters[bucket * stats_counter_count + counter], uint(value));
+}
+#endif
+
+// Adaptive anti-aliasing, see AdaptiveAaBuffer in adaptive_aa.h. The edge pass counts the pixels
+// above the threshold in a histogram of their edge strength, and the resolve pass gives extra rays
+// to the strongest ones that fit into the budget of u_aa_max_pixels pixels.
+#if defined(AA_EDGE_PASS) || defined(AA_RESOLVE_PASS)
+const int aa_bin_count = 32;
+
+layout(std430, binding = 2) buffer AdaptiveAa {
+    uint aa_histogram[aa_bin_count];
+    uint aa_sampled_pixels;
+};
+
+uniform sampler2D u_aa_color; // Output of the shading pass
+uniform sampler2D u_aa_edges; // Output of the edge pass
+uniform float u_aa_threshold;
+uniform int u_aa_samples;
+uniform int u_aa_max_pixels;
+
+// Uniformly distributed in [0, 1), from a PCG hash of the pixel and seed
+float aa_random(ivec2 texel, uint seed) {
+    uint state = uint(texel.x) * 747796405u + uint(texel.y) * 2891336453u + seed * 277803737u;
+    state = state * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return float((word >> 22u) ^ word) * (1.0 / 4294967296.0);
+}
+#endif
+
+// Interleaved rendering. The geometry pass marches one pixel of every INTERLEAVE, into a G-buffer
+// of that fraction of the size, and the reconstruct pass fills in the others from the G-buffer of
+// the previous frame. A checkerboard (2) alternates the pixels of each row, and 2x2 interleaving
+// (4) rotates through the pixels of each 2x2 block, diagonal first.
+#if defined(INTERLEAVE) || defined(COMPUTE_PASS)
+uniform ivec2 u_frame_size; // Size of the full G-buffer
+
+// Ray direction of the vertex shader at a corner of the full screen quad
+vec3 quad_ray_direction(vec2 ndc) {
+    vec4 world_pos = u_inverse_view_matrix * (u_inverse_projection_matrix * vec4(ndc, 0.0, 1.0));
+    return normalize(world_pos.xyz / world_pos.w - u_inverse_view_matrix[3].xyz);
+}
+
+// v_ray_direction at position, in pixels, when the full frame is drawn, which the rasterizer
+// interpolates from the corners across the two triangles of the quad. Marching the same direction
+// lets other passes converge to the image of a full geometry pass.
+vec3 frame_ray_direction(vec2 position) {
+    vec2 ndc = position / vec2(u_frame_size) * 2.0 - 1.0;
+    if (ndc.x + ndc.y <= 0.0) {
+        vec3 corner = quad_ray_direction(vec2(-1.0, -1.0));
+        return corner + (quad_ray_direction(vec2(1.0, -1.0)) - corner) * (ndc.x + 1.0) * 0.5
+            + (quad_ray_direction(vec2(-1.0, 1.0)) - corner) * (ndc.y + 1.0) * 0.5;
+    }
+    vec3 corner = quad_ray_direction(vec2(1.0, 1.0));
+    return corner + (quad_ray_direction(vec2(-1.0, 1.0)) - corner) * (1.0 - ndc.x) * 0.5
+        + (quad_ray_direction(vec2(1.0, -1.0)) - corner) * (1.0 - ndc.y) * 0.5;
+}
+#endif
+
+#ifdef INTERLEAVE
+const ivec2 interleave_offsets[4] = ivec2[4](ivec2(0, 0), ivec2(1, 1), ivec2(1, 0), ivec2(0, 1));
+
+uniform int u_interleave_phase;
+
+// Pixel of the full frame that texel of the interleaved G-buffer marches
+ivec2 interleaved_pixel(ivec2 texel) {
+#if INTERLEAVE == 2
+    return ivec2(texel.x * 2 + ((texel.y + u_interleave_phase) & 1), texel.y);
+#else
+    return texel * 2 + interleave_offsets[u_interleave_phase];
+#endif
+}
+
+// Inverse of interleaved_pixel() for the pixels this phase marches
+ivec2 interleaved_texel(ivec2 pixel) {
+#if INTERLEAVE == 2
+    return ivec2(pixel.x / 2, pixel.y);
+#else
+    return pixel / 2;
+#endif
+}
+
+bool is_marched(ivec2 pixel) {
+#if INTERLEAVE == 2
+    return ((pixel.x + pixel.y + u_interleave_phase) & 1) == 0;
+#else
+    return (pixel & 1) == interleave_offsets[u_interleave_phase];
+#endif
+}
+#endif
+
+#ifdef RECONSTRUCT_PASS
+// The G-buffer of the previous frame, whose view projection_matrix * view_matrix is
+// u_history_view_projection. u_history_exact is set if that is the view of this frame, in which
+// case every pixel the history marched is exact.
+uniform sampler2D u_history_position;
+uniform sampler2D u_history_normal;
+uniform sampler2D u_history_miss;
+uniform mat4 u_history_view_projection;
+uniform int u_history_exact;
+#endif
+
+// Noise volume, baked by bake_noise_volume() in noise_volume.cpp. Variants built with BAKED_NOISE
+// sample the surface noise from it with trilinear filtering instead of evaluating both octaves of
+// snoise(). It holds one period of a tileable version of them and repeats through its wrap mode.
+// noise_volume_period must match the constant in noise_volume.h.
+#ifdef BAKED_NOISE
+const float noise_volume_period = 6.0;
+
+uniform sampler3D u_noise_volume;
+#endif
+
+// Distance volume, baked by bake_distance_volume() in distance_volume.cpp. Variants built with
+// DISTANCE_VOLUME march camera rays through it and only evaluate DE() outside of it and within
+// volume_exact_band voxels of the surface. The indirection texture has a texel per brick: its index
+// in the atlas, or -1 if it is away from the surface, and the distance estimate at its center. The
+// constants must match those in distance_volume.h.
+#if defined(GEOMETRY_PASS) && defined(DISTANCE_VOLUME)
+const float volume_extent = 2.0;
+const int volume_brick_size = 8;
+const int volume_atlas_bricks = 32;
+const float volume_exact_band = 3.0;
+
+uniform sampler3D u_volume_indirection;
+uniform sampler3D u_volume_atlas;
+
+// Distance to the surface from the volume, or -1 where DE() has to be evaluated
+float volume_distance(vec3 pos) {
+    int grid_size = textureSize(u_volume_indirection, 0).x;
+    float brick_edge = 2.0 * volume_extent / float(grid_size);
+    vec3 grid_pos = (pos + volume_extent) / brick_edge;
+    if (any(lessThan(grid_pos, vec3(0.0))) || any(greaterThanEqual(grid_pos, vec3(grid_size)))) return -1.0;
+
+    ivec3 brick = min(ivec3(grid_pos), ivec3(grid_size - 1));
+    vec2 entry = texelFetch(u_volume_indirection, brick, 0).rg;
+    if (entry.x < 0.0) {
+        // The estimate at the center, less the distance from it, bounds the distance in the brick
+        vec3 center = (vec3(brick) + 0.5) * brick_edge - volume_extent;
+        return entry.y - length(pos - center);
+    }
+
+    // Bricks hold a sample at every voxel corner, so filtering never reads a neighboring brick
+    int index = int(entry.x);
+    ivec3 atlas_brick = ivec3(index % volume_atlas_bricks, (index / volume_atlas_bricks) % volume_atlas_bricks, index / (volume_atlas_bricks * volume_atlas_bricks));
+    vec3 texel = vec3(atlas_brick * (volume_brick_size + 1)) + (grid_pos - vec3(brick)) * float(volume_brick_size) + 0.5;
+    float dist = texture(u_volume_atlas, texel / vec3(textureSize(u_volume_atlas, 0))).r;
+    return dist > volume_exact_band * brick_edge / float(volume_brick_size) ? dist : -1.0;
+}
+#endif
+
+// Extended precision for deep zooms. Variants built with PRECISION march from the camera position
+// given by u_camera_pos and u_camera_pos_low in more than float precision, and evaluate the first
+// u_precise_iterations iterations of whole-number powers in it. Those are where neighboring
+// pixels differ by less than a float resolves; later iterations have amplified the difference and
+// continue in float. PRECISION is precision_df64 for df64, pairs of floats whose unevaluated sum
+// carries 48 bits of mantissa, or precision_fp64 for doubles. The values must match PrecisionMode
+// in app_settings.h.
+#if defined(GEOMETRY_PASS) && defined(PRECISION)
+#define precision_df64 2
+#define precision_fp64 3
+
+uniform vec3 u_camera_pos_low;
+uniform float u_pixel_angle; // Angle between the rays of neighboring pixels
+
+#if PRECISION == precision_df64
+// Error-free transformations, which the compiler must neither reassociate nor contract
+vec2 df64_two_sum(float a, float b) {
+    precise float s = a + b;
+    precise float v = s - a;
+    precise float e = (a - (s - v)) + (b - v);
+    return vec2(s, e);
+}
+
+// df64_two_sum() for |a| >= |b|
+vec2 df64_quick_two_sum(float a, float b) {
+    precise float s = a + b;
+    precise float e = b - (s - a);
+    return vec2(s, e);
+}
+
+vec2 df64_two_prod(float a, float b) {
+    precise float p = a * b;
+    precise float e = fma(a, b, -p);
+    return vec2(p, e);
+}
+
+vec2 df64_add(vec2 a, vec2 b) {
+    precise vec2 s = df64_two_sum(a.x, b.x);
+    precise vec2 t = df64_two_sum(a.y, b.y);
+    s = df64_quick_two_sum(s.x, s.y + t.x);
+    return df64_quick_two_sum(s.x, s.y + t.y);
+}
+
+vec2 df64_mul(vec2 a, vec2 b) {
+    precise vec2 p = df64_two_prod(a.x, b.x);
+    p.y += a.x * b.y + a.y * b.x;
+    return df64_quick_two_sum(p.x, p.y);
+}
+
+// One correction of the float quotient
+vec2 df64_div(vec2 a, vec2 b) {
+    precise float q = a.x / b.x;
+    precise vec2 r = df64_add(a, -df64_mul(b, vec2(q, 0.0)));
+    return df64_quick_two_sum(q, r.x / b.x);
+}
+
+// One correction of the float root
+vec2 df64_sqrt(vec2 a) {
+    if (a.x <= 0.0) return vec2(0.0);
+    precise float x = inversesqrt(a.x);
+    precise float y = a.x * x;
+    precise vec2 r = df64_add(a, -df64_two_prod(y, y));
+    return df64_quick_two_sum(y, r.x * (x * 0.5));
+}
+
+#define real vec2
+#define real_from(x) vec2(x, 0.0)
+#define real_from_pair(high, low) vec2(high, low)
+#define real_to_float(a) (a).x
+#define real_add(a, b) df64_add(a, b)
+#define real_sub(a, b) df64_add(a, -(b))
+#define real_mul(a, b) df64_mul(a, b)
+#define real_div(a, b) df64_div(a, b)
+#define real_sqrt(a) df64_sqrt(a)
+#else
+#define real double
+#define real_from(x) double(x)
+#define real_from_pair(high, low) (double(high) + double(low))
+#define real_to_float(a) float(a)
+#define real_add(a, b) ((a) + (b))
+#define real_sub(a, b) ((a) - (b))
+#define real_mul(a, b) ((a) * (b))
+#define real_div(a, b) ((a) / (b))
+#define real_sqrt(a) sqrt(a)
+#endif
+
+struct real3 {
+    real x;
+    real y;
+    real z;
+};
+
+vec3 real3_to_vec3(real3 a) {
+    return vec3(real_to_float(a.x), real_to_float(a.y), real_to_float(a.z));
+}
+
+// pos plus offset along direction
+real3 real3_offset(real3 pos, real offset, vec3 direction) {
+    return real3(
+        real_add(pos.x, real_mul(offset, real_from(direction.x))),
+        real_add(pos.y, real_mul(offset, real_from(direction.y))),
+        real_add(pos.z, real_mul(offset, real_from(direction.z)))
+    );
+}
+
+// Last ray position of ray_march_precise() and the distance it counted as a hit
+real3 current_pos_precise;
+float precise_hit_distance;
+#endif
 
 // Input
+#ifndef COMPUTE_PASS
 in vec3 v_ray_origin;
 in vec3 v_ray_direction;
+#endif
 
 // Global Variables
 vec3 current_pos;
@@ -188,20 +593,31 @@ bool exceeded_max_distance = false;
 float orbit_trap_dist = 1e20;
 
 // Function Prototypes
-float sphere(vec3 pos, vec3 center, float radius);
 float mandelbulb(vec3 pos, float power, int iterations);
-float DE(vec3 pos, bool with_light);
+float mandelbulb_integer_power(vec3 pos, int power, int iterations);
+float mandelbox(vec3 pos, int iterations);
+float menger_sponge(vec3 pos, int iterations);
+float quaternion_julia(vec3 pos, int iterations);
+vec3 mandelbulb_analytic_normal(vec3 pos, float power, int iterations);
+float DE(vec3 pos);
+float march_distance(vec3 pos);
+bool march_step(vec3 ray_origin, vec3 ray_direction, int step_index, inout float depth, out vec3 pos);
 float ray_march(vec3 ray_origin, vec3 ray_direction);
 float soft_shadow(in vec3 ray_origin, float min_dist, float max_dist);
 vec3 calculate_normal(vec3 pos);
-vec3 blinn_phong(vec3 color, vec3 pos);
+vec3 blinn_phong(vec3 color, vec3 pos, vec3 normal);
+float light_intersection(vec3 ray_origin, vec3 ray_direction);
 vec3 orbit_trap(float dist);
+vec3 shade(vec3 ray_origin, vec3 ray_direction, float ray_progress, vec3 normal);
+#ifndef COMPUTE_PASS
+void geometry_pass();
+void reconstruct_pass();
+void shading_pass();
+void aa_edge_pass();
+void aa_resolve_pass();
+#endif
 void main();
 
-float sphere(vec3 pos, vec3 center, float radius) {
-    return length(pos - center) - radius;
-}
-
 float mandelbulb(vec3 pos, float power, int iterations) {
 	vec3 z = pos;
 	float dr = 1.0;
@@ -233,40 +649,437 @@ float mandelbulb(vec3 pos, float power, int iterations) {
 	return 0.5 * log(r) * r / dr;
 }
 
-float DE(vec3 pos, bool with_light) {
-    float fractal_dist = mandelbulb(pos, u_power, u_max_iterations);
+vec2 complex_mul(vec2 a, vec2 b) {
+    return vec2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+}
 
-    if (u_show_light && with_light) {
-        float light_dist = sphere(pos, u_light_pos, u_light_radius);
-        return min(fractal_dist, light_dist);
-    } else {
-        return fractal_dist;
+vec2 complex_pow(vec2 c, int n) {
+    vec2 result = vec2(1.0, 0.0);
+    for (; n > 0; n >>= 1) {
+        if ((n & 1) != 0) result = complex_mul(result, c);
+        c = complex_mul(c, c);
     }
+    return result;
 }
 
-float ray_march(vec3 ray_origin, vec3 ray_direction) {
-	vec3 pos;
-	float depth = 0.0;
-	int i;
+float integer_pow(float x, int n) {
+    float result = 1.0;
+    for (; n > 0; n >>= 1) {
+        if ((n & 1) != 0) result *= x;
+        x *= x;
+    }
+    return result;
+}
 
-	for (i = 0; i < u_step_limit; i++) {
-		pos = ray_origin + depth * ray_direction;
-		float dist = DE(pos, true);
-		depth += dist;
+// Same fractal as mandelbulb() for whole-number powers, without trigonometry. With
+// (cos(theta), sin(theta)) = (z, rho) / r and (cos(phi), sin(phi)) = (x, y) / rho,
+// the multiplied angles are the arguments of complex powers.
+float mandelbulb_integer_power(vec3 pos, int power, int iterations) {
+	vec3 z = pos;
+	float dr = 1.0;
+	float r = 0.0;
+    vec3 u_orbit_trap_center = vec3(0.0, 0.0, 0.0);
+    float u_orbit_trap_radius = 0.5;
+
+	for (int i = 0; i < iterations; i++) {
+		r = length(z);
+		if (r > u_escape_radius) break;
+
+        float dist_to_trap = length(z - u_orbit_trap_center) - u_orbit_trap_radius;
+        orbit_trap_dist = min(orbit_trap_dist, dist_to_trap);
+
+        float rho = length(z.xy);
+        vec2 theta = complex_pow(vec2(z.z, rho) / r, power);
+        vec2 phi = complex_pow(rho > 0.0 ? z.xy / rho : vec2(1.0, 0.0), power);
+
+        float r_power_minus_one = integer_pow(r, power - 1);
+		dr = r_power_minus_one * float(power) * dr + 1.0;
+
+		z = r_power_minus_one * r * vec3(
+            theta.y * phi.x,
+            theta.y * phi.y,
+            theta.x
+        ) + pos;
+	}
+	return 0.5 * log(r) * r / dr;
+}
+
+// Box fold, then sphere fold, then scale, which mandelbox_scale is the factor of. Orbits leave any
+// small radius and come back, so the escape radius is replaced by a fixed bailout.
+float mandelbox(vec3 pos, int iterations) {
+    const float bailout = 1024.0;
+    float min_radius2 = u_mandelbox_min_radius * u_mandelbox_min_radius;
+    float fixed_radius2 = u_mandelbox_fixed_radius * u_mandelbox_fixed_radius;
+    vec3 z = pos;
+    float dr = 1.0;
+    float u_orbit_trap_radius = 0.5;
+
+    for (int i = 0; i < iterations; i++) {
+        z = clamp(z, -u_mandelbox_folding_limit, u_mandelbox_folding_limit) * 2.0 - z;
+        float r2 = dot(z, z);
+        orbit_trap_dist = min(orbit_trap_dist, sqrt(r2) - u_orbit_trap_radius);
+        if (r2 < min_radius2) {
+            z *= fixed_radius2 / min_radius2;
+            dr *= fixed_radius2 / min_radius2;
+        } else if (r2 < fixed_radius2) {
+            z *= fixed_radius2 / r2;
+            dr *= fixed_radius2 / r2;
+        }
+
+        z = u_mandelbox_scale * z + pos;
+        dr = dr * abs(u_mandelbox_scale) + 1.0;
+        if (dot(z, z) > bailout * bailout) break;
+    }
+    return length(z) / abs(dr);
+}
+
+// Folds every octant and permutation onto x >= y >= z >= 0, then scales the corner cube of the 20
+// that remain up to the whole. The estimate is the distance to the cube from -1 to 1, scaled back.
+float menger_sponge(vec3 pos, int iterations) {
+    vec3 z = pos;
+    float scale = 1.0;
+    float u_orbit_trap_radius = 0.5;
+
+    for (int i = 0; i < iterations; i++) {
+        z = abs(z);
+        if (z.x < z.y) z.xy = z.yx;
+        if (z.x < z.z) z.xz = z.zx;
+        if (z.y < z.z) z.yz = z.zy;
+        z = z * 3.0 - 2.0;
+        if (z.z < -1.0) z.z += 2.0;
+        scale *= 3.0;
+        orbit_trap_dist = min(orbit_trap_dist, length(z) - u_orbit_trap_radius);
+    }
+
+    vec3 d = abs(z) - 1.0;
+    float box = min(max(d.x, max(d.y, d.z)), 0.0) + length(max(d, 0.0));
+    return box / scale;
+}
+
+// Slice w = 0 of the Julia set of z^2 + u_julia_c over the quaternions
+float quaternion_julia(vec3 pos, int iterations) {
+    vec4 z = vec4(pos, 0.0);
+    float dz2 = 1.0; // Squared length of the derivative of z
+    float r2 = dot(z, z);
+    float u_orbit_trap_radius = 0.5;
+
+    for (int i = 0; i < iterations; i++) {
+        dz2 *= 4.0 * r2;
+        z = vec4(z.x * z.x - dot(z.yzw, z.yzw), 2.0 * z.x * z.yzw) + u_julia_c;
+        r2 = dot(z, z);
+        orbit_trap_dist = min(orbit_trap_dist, sqrt(r2) - u_orbit_trap_radius);
+        if (r2 > float(u_escape_radius * u_escape_radius)) break;
+    }
+    float r = sqrt(r2);
+    return 0.5 * r * log(r) / sqrt(dz2);
+}
+
+// Dual numbers for mandelbulb_analytic_normal(): x holds a value and yzw its gradient with respect
+// to the sample position. Sums and products with a scalar are the usual vector operations.
+vec4 dual_mul(vec4 a, vec4 b) {
+    return vec4(a.x * b.x, a.x * b.yzw + b.x * a.yzw);
+}
+
+vec4 dual_div(vec4 a, vec4 b) {
+    return vec4(a.x / b.x, (a.yzw * b.x - a.x * b.yzw) / (b.x * b.x));
+}
+
+vec4 dual_sqrt(vec4 a) {
+    float root = sqrt(a.x);
+    return vec4(root, a.yzw * (0.5 / root));
+}
 
-        if (depth > u_max_distance) {
+vec4 dual_sin(vec4 a) {
+    return vec4(sin(a.x), cos(a.x) * a.yzw);
+}
+
+vec4 dual_cos(vec4 a) {
+    return vec4(cos(a.x), -sin(a.x) * a.yzw);
+}
+
+vec4 dual_acos(vec4 a) {
+    return vec4(acos(a.x), a.yzw * (-1.0 / sqrt(max(1.0 - a.x * a.x, 1e-12))));
+}
+
+vec4 dual_atan(vec4 y, vec4 x) {
+    return vec4(atan(y.x, x.x), (x.x * y.yzw - y.x * x.yzw) / (x.x * x.x + y.x * y.x));
+}
+
+vec4 dual_log(vec4 a) {
+    return vec4(log(a.x), a.yzw / a.x);
+}
+
+vec4 dual_pow(vec4 a, float n) {
+    float power_minus_one = pow(a.x, n - 1.0);
+    return vec4(power_minus_one * a.x, a.yzw * (n * power_minus_one));
+}
+
+float max_abs(vec3 v) {
+    v = abs(v);
+    return max(v.x, max(v.y, v.z));
+}
+
+// mandelbulb() on dual numbers, which yields the exact gradient of the distance estimate in one
+// evaluation instead of one per finite-difference tap. Whole-number powers take the same path,
+// since the result is the same.
+vec3 mandelbulb_analytic_normal(vec3 pos, float power, int iterations) {
+    // Gradients grow like dr and would overflow within a few dozen iterations. Only the direction
+    // of the result matters, so all of them are kept rescaled, including that of the added pos.
+    const float max_gradient = 1e10;
+    float pos_scale = 1.0;
+    vec4 zx = vec4(pos.x, 1.0, 0.0, 0.0);
+    vec4 zy = vec4(pos.y, 0.0, 1.0, 0.0);
+    vec4 zz = vec4(pos.z, 0.0, 0.0, 1.0);
+    vec4 dr = vec4(1.0, 0.0, 0.0, 0.0);
+    vec4 r = vec4(0.0);
+
+    for (int i = 0; i < iterations; i++) {
+        r = dual_sqrt(dual_mul(zx, zx) + dual_mul(zy, zy) + dual_mul(zz, zz));
+        if (r.x > u_escape_radius) break;
+
+        vec4 theta = dual_acos(dual_div(zz, r)) * power;
+        vec4 phi = dual_atan(zy, zx) * power;
+        vec4 r_power_minus_one = dual_pow(r, power - 1.0);
+        dr = dual_mul(r_power_minus_one, dr) * power + vec4(1.0, 0.0, 0.0, 0.0);
+
+        vec4 zr = dual_mul(r_power_minus_one, r);
+        vec4 sin_theta = dual_sin(theta);
+        zx = dual_mul(zr, dual_mul(sin_theta, dual_cos(phi))) + vec4(pos.x, pos_scale, 0.0, 0.0);
+        zy = dual_mul(zr, dual_mul(dual_sin(phi), sin_theta)) + vec4(pos.y, 0.0, pos_scale, 0.0);
+        zz = dual_mul(zr, dual_cos(theta)) + vec4(pos.z, 0.0, 0.0, pos_scale);
+
+        float largest = max(max(max_abs(zx.yzw), max_abs(zy.yzw)), max(max_abs(zz.yzw), max_abs(dr.yzw)));
+        if (largest > max_gradient) {
+            vec4 scale = vec4(1.0, vec3(1.0 / largest));
+            zx *= scale;
+            zy *= scale;
+            zz *= scale;
+            dr *= scale;
+            r *= scale;
+            pos_scale /= largest;
+        }
+    }
+
+    vec4 dist = dual_div(dual_mul(dual_log(r), r), dr);
+    return normalize(dist.yzw);
+}
+
+float DE(vec3 pos) {
+#ifdef COLLECT_STATS
+    stats_de_evaluation_count++;
+#endif
+#if FORMULA == formula_mandelbox
+    return mandelbox(pos, u_max_iterations);
+#elif FORMULA == formula_menger_sponge
+    return menger_sponge(pos, u_max_iterations);
+#elif FORMULA == formula_quaternion_julia
+    return quaternion_julia(pos, u_max_iterations);
+#else
+    return integer_power > 0
+        ? mandelbulb_integer_power(pos, integer_power, u_max_iterations)
+        : mandelbulb(pos, u_power, u_max_iterations);
+#endif
+}
+
+#if defined(GEOMETRY_PASS) && defined(PRECISION)
+// complex_pow() of (re, im)
+void real_complex_pow(inout real re, inout real im, int n) {
+    real result_re = real_from(1.0);
+    real result_im = real_from(0.0);
+    for (; n > 0; n >>= 1) {
+        if ((n & 1) != 0) {
+            real product_re = real_sub(real_mul(result_re, re), real_mul(result_im, im));
+            result_im = real_add(real_mul(result_re, im), real_mul(result_im, re));
+            result_re = product_re;
+        }
+        real square_re = real_sub(real_mul(re, re), real_mul(im, im));
+        real half_square_im = real_mul(re, im);
+        im = real_add(half_square_im, half_square_im);
+        re = square_re;
+    }
+    re = result_re;
+    im = result_im;
+}
+
+real real_integer_pow(real x, int n) {
+    real result = real_from(1.0);
+    for (; n > 0; n >>= 1) {
+        if ((n & 1) != 0) result = real_mul(result, x);
+        x = real_mul(x, x);
+    }
+    return result;
+}
+
+// mandelbulb_integer_power() with its first u_precise_iterations iterations in extended precision
+float mandelbulb_integer_power_precise(real3 pos, int power, int iterations) {
+    real3 z = pos;
+    float dr = 1.0;
+    float r = 0.0;
+    float u_orbit_trap_radius = 0.5;
+    int precise_iterations = min(u_precise_iterations, iterations);
+    int i = 0;
+
+    for (; i < precise_iterations; i++) {
+        real rho_squared = real_add(real_mul(z.x, z.x), real_mul(z.y, z.y));
+        real r_precise = real_sqrt(real_add(rho_squared, real_mul(z.z, z.z)));
+        r = real_to_float(r_precise);
+        if (r > u_escape_radius) return 0.5 * log(r) * r / dr;
+
+        orbit_trap_dist = min(orbit_trap_dist, r - u_orbit_trap_radius);
+
+        real rho = real_sqrt(rho_squared);
+        real theta_re = real_div(z.z, r_precise);
+        real theta_im = real_div(rho, r_precise);
+        real_complex_pow(theta_re, theta_im, power);
+        real phi_re = real_from(1.0);
+        real phi_im = real_from(0.0);
+        if (real_to_float(rho) > 0.0) {
+            phi_re = real_div(z.x, rho);
+            phi_im = real_div(z.y, rho);
+        }
+        real_complex_pow(phi_re, phi_im, power);
+
+        real r_power_minus_one = real_integer_pow(r_precise, power - 1);
+        dr = real_to_float(r_power_minus_one) * float(power) * dr + 1.0;
+
+        real zr = real_mul(r_power_minus_one, r_precise);
+        z.x = real_add(real_mul(zr, real_mul(theta_im, phi_re)), pos.x);
+        z.y = real_add(real_mul(zr, real_mul(theta_im, phi_im)), pos.y);
+        z.z = real_add(real_mul(zr, theta_re), pos.z);
+    }
+
+    vec3 pos_float = real3_to_vec3(pos);
+    vec3 z_float = real3_to_vec3(z);
+    for (; i < iterations; i++) {
+        r = length(z_float);
+        if (r > u_escape_radius) break;
+
+        orbit_trap_dist = min(orbit_trap_dist, r - u_orbit_trap_radius);
+
+        float rho = length(z_float.xy);
+        vec2 theta = complex_pow(vec2(z_float.z, rho) / r, power);
+        vec2 phi = complex_pow(rho > 0.0 ? z_float.xy / rho : vec2(1.0, 0.0), power);
+
+        float r_power_minus_one = integer_pow(r, power - 1);
+        dr = r_power_minus_one * float(power) * dr + 1.0;
+
+        z_float = r_power_minus_one * r * vec3(
+            theta.y * phi.x,
+            theta.y * phi.y,
+            theta.x
+        ) + pos_float;
+    }
+    return 0.5 * log(r) * r / dr;
+}
+
+// DE() of a position in extended precision. Other powers and formulas only get the precise ray
+// position.
+float DE_precise(real3 pos) {
+#if FORMULA == formula_mandelbulb
+    if (integer_power > 0) {
+#ifdef COLLECT_STATS
+        stats_de_evaluation_count++;
+#endif
+        return mandelbulb_integer_power_precise(pos, integer_power, u_max_iterations);
+    }
+#endif
+    return DE(real3_to_vec3(pos));
+}
+
+// ray_march() from the camera in extended precision. A ray also hits once it is within the
+// footprint of its pixel, which keeps the surface as detailed as the pixels at any zoom without
+// lowering u_epsilon. The direction stays a float, since its error only moves the hit by a
+// fraction of the distance from the camera.
+float ray_march_precise(vec3 ray_direction) {
+    real3 ray_origin = real3(
+        real_from_pair(u_camera_pos.x, u_camera_pos_low.x),
+        real_from_pair(u_camera_pos.y, u_camera_pos_low.y),
+        real_from_pair(u_camera_pos.z, u_camera_pos_low.z)
+    );
+    real3 pos;
+    real depth = real_from(0.0);
+    float hit_distance = u_epsilon;
+    int i;
+
+    for (i = 0; i < u_step_limit; i++) {
+        pos = real3_offset(ray_origin, depth, ray_direction);
+        float dist = DE_precise(pos);
+        depth = real_add(depth, real_from(dist));
+        hit_distance = min(u_epsilon, real_to_float(depth) * u_pixel_angle);
+
+        if (real_to_float(depth) > u_max_distance) {
             exceeded_max_distance = true;
             break;
         }
-        if (u_background_type == background_type_dynamic) {
-		    if ((dist < u_epsilon || dist > 20.0) && i > 2) break;
-        } else if (dist < u_epsilon) {
+        if (background_type == background_type_dynamic) {
+            if ((dist < hit_distance || dist > 20.0) && i > 2) break;
+        } else if (dist < hit_distance) {
             break;
         }
+    }
+
+    current_pos_precise = pos;
+    precise_hit_distance = hit_distance;
+    current_pos = real3_to_vec3(pos);
+    current_steps = i;
+#ifdef COLLECT_STATS
+    stats_march_step_count = min(i + 1, u_step_limit);
+#endif
+    return (1.0 - float(i) / u_step_limit);
+}
+
+// Central differences of DE_precise() with taps at the hit distance, which resolves the normal
+// at the scale of the pixels. The normal methods are float-only, since their fixed taps would
+// span many pixels of a deep zoom.
+vec3 calculate_normal_precise(real3 pos, float epsilon) {
+    real h = real_from(epsilon);
+    float dx = DE_precise(real3(real_add(pos.x, h), pos.y, pos.z)) - DE_precise(real3(real_sub(pos.x, h), pos.y, pos.z));
+    float dy = DE_precise(real3(pos.x, real_add(pos.y, h), pos.z)) - DE_precise(real3(pos.x, real_sub(pos.y, h), pos.z));
+    float dz = DE_precise(real3(pos.x, pos.y, real_add(pos.z, h))) - DE_precise(real3(pos.x, pos.y, real_sub(pos.z, h)));
+    return normalize(vec3(dx, dy, dz));
+}
+#endif
+
+// Distance estimate of the camera rays, from the distance volume where it has one
+float march_distance(vec3 pos) {
+#if defined(GEOMETRY_PASS) && defined(DISTANCE_VOLUME)
+    float dist = volume_distance(pos);
+    if (dist >= 0.0) return dist;
+#endif
+    return DE(pos);
+}
+
+// Step number step_index of ray_march(), from depth along the ray to the next estimate. Returns whether
+// the ray ended at pos, which it missed if it set exceeded_max_distance.
+bool march_step(vec3 ray_origin, vec3 ray_direction, int step_index, inout float depth, out vec3 pos) {
+	pos = ray_origin + depth * ray_direction;
+	float dist = march_distance(pos);
+	depth += dist;
+
+    if (depth > u_max_distance) {
+        exceeded_max_distance = true;
+        return true;
+    }
+    if (background_type == background_type_dynamic) {
+        return (dist < u_epsilon || dist > 20.0) && step_index > 2;
+    }
+    return dist < u_epsilon;
+}
+
+float ray_march(vec3 ray_origin, vec3 ray_direction) {
+	vec3 pos;
+	float depth = 0.0;
+	int i;
+
+	for (i = 0; i < u_step_limit; i++) {
+		if (march_step(ray_origin, ray_direction, i, depth, pos)) break;
 	}
 
 	current_pos = pos;
     current_steps = i;
+#ifdef COLLECT_STATS
+    stats_march_step_count = min(i + 1, u_step_limit);
+#endif
 	return (1.0 - float(i) / u_step_limit);
 }
 
@@ -277,7 +1090,10 @@ float soft_shadow(in vec3 ray_origin, float min_dist, float max_dist) {
     float epsilon = 0.001;
 
     for(int i = 0; i < u_shadow_max_iterations && current_dist < max_dist; i++) {
-        float surface_dist = DE(ray_origin + current_dist * ray_dir, false);
+        float surface_dist = DE(ray_origin + current_dist * ray_dir);
+#ifdef COLLECT_STATS
+        stats_shadow_step_count++;
+#endif
 
         if (surface_dist < epsilon) {
             result = 0.0;
@@ -296,16 +1112,37 @@ float soft_shadow(in vec3 ray_origin, float min_dist, float max_dist) {
 
 vec3 calculate_normal(vec3 pos) {
     float epsilon = 0.001;
+
+    // Only the Mandelbulb has an analytic normal; the other formulas use central differences
+#if FORMULA == formula_mandelbulb
+    if (normal_method == normal_method_analytic) {
+#ifdef COLLECT_STATS
+        stats_de_evaluation_count++;
+#endif
+        return mandelbulb_analytic_normal(pos, u_power, u_max_iterations);
+    }
+#endif
+    if (normal_method == normal_method_tetrahedral) {
+        // Corners of a tetrahedron at the same distance as the central-difference taps
+        vec2 k = vec2(1.0, -1.0) * 0.57735027;
+        return normalize(
+            k.xyy * DE(pos + k.xyy * epsilon) +
+            k.yyx * DE(pos + k.yyx * epsilon) +
+            k.yxy * DE(pos + k.yxy * epsilon) +
+            k.xxx * DE(pos + k.xxx * epsilon)
+        );
+    }
+
     vec2 h = vec2(epsilon, 0.0);
 
-    float dx = DE(pos + h.xyy, false) - DE(pos - h.xyy, false);
-    float dy = DE(pos + h.yxy, false) - DE(pos - h.yxy, false);
-    float dz = DE(pos + h.yyx, false) - DE(pos - h.yyx, false);
+    float dx = DE(pos + h.xyy) - DE(pos - h.xyy);
+    float dy = DE(pos + h.yxy) - DE(pos - h.yxy);
+    float dz = DE(pos + h.yyx) - DE(pos - h.yyx);
 
     return normalize(vec3(dx, dy, dz));
 }
 
-vec3 blinn_phong(vec3 color, vec3 pos) {
+vec3 blinn_phong(vec3 color, vec3 pos, vec3 normal) {
     const vec3 light_color = vec3(1.0, 1.0, 1.0);
     const vec3 spec_color = vec3(1.0, 1.0, 1.0);
     const float gamma = 2.2;
@@ -313,7 +1150,6 @@ vec3 blinn_phong(vec3 color, vec3 pos) {
     vec3 light_dir = normalize(u_light_pos - pos);
     vec3 view_dir = normalize(u_camera_pos - pos);
     vec3 half_dir = normalize(light_dir + view_dir);
-    vec3 normal = calculate_normal(pos);
     
     vec3 ambient = u_ambient_strength * color;
 
@@ -329,57 +1165,334 @@ vec3 blinn_phong(vec3 color, vec3 pos) {
     return result;
 }
 
+// Distance along the ray to the light source, or -1 if the ray misses it. The geometry pass leaves
+// the light out of the march so that moving it only needs the shading pass.
+float light_intersection(vec3 ray_origin, vec3 ray_direction) {
+    vec3 offset = ray_origin - u_light_pos;
+    float b = dot(offset, ray_direction);
+    float c = dot(offset, offset) - u_light_radius * u_light_radius;
+    float h = b * b - c;
+    if (h < 0.0) return -1.0;
+    return -b - sqrt(h);
+}
+
 vec3 orbit_trap(float dist) {
-    return texture(u_gradient_texture, clamp(dist, 0.0, 1.0)).rgb;
+    return texture(u_gradient_texture, vec2(clamp(dist, 0.0, 1.0), 0.5)).rgb;
 }
 
-void main() {
-    vec2 uv = gl_FragCoord.xy / u_resolution.xy;
-    vec3 color;
-    float ray_progress = ray_march(v_ray_origin, v_ray_direction);
+#ifdef COMPUTE_PASS
+#elif defined(GEOMETRY_PASS)
+void geometry_pass() {
+#ifdef INTERLEAVE
+    vec3 ray_direction = frame_ray_direction(vec2(interleaved_pixel(ivec2(gl_FragCoord.xy))) + 0.5);
+#else
+    vec3 ray_direction = v_ray_direction;
+#endif
+#ifdef PRECISION
+    float ray_progress = ray_march_precise(ray_direction);
+#else
+    float ray_progress = ray_march(v_ray_origin, ray_direction);
+#endif
+
+    // A solid background hides every ray that missed, so their normals are never used
+    vec3 normal = vec3(0.0);
+    if (!(background_type == background_type_solid && exceeded_max_distance)) {
+#ifdef PRECISION
+        normal = calculate_normal_precise(current_pos_precise, precise_hit_distance);
+#else
+        normal = calculate_normal(current_pos);
+#endif
+    }
 
-    if (u_background_type == background_type_solid && (exceeded_max_distance || ray_progress < u_ray_hit_threshold)) {
+    g_position = vec4(current_pos, ray_progress);
+    g_normal = vec4(normal, orbit_trap_dist);
+    g_miss = exceeded_max_distance ? 1.0 : 0.0;
+
+#ifdef COLLECT_STATS
+    add_stat(stats_pixels, 1);
+    add_stat(stats_march_steps, stats_march_step_count);
+    add_stat(stats_de_evaluations, stats_de_evaluation_count);
+    add_stat(stats_misses, exceeded_max_distance ? 1 : 0);
+    add_stat(stats_step_limit_hits, current_steps == u_step_limit ? 1 : 0);
+#endif
+}
+#elif defined(RECONSTRUCT_PASS)
+void reconstruct_pass() {
+    // Distances of a history sample beyond the marched neighbors that still pass as the same surface
+    const float depth_tolerance = 0.05;
+
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    if (is_marched(pixel)) {
+        ivec2 texel = interleaved_texel(pixel);
+        g_position = texelFetch(u_gbuffer_position, texel, 0);
+        g_normal = texelFetch(u_gbuffer_normal, texel, 0);
+        g_miss = texelFetch(u_gbuffer_miss, texel, 0).r;
+        return;
+    }
+    if (u_history_exact != 0) {
+        g_position = texelFetch(u_history_position, pixel, 0);
+        g_normal = texelFetch(u_history_normal, pixel, 0);
+        g_miss = texelFetch(u_history_miss, pixel, 0).r;
+        return;
+    }
+
+    // The neighbors marched this frame, split into hits (0) and misses (1). Each sum holds the
+    // distance from the camera, ray progress, orbit trap distance and count.
+    vec4 sums[2] = vec4[2](vec4(0.0), vec4(0.0));
+    vec3 normal_sums[2] = vec3[2](vec3(0.0), vec3(0.0));
+    float min_distance = 1e20;
+    float max_distance = 0.0;
+    float min_progress = 1.0;
+    float max_progress = 0.0;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            ivec2 neighbor = pixel + ivec2(x, y);
+            if (any(lessThan(neighbor, ivec2(0))) || any(greaterThanEqual(neighbor, u_frame_size)) || !is_marched(neighbor)) continue;
+            ivec2 texel = interleaved_texel(neighbor);
+            vec4 position = texelFetch(u_gbuffer_position, texel, 0);
+            vec4 normal = texelFetch(u_gbuffer_normal, texel, 0);
+            int miss = texelFetch(u_gbuffer_miss, texel, 0).r > 0.5 ? 1 : 0;
+            float dist = length(position.xyz - v_ray_origin);
+            sums[miss] += vec4(dist, position.w, normal.w, 1.0);
+            normal_sums[miss] += normal.xyz;
+            if (miss == 0) {
+                min_distance = min(min_distance, dist);
+                max_distance = max(max_distance, dist);
+                min_progress = min(min_progress, position.w);
+                max_progress = max(max_progress, position.w);
+            }
+        }
+    }
+    int miss = sums[1].w > sums[0].w ? 1 : 0;
+    vec4 sum = sums[miss] / max(sums[miss].w, 1.0);
+    vec3 ray_direction = normalize(v_ray_direction);
+
+    // Reprojects the point at the mean distance of the hits into the previous frame. The surface the
+    // history saw there is kept if it lies within the distances of the hits around the pixel.
+    if (miss == 0) {
+        vec4 clip = u_history_view_projection * vec4(v_ray_origin + ray_direction * sum.x, 1.0);
+        vec2 uv = clip.xy / clip.w * 0.5 + 0.5;
+        if (clip.w > 0.0 && all(greaterThanEqual(uv, vec2(0.0))) && all(lessThan(uv, vec2(1.0)))) {
+            ivec2 history = ivec2(uv * vec2(u_frame_size));
+            vec4 position = texelFetch(u_history_position, history, 0);
+            float dist = length(position.xyz - v_ray_origin);
+            if (texelFetch(u_history_miss, history, 0).r < 0.5
+                && dist >= min_distance * (1.0 - depth_tolerance) && dist <= max_distance * (1.0 + depth_tolerance)) {
+                g_position = vec4(position.xyz, clamp(position.w, min_progress, max_progress));
+                g_normal = texelFetch(u_history_normal, history, 0);
+                g_miss = 0.0;
+                return;
+            }
+        }
+    }
+
+    // Stale or disoccluded, so the pixel takes the mean of its neighbors of the same kind along its own ray
+    vec3 normal = normal_sums[miss];
+    g_position = vec4(v_ray_origin + ray_direction * sum.x, sum.y);
+    g_normal = vec4(dot(normal, normal) > 0.0 ? normalize(normal) : vec3(0.0), sum.z);
+    g_miss = float(miss);
+}
+#elif defined(AA_EDGE_PASS)
+// Inverse of the view-space depth of the G-buffer texel, which is linear across the screen on
+// flat surfaces, so its second difference is only large where the depth jumps
+float aa_inverse_depth(ivec2 texel, vec3 forward) {
+    vec3 pos = texelFetch(u_gbuffer_position, texel, 0).xyz;
+    return 1.0 / max(dot(pos - u_camera_pos, forward), 1e-6);
+}
+
+void aa_edge_pass() {
+    // Scales of the differences that count as strong as a color difference of 1
+    const float normal_weight = 0.5;
+    const float depth_weight = 4.0;
+    const ivec2 neighbors[4] = ivec2[4](ivec2(-1, 0), ivec2(1, 0), ivec2(0, -1), ivec2(0, 1));
+
+    ivec2 size = textureSize(u_aa_color, 0);
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec3 color = texelFetch(u_aa_color, texel, 0).rgb;
+    vec3 normal = texelFetch(u_gbuffer_normal, texel, 0).xyz;
+    bool miss = texelFetch(u_gbuffer_miss, texel, 0).r > 0.5;
+    const vec3 luma = vec3(0.299, 0.587, 0.114);
+
+    float strength = 0.0;
+    bool all_hit = !miss;
+    for (int i = 0; i < 4; i++) {
+        ivec2 neighbor = clamp(texel + neighbors[i], ivec2(0), size - 1);
+        strength = max(strength, abs(dot(texelFetch(u_aa_color, neighbor, 0).rgb - color, luma)));
+        bool neighbor_miss = texelFetch(u_gbuffer_miss, neighbor, 0).r > 0.5;
+        if (neighbor_miss != miss) {
+            strength = 1.0;
+        } else if (!miss) {
+            vec3 neighbor_normal = texelFetch(u_gbuffer_normal, neighbor, 0).xyz;
+            strength = max(strength, normal_weight * (1.0 - dot(normal, neighbor_normal)));
+        }
+        all_hit = all_hit && !neighbor_miss;
+    }
+    if (all_hit) {
+        vec3 forward = -u_inverse_view_matrix[2].xyz;
+        float center = aa_inverse_depth(texel, forward);
+        for (int axis = 0; axis < 2; axis++) {
+            float before = aa_inverse_depth(clamp(texel - neighbors[axis * 2 + 1], ivec2(0), size - 1), forward);
+            float after = aa_inverse_depth(clamp(texel + neighbors[axis * 2 + 1], ivec2(0), size - 1), forward);
+            strength = max(strength, depth_weight * abs(before + after - 2.0 * center) / center);
+        }
+    }
+
+    if (strength <= u_aa_threshold) {
+        aa_edge = 0.0;
+        return;
+    }
+    // Bins cover the strengths from the threshold to 1
+    float position = (min(strength, 1.0) - u_aa_threshold) / max(1.0 - u_aa_threshold, 1e-6);
+    int bin = min(int(position * float(aa_bin_count)), aa_bin_count - 1);
+    atomicAdd(aa_histogram[bin], 1u);
+    aa_edge = float(bin + 1) / 255.0;
+}
+#else
+// Colors the ray through ray_direction that ended at current_pos. exceeded_max_distance and
+// orbit_trap_dist hold what its march found.
+vec3 shade(vec3 ray_origin, vec3 ray_direction, float ray_progress, vec3 normal) {
+    vec3 color;
+    float light_depth = show_light ? light_intersection(ray_origin, ray_direction) : -1.0;
+    bool hit_light = light_depth >= 0.0 && (exceeded_max_distance || light_depth < length(current_pos - ray_origin));
+
+    if (enable_step_heatmap) {
+        // The geometry pass stores the steps as ray progress
+        float steps = (1.0 - ray_progress) * float(u_step_limit);
+        color = texture(u_gradient_texture, vec2(clamp(steps / float(u_heatmap_max_steps), 0.0, 1.0), 0.5)).rgb;
+    } else if (hit_light && !enable_normal_visualization) {
+        color = u_light_color;
+    } else if (background_type == background_type_solid && (exceeded_max_distance || ray_progress < u_ray_hit_threshold)) {
         color = u_background_color;
-    } else if (u_enable_normal_visualization) {
+    } else if (enable_normal_visualization) {
         vec3 dx = dFdx(current_pos);
         vec3 dy = dFdy(current_pos);
         vec3 surfaceNormal = normalize(cross(dx, dy));
         vec3 normalizedNormal = normalize(surfaceNormal);
         color = (normalizedNormal + 1.0) * 0.5;
     } else {
-        float light_dist = sphere(current_pos, u_light_pos, u_light_radius);
-
-        if (u_show_light && light_dist < u_epsilon) {
-            color = u_light_color;
+        if (coloring_method == coloring_method_orbit_trap) {
+            color = orbit_trap(orbit_trap_dist);
         } else {
-            if (u_coloring_method == coloring_method_orbit_trap) {
-                color = orbit_trap(orbit_trap_dist);
-            } else {
-                vec4 col = texture(u_gradient_texture, ray_progress);
-                color = col.rgb;
-            }
-            if (u_apply_noise) {
-                float noise_1 = snoise(current_pos * 2.0 * u_noise_scale) * u_noise_amplitude;
-                float noise_2 = snoise(current_pos * 8.0 * u_noise_scale) * u_noise_amplitude;
-                float noise = mix(noise_1, noise_2, 0.1) * u_noise_amplitude;
-                color -= noise;
-            }
-            if (u_apply_blinn_phong) {
-                color = blinn_phong(color, current_pos);
-            }
-            if (u_apply_soft_shadow) {
-                color *= soft_shadow(current_pos, u_shadow_min_distance, length(u_light_pos - current_pos));
-            }
-            if (u_apply_bloom) {
-                float bloom_intensity = exp(-ray_progress * u_bloom_intensity_factor);
-                color = mix(color, u_bloom_color, bloom_intensity);
-            }
-            if (u_apply_ambient_occlusion) {
-                color = mix(0.5 * color, color, ray_progress);
-            }
+            vec4 col = texture(u_gradient_texture, vec2(ray_progress, 0.5));
+            color = col.rgb;
+        }
+        if (apply_noise) {
+#ifdef BAKED_NOISE
+            float noise = texture(u_noise_volume, current_pos * 2.0 * u_noise_scale / noise_volume_period).r * u_noise_amplitude * u_noise_amplitude;
+#else
+            float noise_1 = snoise(current_pos * 2.0 * u_noise_scale) * u_noise_amplitude;
+            float noise_2 = snoise(current_pos * 8.0 * u_noise_scale) * u_noise_amplitude;
+            float noise = mix(noise_1, noise_2, 0.1) * u_noise_amplitude;
+#endif
+            color -= noise;
+        }
+        if (apply_blinn_phong) {
+            color = blinn_phong(color, current_pos, normal);
+        }
+        if (apply_soft_shadow) {
+            color *= soft_shadow(current_pos, u_shadow_min_distance, length(u_light_pos - current_pos));
+        }
+        if (apply_bloom) {
+            float bloom_intensity = exp(-ray_progress * u_bloom_intensity_factor);
+            color = mix(color, u_bloom_color, bloom_intensity);
+        }
+        if (apply_ambient_occlusion) {
+            color = mix(0.5 * color, color, ray_progress);
         }
     }
 
-    color = clamp(color, 0.0, 1.0);
+    return clamp(color, 0.0, 1.0);
+}
+
+#ifdef AA_RESOLVE_PASS
+// Whether the pixel gets extra rays. Whole bins get them from the strongest down while they fit
+// into the budget, and the pixels of the bin where it runs out get them at random, in proportion.
+bool aa_selected(int bin, ivec2 texel) {
+    uint budget = uint(u_aa_max_pixels);
+    uint stronger = 0u;
+    for (int i = aa_bin_count - 1; i > bin; i--) {
+        stronger += aa_histogram[i];
+    }
+    if (stronger >= budget) return false;
+    uint count = aa_histogram[bin];
+    return stronger + count <= budget || aa_random(texel, 0u) * float(count) < float(budget - stronger);
+}
+
+void aa_resolve_pass() {
+    // Ray directions of the neighboring pixels, taken before any branch
+    vec3 ray_dx = dFdx(v_ray_direction);
+    vec3 ray_dy = dFdy(v_ray_direction);
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec3 color = texelFetch(u_aa_color, texel, 0).rgb;
+    int bin = int(texelFetch(u_aa_edges, texel, 0).r * 255.0 + 0.5) - 1;
+
+#ifdef COLLECT_STATS
+    int march_steps = 0;
+#endif
+    if (bin >= 0 && aa_selected(bin, texel)) {
+        atomicAdd(aa_sampled_pixels, 1u);
+        // R2 sequence with a random offset per pixel, so the extra rays of a pixel cover it evenly
+        // and neighboring pixels do not repeat a pattern
+        vec2 offset = vec2(aa_random(texel, 1u), aa_random(texel, 2u));
+        vec3 sum = color;
+        for (int i = 0; i < u_aa_samples; i++) {
+            vec2 jitter = fract(offset + float(i + 1) * vec2(0.7548776662, 0.5698402910)) - 0.5;
+            vec3 ray_direction = v_ray_direction + jitter.x * ray_dx + jitter.y * ray_dy;
+
+            // The geometry and shading passes of the extra ray
+            exceeded_max_distance = false;
+            orbit_trap_dist = 1e20;
+            float ray_progress = ray_march(v_ray_origin, ray_direction);
+#ifdef COLLECT_STATS
+            march_steps += stats_march_step_count;
+#endif
+            vec3 normal = vec3(0.0);
+            if (!(background_type == background_type_solid && exceeded_max_distance)) {
+                normal = calculate_normal(current_pos);
+            }
+            sum += shade(v_ray_origin, ray_direction, ray_progress, normal);
+        }
+        color = sum / float(u_aa_samples + 1);
+    }
     frag_color = vec4(color, 1.0);
+
+#ifdef COLLECT_STATS
+    add_stat(stats_march_steps, march_steps);
+    add_stat(stats_shadow_steps, stats_shadow_step_count);
+    add_stat(stats_de_evaluations, stats_de_evaluation_count);
+#endif
+}
+#else
+void shading_pass() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec4 position = texelFetch(u_gbuffer_position, texel, 0);
+    vec4 normal = texelFetch(u_gbuffer_normal, texel, 0);
+    current_pos = position.xyz;
+    orbit_trap_dist = normal.w;
+    exceeded_max_distance = texelFetch(u_gbuffer_miss, texel, 0).r > 0.5;
+
+    frag_color = vec4(shade(v_ray_origin, v_ray_direction, position.w, normal.xyz), 1.0);
+
+#ifdef COLLECT_STATS
+    add_stat(stats_shadow_steps, stats_shadow_step_count);
+    add_stat(stats_de_evaluations, stats_de_evaluation_count);
+#endif
+}
+#endif
+#endif
+
+#ifndef COMPUTE_PASS
+void main() {
+#ifdef GEOMETRY_PASS
+    geometry_pass();
+#elif defined(RECONSTRUCT_PASS)
+    reconstruct_pass();
+#elif defined(AA_EDGE_PASS)
+    aa_edge_pass();
+#elif defined(AA_RESOLVE_PASS)
+    aa_resolve_pass();
+#else
+    shading_pass();
+#endif
 }
+#endif
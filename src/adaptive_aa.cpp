@@ -0,0 +1,39 @@
+#include "adaptive_aa.h"
+
+// The histogram followed by the count of sampled pixels, as in shader.frag
+static constexpr int counter_count = AdaptiveAaBuffer::bin_count + 1;
+
+AdaptiveAaBuffer::AdaptiveAaBuffer() : ring(adaptive_aa_binding, counter_count) {}
+
+void AdaptiveAaBuffer::begin(const int pixels, const int samples) {
+	collect_results();
+	const int slot = ring.begin();
+	if (slot >= 0) {
+		slot_pixels[slot] = pixels;
+		slot_samples[slot] = samples;
+	}
+}
+
+void AdaptiveAaBuffer::end() {
+	ring.end();
+}
+
+const AdaptiveAaStats& AdaptiveAaBuffer::get_stats() const {
+	return stats;
+}
+
+void AdaptiveAaBuffer::collect_results() {
+	GLuint counters[counter_count] = {};
+	for (int slot = ring.read_next(counters); slot >= 0; slot = ring.read_next(counters)) {
+		stats.edge_pixels = 0;
+		for (int bin = 0; bin < bin_count; bin++) {
+			stats.edge_pixels += counters[bin];
+		}
+		const auto samples = static_cast<unsigned long long>(slot_samples[slot]);
+		stats.pixels = static_cast<unsigned long long>(slot_pixels[slot]);
+		stats.sampled_pixels = counters[bin_count];
+		stats.extra_rays = stats.sampled_pixels * samples;
+		stats.ssaa_extra_rays = stats.pixels * samples;
+		stats.valid = true;
+	}
+}
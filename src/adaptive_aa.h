@@ -0,0 +1,51 @@
+#pragma once
+
+#include "counter_buffer_ring.h"
+
+// Binding point of the AdaptiveAa storage buffer in shaders/shader.frag.
+constexpr unsigned int adaptive_aa_binding = 2;
+
+// Extra rays of one frame of adaptive anti-aliasing, against supersampling every pixel with as
+// many rays.
+struct AdaptiveAaStats {
+	unsigned long long pixels = 0;
+	// Pixels whose edge strength was above the threshold
+	unsigned long long edge_pixels = 0;
+	// Edge pixels that got extra rays within the budget
+	unsigned long long sampled_pixels = 0;
+	unsigned long long extra_rays = 0;
+	// Extra rays that supersampling every pixel would take for the same rays per edge pixel
+	unsigned long long ssaa_extra_rays = 0;
+	// Whether any frame was counted yet
+	bool valid = false;
+};
+
+// Storage buffers of the edge and resolve passes of adaptive anti-aliasing, and their counts read
+// back without stalling. The edge pass counts the pixels above the threshold into a histogram of
+// their edge strength, which the resolve pass reads to find the strongest pixels that fit into the
+// ray budget. The buffers are a CounterBufferRing. Requires a current OpenGL context.
+class AdaptiveAaBuffer {
+public:
+	// Must match aa_bin_count in shader.frag
+	static constexpr int bin_count = 32;
+
+	AdaptiveAaBuffer();
+
+	AdaptiveAaBuffer(const AdaptiveAaBuffer&) = delete;
+	AdaptiveAaBuffer& operator=(const AdaptiveAaBuffer&) = delete;
+
+	// Binds a cleared buffer to adaptive_aa_binding for the passes of a frame of pixels, which fire
+	// samples extra rays through every pixel they pick.
+	void begin(int pixels, int samples);
+	void end();
+	// Counts of the last frame whose counters have arrived
+	[[nodiscard]] const AdaptiveAaStats& get_stats() const;
+
+private:
+	CounterBufferRing ring;
+	int slot_pixels[CounterBufferRing::slot_count] = {};
+	int slot_samples[CounterBufferRing::slot_count] = {};
+	AdaptiveAaStats stats;
+
+	void collect_results();
+};
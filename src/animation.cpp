@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <type_traits>
+#include <variant>
+
+#include "animation.h"
+
+namespace {
+
+using Member = std::variant<
+	float AppSettings::*,
+	int AppSettings::*,
+	bool AppSettings::*,
+	float (AppSettings::*)[3],
+	float (AppSettings::*)[4],
+	glm::vec3 AppSettings::*,
+	float Camera::*,
+	glm::vec3 Camera::*
+>;
+
+struct Field {
+	const char* name;
+	Member member;
+	// Holds the value of the last key like a boolean, for integers that select a mode
+	bool discrete = false;
+};
+
+// Everything that changes the rendered image
+const Field fields[] = {
+	{"camera.position", &Camera::position},
+	{"camera.yaw", &Camera::yaw},
+	{"camera.pitch", &Camera::pitch},
+	{"camera.zoom", &Camera::zoom},
+	{"max_iterations", &AppSettings::max_iterations},
+	{"escape_radius", &AppSettings::escape_radius},
+	{"step_limit", &AppSettings::step_limit},
+	{"power", &AppSettings::power},
+	{"formula", &AppSettings::formula, true},
+	{"mandelbox_scale", &AppSettings::mandelbox_scale},
+	{"mandelbox_min_radius", &AppSettings::mandelbox_min_radius},
+	{"mandelbox_fixed_radius", &AppSettings::mandelbox_fixed_radius},
+	{"mandelbox_folding_limit", &AppSettings::mandelbox_folding_limit},
+	{"julia_c", &AppSettings::julia_c},
+	{"epsilon", &AppSettings::epsilon},
+	{"max_distance", &AppSettings::max_distance},
+	{"ray_hit_threshold", &AppSettings::ray_hit_threshold},
+	{"coloring_method", &AppSettings::coloring_method, true},
+	{"normal_method", &AppSettings::normal_method, true},
+	{"gradient_lut_size", &AppSettings::gradient_lut_size},
+	{"gradient_float_lut", &AppSettings::gradient_float_lut},
+	{"background_type", &AppSettings::background_type, true},
+	{"background_color", &AppSettings::background_color},
+	{"light_pos", &AppSettings::light_pos},
+	{"light_power", &AppSettings::light_power},
+	{"light_radius", &AppSettings::light_radius},
+	{"light_color", &AppSettings::light_color},
+	{"noise_scale", &AppSettings::noise_scale},
+	{"noise_amplitude", &AppSettings::noise_amplitude},
+	{"ambient_strength", &AppSettings::ambient_strength},
+	{"diffuse_strength", &AppSettings::diffuse_strength},
+	{"specular_strength", &AppSettings::specular_strength},
+	{"specular_shininess", &AppSettings::specular_shininess},
+	{"shadow_softness", &AppSettings::shadow_softness},
+	{"shadow_min_distance", &AppSettings::shadow_min_distance},
+	{"shadow_min_step_size", &AppSettings::shadow_min_step_size},
+	{"shadow_max_step_size", &AppSettings::shadow_max_step_size},
+	{"shadow_max_iterations", &AppSettings::shadow_max_iterations},
+	{"bloom_intensity_factor", &AppSettings::bloom_intensity_factor},
+	{"bloom_color", &AppSettings::bloom_color},
+	{"show_light", &AppSettings::show_light},
+	{"apply_noise", &AppSettings::apply_noise},
+	{"apply_blinn_phong", &AppSettings::apply_blinn_phong},
+	{"apply_soft_shadow", &AppSettings::apply_soft_shadow},
+	{"apply_bloom", &AppSettings::apply_bloom},
+	{"apply_ambient_occlusion", &AppSettings::apply_ambient_occlusion},
+	{"enable_normal_visualization", &AppSettings::enable_normal_visualization},
+	{"enable_step_heatmap", &AppSettings::enable_step_heatmap},
+	{"heatmap_max_steps", &AppSettings::heatmap_max_steps}
+};
+
+int find_field(const std::string& name) {
+	for (int i = 0; i < static_cast<int>(std::size(fields)); i++) {
+		if (name == fields[i].name) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+int component_count(const Member& member) {
+	if (std::holds_alternative<float (AppSettings::*)[4]>(member)) {
+		return 4;
+	}
+	return std::holds_alternative<float (AppSettings::*)[3]>(member)
+		|| std::holds_alternative<glm::vec3 AppSettings::*>(member)
+		|| std::holds_alternative<glm::vec3 Camera::*>(member) ? 3 : 1;
+}
+
+bool parse_value(std::istringstream& stream, const Member& member, std::array<float, 4>& value) {
+	if (std::holds_alternative<bool AppSettings::*>(member)) {
+		std::string token;
+		stream >> token;
+		if (token != "true" && token != "false" && token != "1" && token != "0") {
+			return false;
+		}
+		value[0] = token == "true" || token == "1" ? 1.0f : 0.0f;
+	} else {
+		for (int i = 0; i < component_count(member); i++) {
+			if (!(stream >> value[i])) {
+				return false;
+			}
+		}
+	}
+	std::string rest;
+	return !(stream >> rest);
+}
+
+// Cubic Hermite interpolation between p1 and p2 over [t1, t2], with Catmull-Rom tangents that are
+// scaled by the neighboring key intervals, since keys need not be evenly spaced.
+float catmull_rom(const float p0, const float p1, const float p2, const float p3,
+	const double t0, const double t1, const double t2, const double t3, const double time) {
+	const double h = t2 - t1;
+	const double s = (time - t1) / h;
+	const double m1 = (p2 - p0) / (t2 - t0) * h;
+	const double m2 = (p3 - p1) / (t3 - t1) * h;
+	const double s2 = s * s;
+	const double s3 = s2 * s;
+	return static_cast<float>((2.0 * s3 - 3.0 * s2 + 1.0) * p1 + (s3 - 2.0 * s2 + s) * m1
+		+ (-2.0 * s3 + 3.0 * s2) * p2 + (s3 - s2) * m2);
+}
+
+}
+
+bool Animation::load(const std::string& path) {
+	std::ifstream file(path);
+	if (!file) {
+		fprintf(stderr, "Error opening keyframe file: %s\n", path.c_str());
+		return false;
+	}
+
+	tracks.clear();
+	duration = 0.0;
+	bool has_key = false;
+	double key_time = 0.0;
+	std::string line;
+	for (int line_number = 1; std::getline(file, line); line_number++) {
+		line = line.substr(0, line.find('#'));
+		std::istringstream stream(line);
+		std::string name;
+		if (!(stream >> name)) {
+			continue;
+		}
+
+		if (name == "key") {
+			double time;
+			std::string rest;
+			if (!(stream >> time) || stream >> rest || time < 0.0 || (has_key && time <= key_time)) {
+				fprintf(stderr, "%s:%d: expected a key time in seconds after the previous one\n", path.c_str(), line_number);
+				return false;
+			}
+			has_key = true;
+			key_time = time;
+			duration = time;
+			continue;
+		}
+
+		const int field = find_field(name);
+		if (field < 0) {
+			fprintf(stderr, "%s:%d: unknown value '%s'\n", path.c_str(), line_number, name.c_str());
+			return false;
+		}
+		if (!has_key) {
+			fprintf(stderr, "%s:%d: '%s' is set before the first key\n", path.c_str(), line_number, name.c_str());
+			return false;
+		}
+		std::array<float, 4> value{};
+		if (!parse_value(stream, fields[field].member, value)) {
+			fprintf(stderr, "%s:%d: expected %d value(s) for '%s'\n", path.c_str(), line_number, component_count(fields[field].member), name.c_str());
+			return false;
+		}
+
+		auto track = std::find_if(tracks.begin(), tracks.end(), [&](const Track& t) { return t.field == field; });
+		if (track == tracks.end()) {
+			tracks.push_back({field, {}});
+			track = tracks.end() - 1;
+		}
+		if (!track->keys.empty() && track->keys.back().time == key_time) {
+			fprintf(stderr, "%s:%d: '%s' is set twice in the same key\n", path.c_str(), line_number, name.c_str());
+			return false;
+		}
+		track->keys.push_back({key_time, value});
+	}
+
+	if (!has_key) {
+		fprintf(stderr, "%s: no keys\n", path.c_str());
+		return false;
+	}
+	return true;
+}
+
+double Animation::get_duration() const {
+	return duration;
+}
+
+int Animation::get_track_count() const {
+	return static_cast<int>(tracks.size());
+}
+
+std::array<float, 4> Animation::evaluate(const Track& track, const double time) const {
+	const std::vector<Key>& keys = track.keys;
+	if (time <= keys.front().time) {
+		return keys.front().value;
+	}
+	if (time >= keys.back().time) {
+		return keys.back().value;
+	}
+
+	// Segment [keys[i], keys[i + 1]] that contains time
+	const auto next = std::upper_bound(keys.begin(), keys.end(), time, [](const double t, const Key& key) { return t < key.time; });
+	const int i = static_cast<int>(next - keys.begin()) - 1;
+	if (fields[track.field].discrete || std::holds_alternative<bool AppSettings::*>(fields[track.field].member)) {
+		return keys[i].value;
+	}
+
+	// The end keys are mirrored, which gives the end segments a tangent along the segment.
+	const int last = static_cast<int>(keys.size()) - 1;
+	const Key& k1 = keys[i];
+	const Key& k2 = keys[i + 1];
+	const Key& k0 = keys[std::max(i - 1, 0)];
+	const Key& k3 = keys[std::min(i + 2, last)];
+	const double t0 = i > 0 ? k0.time : 2.0 * k1.time - k2.time;
+	const double t3 = i + 2 <= last ? k3.time : 2.0 * k2.time - k1.time;
+	std::array<float, 4> result{};
+	for (int c = 0; c < component_count(fields[track.field].member); c++) {
+		const float p0 = i > 0 ? k0.value[c] : 2.0f * k1.value[c] - k2.value[c];
+		const float p3 = i + 2 <= last ? k3.value[c] : 2.0f * k2.value[c] - k1.value[c];
+		result[c] = catmull_rom(p0, k1.value[c], k2.value[c], p3, t0, k1.time, k2.time, t3, time);
+	}
+	return result;
+}
+
+void Animation::apply(const double time, AppSettings& settings, Camera& camera) const {
+	for (const Track& track : tracks) {
+		const std::array<float, 4> value = evaluate(track, time);
+		std::visit([&](auto member) {
+			using MemberType = decltype(member);
+			if constexpr (std::is_same_v<MemberType, float AppSettings::*>) {
+				settings.*member = value[0];
+			} else if constexpr (std::is_same_v<MemberType, int AppSettings::*>) {
+				settings.*member = static_cast<int>(std::lround(value[0]));
+			} else if constexpr (std::is_same_v<MemberType, bool AppSettings::*>) {
+				settings.*member = value[0] != 0.0f;
+			} else if constexpr (std::is_same_v<MemberType, float (AppSettings::*)[3]>) {
+				std::copy_n(value.begin(), 3, settings.*member);
+			} else if constexpr (std::is_same_v<MemberType, float (AppSettings::*)[4]>) {
+				std::copy(value.begin(), value.end(), settings.*member);
+			} else if constexpr (std::is_same_v<MemberType, glm::vec3 AppSettings::*>) {
+				settings.*member = glm::vec3(value[0], value[1], value[2]);
+			} else if constexpr (std::is_same_v<MemberType, float Camera::*>) {
+				camera.*member = value[0];
+			} else {
+				camera.*member = glm::vec3(value[0], value[1], value[2]);
+			}
+		}, fields[track.field].member);
+	}
+	camera.set_orientation(camera.yaw, camera.pitch);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "app_settings.h"
+#include "camera.h"
+
+// Camera and AppSettings values keyed over time, read from a text file:
+//
+//   # Comments start with a hash
+//   key 0                      # starts the keyframe at 0 seconds
+//   camera.position 0 0 2
+//   camera.yaw -90
+//   power 8
+//   key 4.5
+//   camera.position 0.5 0 1.2
+//   power 9.5
+//   apply_soft_shadow false
+//
+// Settings are named like the members of AppSettings and the camera has position, yaw, pitch and
+// zoom. Floats and vectors follow a Catmull-Rom spline through their keys, integers are rounded
+// from it, and booleans and the integers that select a mode (formula, coloring_method,
+// normal_method, background_type) hold the value of the last key. Before the first and after the last key
+// of a value it is held constant; values that are never keyed keep their current setting.
+class Animation {
+public:
+	// Prints errors with their line number and returns whether the file was valid.
+	bool load(const std::string& path);
+
+	// Time of the last keyframe in seconds
+	[[nodiscard]] double get_duration() const;
+	[[nodiscard]] int get_track_count() const;
+	// Sets every keyed value to its value at time, in seconds.
+	void apply(double time, AppSettings& settings, Camera& camera) const;
+
+private:
+	struct Key {
+		double time;
+		std::array<float, 4> value;
+	};
+
+	struct Track {
+		int field;
+		std::vector<Key> keys;
+	};
+
+	std::vector<Track> tracks;
+	double duration = 0.0;
+
+	[[nodiscard]] std::array<float, 4> evaluate(const Track& track, double time) const;
+};
@@ -0,0 +1,101 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "animation_renderer.h"
+#include "frame_writer.h"
+#include "readback_ring.h"
+
+AnimationRenderer::AnimationRenderer(AnimationRenderOptions options) : options(std::move(options)) {
+
+}
+
+bool AnimationRenderer::render(const Animation& animation, AppSettings settings, Camera camera, const GradientEditor& gradient_editor, Renderer& renderer) {
+	const int width = options.width;
+	const int height = options.height;
+	const int frame_count = static_cast<int>(std::floor(animation.get_duration() * options.fps + 1e-6)) + 1;
+	const float aspect_ratio = static_cast<float>(width) / static_cast<float>(height);
+
+	Framebuffer gbuffer = Renderer::make_gbuffer();
+	Framebuffer framebuffer({GL_RGBA8});
+	ReadbackRing readbacks(readback_count, width, height);
+	// Twice as many frames queued as there are writers keeps them busy while bounding the memory
+	FrameWriter writer(options.writer_threads, 2 * static_cast<int>(options.writer_threads));
+	int frames_received = 0;
+	bool failed = false;
+
+	// Hands the oldest finished readback to the writers
+	auto receive_frame = [&](const bool wait) {
+		const unsigned char* pixels = readbacks.map_oldest(wait);
+		if (!pixels) {
+			failed |= readbacks.has_failed();
+			return false;
+		}
+		std::vector<unsigned char> frame(pixels, pixels + static_cast<size_t>(width) * height * 4);
+		readbacks.release_oldest();
+
+		std::string path;
+		format_frame_path(options.output_pattern, frames_received, path);
+		writer.submit(std::move(path), std::move(frame), width, height, 4, true);
+		frames_received++;
+		return true;
+	};
+
+	const auto start_time = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frame_count && !failed; frame++) {
+		if (readbacks.is_full() && !receive_frame(true)) {
+			break;
+		}
+
+		animation.apply(frame / options.fps, settings, camera);
+		const glm::mat4 projection_matrix = glm::perspective(glm::radians(camera.zoom), aspect_ratio, 0.1f, 100.0f);
+		renderer.render_offscreen(settings, camera, gradient_editor, projection_matrix, width, height, gbuffer, framebuffer);
+		readbacks.read(width, height);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		while (receive_frame(false)) {}
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+		printf("\rFrame %d of %d, %.2f frames/s", frame + 1, frame_count, (frame + 1) / std::max(elapsed.count(), 1e-9));
+		fflush(stdout);
+	}
+	while (!failed && readbacks.get_pending_count() > 0) {
+		receive_frame(true);
+	}
+	failed |= !writer.finish();
+	printf("\n");
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+	last_stats.frame_count = writer.get_frames_written();
+	last_stats.seconds = elapsed.count();
+	last_stats.frames_per_second = last_stats.frame_count / std::max(elapsed.count(), 1e-9);
+	return !failed && last_stats.frame_count == frame_count;
+}
+
+const AnimationRenderStats& AnimationRenderer::stats() const {
+	return last_stats;
+}
+
+bool format_frame_path(const std::string& pattern, const int frame, std::string& path) {
+	const size_t percent = pattern.find('%');
+	if (percent == std::string::npos || pattern.find('%', percent + 1) != std::string::npos) {
+		return false;
+	}
+	size_t end = percent + 1;
+	int width = 0;
+	while (end < pattern.size() && pattern[end] >= '0' && pattern[end] <= '9') {
+		width = width * 10 + (pattern[end] - '0');
+		end++;
+	}
+	if (end >= pattern.size() || pattern[end] != 'd' || width > 16) {
+		return false;
+	}
+
+	char number[32];
+	snprintf(number, sizeof(number), "%0*d", width, frame);
+	path = pattern.substr(0, percent) + number + pattern.substr(end + 1);
+	return true;
+}
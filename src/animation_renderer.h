@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+
+#include "animation.h"
+#include "app_settings.h"
+#include "camera.h"
+#include "gradient_editor.h"
+#include "renderer.h"
+
+constexpr double default_animation_fps = 30.0;
+constexpr unsigned int default_animation_writer_threads = 4;
+
+struct AnimationRenderOptions {
+	// Path of every frame, with one %d conversion (optionally zero-padded like %05d) for its number
+	std::string output_pattern;
+	int width = 0;
+	int height = 0;
+	double fps = default_animation_fps;
+	unsigned int writer_threads = default_animation_writer_threads;
+};
+
+struct AnimationRenderStats {
+	int frame_count = 0;
+	double seconds = 0.0;
+	double frames_per_second = 0.0;
+};
+
+// Renders an Animation offscreen at a fixed timestep and writes every frame as an image file. The
+// GPU renders ahead while earlier frames are read back through a ReadbackRing, and a FrameWriter
+// pool encodes them, so rendering, transfers and disk writes overlap. Frames per second are
+// measured end to end, from the first frame rendered to the last file closed. Requires a current
+// OpenGL context.
+class AnimationRenderer {
+public:
+	explicit AnimationRenderer(AnimationRenderOptions options);
+
+	// Starts from settings and camera for everything the animation does not key. Returns false if
+	// a frame could not be read back or written.
+	bool render(const Animation& animation, AppSettings settings, Camera camera, const GradientEditor& gradient_editor, Renderer& renderer);
+	[[nodiscard]] const AnimationRenderStats& stats() const;
+
+private:
+	static constexpr int readback_count = 4;
+
+	AnimationRenderOptions options;
+	AnimationRenderStats last_stats;
+};
+
+// Substitutes frame into a pattern like frames/frame_%05d.png. Returns false if the pattern has
+// no %d conversion or any other conversion.
+bool format_frame_path(const std::string& pattern, int frame, std::string& path);
@@ -13,6 +13,7 @@ constexpr float default_power = 8.0f;
 constexpr float default_epsilon = 0.0001f;
 constexpr float default_max_distance = 50.0f;
 constexpr float default_ray_hit_threshold = 0.00001f;
+constexpr int default_gradient_lut_size = 256;
 constexpr float default_background_color[3] = {1.0f, 1.0f, 1.0f};
 constexpr float default_light_pos[3] = {2.0f, 2.0f, 5.0f};
 constexpr float default_light_power = 0.4f;
@@ -32,9 +33,51 @@ constexpr int default_shadow_max_iterations = 128;
 constexpr float default_bloom_intensity_factor = 5.0f;
 constexpr float default_bloom_color[3] = {1.0f, 1.0f, 1.0f};
 constexpr float default_camera_pos[3] = {0.0f, 0.0f, 1.0f};
+constexpr int default_heatmap_max_steps = 128;
+constexpr float default_frame_time_budget = 12.0f;
+constexpr float default_min_resolution_scale = 0.25f;
+constexpr int default_distance_volume_resolution = 256;
+constexpr int default_noise_volume_resolution = 128;
+constexpr int default_precise_iterations = 4;
+constexpr float default_mandelbox_scale = 2.0f;
+constexpr float default_mandelbox_min_radius = 0.5f;
+constexpr float default_mandelbox_fixed_radius = 1.0f;
+constexpr float default_mandelbox_folding_limit = 1.0f;
+constexpr float default_julia_c[4] = {-0.291f, -0.399f, 0.339f, 0.437f};
+constexpr float default_aa_threshold = 0.1f;
+constexpr int default_aa_samples = 4;
+constexpr int default_aa_ray_budget = 1000000;
+
+// Precision of the camera rays of the geometry pass. Auto marches in float until a pixel is too
+// small for float positions near the camera to resolve (see select_precision() in renderer.cpp),
+// then in df64, pairs of floats that carry about twice the mantissa. The values are those of
+// PRECISION in shaders/shader.frag.
+enum PrecisionMode {
+	precision_auto,
+	precision_fp32,
+	precision_df64,
+	precision_fp64
+};
+
+// Pixels the geometry pass marches while the view moves. The others are reprojected from the
+// previous frame, and a view that stops converges to the full image over 2 or 4 frames.
+enum InterleaveMode {
+	interleave_off,
+	// Alternating half of the pixels, in a checkerboard
+	interleave_checkerboard,
+	// One pixel of each 2x2 block, in rotation
+	interleave_quarter
+};
 
 struct AppSettings {
 	// Rendering settings
+	// Formula from the registry in formula.h, with the parameters of the formulas other than the Mandelbulb
+	int formula = 0;
+	float mandelbox_scale = default_mandelbox_scale;
+	float mandelbox_min_radius = default_mandelbox_min_radius;
+	float mandelbox_fixed_radius = default_mandelbox_fixed_radius;
+	float mandelbox_folding_limit = default_mandelbox_folding_limit;
+	float julia_c[4] = {default_julia_c[0], default_julia_c[1], default_julia_c[2], default_julia_c[3]};
 	int max_iterations = default_max_iterations;
 	int escape_radius = default_escape_radius;
 	int step_limit = default_step_limit;
@@ -43,6 +86,9 @@ struct AppSettings {
 	float max_distance = default_max_distance;
 	float ray_hit_threshold = default_ray_hit_threshold;
 	int coloring_method = 0;
+	int normal_method = 0;
+	int gradient_lut_size = default_gradient_lut_size;
+	bool gradient_float_lut = false;
 	int background_type = 0;
 	float background_color[3] = {default_background_color[0], default_background_color[1], default_background_color[2]};
 	glm::vec3 light_pos = glm::vec3(default_light_pos[0], default_light_pos[1], default_light_pos[2]);
@@ -64,11 +110,45 @@ struct AppSettings {
 	float bloom_color[3] = {default_bloom_color[0], default_bloom_color[1], default_bloom_color[2]};
 	bool show_light = false;
 	bool apply_noise = true;
+	// Samples the noise from a baked NoiseVolume instead of evaluating it per pixel
+	bool baked_noise = false;
+	int noise_volume_resolution = default_noise_volume_resolution;
 	bool apply_blinn_phong = true;
 	bool apply_soft_shadow = true;
 	bool apply_bloom = true;
 	bool apply_ambient_occlusion = true;
 	bool enable_normal_visualization = false;
+	// Colors each pixel by its march steps through the gradient, reaching its end at heatmap_max_steps
+	bool enable_step_heatmap = false;
+	int heatmap_max_steps = default_heatmap_max_steps;
+	// Counts ray statistics in the shader (see RayStats), which runs both passes every frame
+	bool collect_ray_stats = false;
+	bool specialize_shaders = true;
+	bool render_on_demand = true;
+	// Fraction of the window resolution the fractal is rendered at before it is upscaled
+	float resolution_scale = 1.0f;
+	// Adjusts the scale to hold the GPU time of the passes at frame_time_budget milliseconds
+	bool dynamic_resolution = false;
+	float frame_time_budget = default_frame_time_budget;
+	float min_resolution_scale = default_min_resolution_scale;
+	// InterleaveMode of the geometry pass
+	int interleave_mode = interleave_off;
+	// Runs the geometry pass as a compute shader (see shaders/march.comp) in fp32 precision
+	bool compute_march = false;
+	// Marches camera rays through a baked DistanceVolume away from the surface. The volume is baked
+	// in the background for the current fractal, which is marched exactly until it is ready.
+	bool use_distance_volume = false;
+	int distance_volume_resolution = default_distance_volume_resolution;
+	// Extended precision for deep zooms, which covers the ray positions and the first
+	// precise_iterations iterations of whole-number powers
+	int precision_mode = precision_auto;
+	int precise_iterations = default_precise_iterations;
+	// Fires aa_samples extra jittered rays through the pixels whose depth, normal or color differs
+	// from a neighbor's by more than aa_threshold, strongest first, up to aa_ray_budget rays a frame
+	bool adaptive_aa = false;
+	float aa_threshold = default_aa_threshold;
+	int aa_samples = default_aa_samples;
+	int aa_ray_budget = default_aa_ray_budget;
 
 	// GUI settings
 	bool show_gui = true;
@@ -7,6 +7,7 @@ Camera::Camera(glm::vec3 position, glm::vec3 front, glm::vec3 up, glm::vec3 righ
       sensitivity(default_sensitivity),
       zoom(default_zoom),
       position(position),
+      position_low(0.0f),
       front(front),
       up(up),
       right(right),
@@ -18,6 +19,16 @@ glm::mat4 Camera::view_matrix() const {
 	return lookAt(position, position + front, up);
 }
 
+glm::dvec3 Camera::precise_position() const {
+	return glm::dvec3(position) + glm::dvec3(position_low);
+}
+
+void Camera::move(const glm::vec3 offset) {
+	const glm::dvec3 moved = precise_position() + glm::dvec3(offset);
+	position = glm::vec3(moved);
+	position_low = glm::vec3(moved - glm::dvec3(position));
+}
+
 void Camera::handle_keyboard_input(GLFWwindow* window, const float delta_time) {
     float velocity = speed * delta_time;
 
@@ -29,22 +40,22 @@ void Camera::handle_keyboard_input(GLFWwindow* window, const float delta_time) {
     }
 
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
-        position += front * velocity;
+        move(front * velocity);
     }
     if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-        position -= front * velocity;
+        move(-front * velocity);
     }
     if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
-        position -= right * velocity;
+        move(-right * velocity);
     }
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
-        position += right * velocity;
+        move(right * velocity);
     }
     if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
-        position += up * velocity;
+        move(up * velocity);
     }
     if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS) {
-        position -= up * velocity;
+        move(-up * velocity);
     }
 }
 
@@ -87,6 +98,7 @@ void Camera::reset() {
 	position[0] = 0.0f;
 	position[1] = 0.0f;
 	position[2] = 1.0f;
+	position_low = glm::vec3(0.0f);
     front[0] = 0.0f;
 	front[1] = 0.0f;
 	front[2] = -1.0f;
@@ -101,6 +113,12 @@ void Camera::reset() {
 	world_up[2] = up[2];
 }
 
+void Camera::set_orientation(const float yaw, const float pitch) {
+	this->yaw = yaw;
+	this->pitch = pitch;
+	update_vectors();
+}
+
 void Camera::update_vectors() {
     front = normalize(glm::vec3(
         cos(glm::radians(yaw)) * cos(glm::radians(pitch)),
@@ -20,6 +20,10 @@ public:
 	float zoom;
 
 	glm::vec3 position;
+	// Rounding error of position, which move() keeps so that the two add up to the position in
+	// double precision for deep zooms. It is below an ulp of position, so assigning position
+	// directly only leaves the sum off by that much.
+	glm::vec3 position_low;
 	glm::vec3 front;
 	glm::vec3 up;
 	glm::vec3 right;
@@ -30,10 +34,15 @@ public:
 		float yaw = default_yaw, float pitch = default_pitch);
 
 	[[nodiscard]] glm::mat4 view_matrix() const;
+	[[nodiscard]] glm::dvec3 precise_position() const;
+	// Moves by offset in double precision, so steps smaller than an ulp of position still add up.
+	void move(glm::vec3 offset);
 	void handle_keyboard_input(GLFWwindow* window, float delta_time);
 	void handle_mouse_movement(float delta_x, float delta_y, GLboolean constrain_pitch = true);
 	void handle_mouse_scroll(float delta_y);
 	void reset();
+	// Sets yaw and pitch in degrees and updates the direction vectors.
+	void set_orientation(float yaw, float pitch);
 
 private:
 	void update_vectors();
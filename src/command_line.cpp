@@ -0,0 +1,143 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "command_line.h"
+
+static bool parse_int(const char* value, int& result) {
+	char* end = nullptr;
+	const long parsed = std::strtol(value, &end, 10);
+	if (end == value || *end != '\0' || parsed <= 0) {
+		return false;
+	}
+	result = static_cast<int>(parsed);
+	return true;
+}
+
+static bool parse_double(const char* value, double& result) {
+	char* end = nullptr;
+	const double parsed = std::strtod(value, &end);
+	if (end == value || *end != '\0' || !(parsed > 0.0)) {
+		return false;
+	}
+	result = parsed;
+	return true;
+}
+
+static bool parse_simd_level(const char* value, SimdLevel& result) {
+	if (std::strcmp(value, "scalar") == 0) {
+		result = SimdLevel::scalar;
+	} else if (std::strcmp(value, "avx2") == 0) {
+		result = SimdLevel::avx2;
+	} else if (std::strcmp(value, "avx512") == 0) {
+		result = SimdLevel::avx512;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+bool parse_command_line(const int argc, char* argv[], CommandLineOptions& options) {
+	bool has_output_path = false;
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+		bool valid = true;
+
+		if (std::strcmp(arg, "--headless") == 0) {
+			options.headless = true;
+		} else if (std::strcmp(arg, "--output") == 0 && value) {
+			options.output_path = value;
+			has_output_path = true;
+			i++;
+		} else if (std::strcmp(arg, "--width") == 0 && value) {
+			valid = parse_int(value, options.width);
+			i++;
+		} else if (std::strcmp(arg, "--height") == 0 && value) {
+			valid = parse_int(value, options.height);
+			i++;
+		} else if (std::strcmp(arg, "--tile-size") == 0 && value) {
+			valid = parse_int(value, options.tile_size);
+			i++;
+		} else if (std::strcmp(arg, "--threads") == 0 && value) {
+			int threads = 0;
+			valid = parse_int(value, threads);
+			options.threads = static_cast<unsigned int>(threads);
+			i++;
+		} else if (std::strcmp(arg, "--simd") == 0 && value) {
+			valid = parse_simd_level(value, options.simd_level);
+			i++;
+		} else if (std::strcmp(arg, "--animation") == 0 && value) {
+			options.animation_path = value;
+			i++;
+		} else if (std::strcmp(arg, "--fps") == 0 && value) {
+			valid = parse_double(value, options.fps);
+			i++;
+		} else if (std::strcmp(arg, "--mesh") == 0 && value) {
+			options.mesh_path = value;
+			i++;
+		} else if (std::strcmp(arg, "--resolution") == 0 && value) {
+			valid = parse_int(value, options.mesh_resolution);
+			i++;
+		} else if (std::strcmp(arg, "--extent") == 0 && value) {
+			valid = parse_double(value, options.mesh_extent);
+			i++;
+		} else {
+			valid = false;
+		}
+
+		if (!valid) {
+			print_usage(argv[0]);
+			return false;
+		}
+	}
+
+	if (!options.animation_path.empty()) {
+		if (!has_output_path) {
+			options.output_path = default_animation_output_pattern;
+		}
+		std::string path;
+		if (!format_frame_path(options.output_path, 0, path)) {
+			fprintf(stderr, "The output path of an animation needs one frame number conversion like %%05d\n");
+			return false;
+		}
+	}
+	return true;
+}
+
+void print_usage(const char* program_name) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"\n"
+		"Without options, starts the interactive viewer.\n"
+		"\n"
+		"Headless rendering (CPU, no window or GPU required):\n"
+		"  --headless           Render a single still with the CPU renderer and exit\n"
+		"  --output <path>      Output file, PNG if it ends in .png and PPM otherwise\n"
+		"                       (default: cloven.ppm)\n"
+		"  --width <pixels>     Image width (default: %d)\n"
+		"  --height <pixels>    Image height (default: %d)\n"
+		"  --tile-size <pixels> Size of the tiles streamed to the output file, which bounds\n"
+		"                       memory use at any image size (default: %d)\n"
+		"  --threads <count>    Worker threads (default: all cores)\n"
+		"  --simd <level>       Distance estimator instruction set: scalar, avx2 or avx512\n"
+		"                       (default: widest supported)\n"
+		"\n"
+		"Animation rendering (GPU, hidden window):\n"
+		"  --animation <path>   Render every frame of a keyframe file and exit\n"
+		"  --output <pattern>   Path of each frame with its number in a %%d conversion\n"
+		"                       (default: %s)\n"
+		"  --width, --height    Frame size, as above\n"
+		"  --fps <rate>         Frames per second of animation time (default: %g)\n"
+		"  --threads <count>    Threads writing frames to disk (default: %u)\n"
+		"\n"
+		"Mesh extraction (CPU, no window or GPU required):\n"
+		"  --mesh <path>        Extract the surface as a triangle mesh and exit, OBJ if the\n"
+		"                       path ends in .obj and binary PLY otherwise\n"
+		"  --resolution <cells> Grid cells along each edge (default: %d)\n"
+		"  --extent <size>      Half the edge of the meshed cube around the origin (default: %g)\n"
+		"  --threads, --simd    As for headless rendering\n",
+		program_name, default_headless_width, default_headless_height, default_export_tile_size,
+		default_animation_output_pattern, default_animation_fps, default_animation_writer_threads,
+		default_mesh_resolution, static_cast<double>(default_mesh_extent));
+}
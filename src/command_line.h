@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+
+#include "animation_renderer.h"
+#include "mandelbulb_simd.h"
+#include "mesh_extractor.h"
+#include "tiled_export.h"
+
+constexpr int default_headless_width = 3840;
+constexpr int default_headless_height = 2160;
+constexpr const char* default_animation_output_pattern = "frame_%05d.png";
+
+struct CommandLineOptions {
+	// Headless rendering
+	bool headless = false;
+	std::string output_path = "cloven.ppm";
+	int width = default_headless_width;
+	int height = default_headless_height;
+	int tile_size = default_export_tile_size;
+	unsigned int threads = 0;
+	SimdLevel simd_level = detect_simd_level();
+
+	// Animation rendering
+	std::string animation_path;
+	double fps = default_animation_fps;
+
+	// Mesh extraction
+	std::string mesh_path;
+	int mesh_resolution = default_mesh_resolution;
+	double mesh_extent = default_mesh_extent;
+};
+
+// Returns false if the arguments are invalid or help was requested, after printing usage.
+bool parse_command_line(int argc, char* argv[], CommandLineOptions& options);
+void print_usage(const char* program_name);
@@ -0,0 +1,59 @@
+#include "counter_buffer_ring.h"
+
+CounterBufferRing::CounterBufferRing(const GLuint binding, const int counter_count)
+	: binding(binding), size(static_cast<GLsizeiptr>(counter_count) * static_cast<GLsizeiptr>(sizeof(GLuint))) {
+	glGenBuffers(slot_count + 1, buffers);
+	for (const GLuint buffer : buffers) {
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glBufferStorage(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+CounterBufferRing::~CounterBufferRing() {
+	for (const GLsync fence : fences) {
+		if (fence) glDeleteSync(fence);
+	}
+	glDeleteBuffers(slot_count + 1, buffers);
+}
+
+int CounterBufferRing::begin() {
+	active_slot = fences[next_slot] ? -1 : next_slot;
+	const GLuint buffer = buffers[active_slot >= 0 ? active_slot : slot_count];
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+	glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+	return active_slot;
+}
+
+void CounterBufferRing::end() {
+	// Makes the shader's atomics visible to the readback and to the next clear
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	if (active_slot >= 0) {
+		fences[active_slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		next_slot = (next_slot + 1) % slot_count;
+		active_slot = -1;
+	}
+}
+
+int CounterBufferRing::read_next(GLuint* counters) {
+	// Slots complete in submission order, starting with the oldest at next_slot.
+	for (int i = 0; i < slot_count; i++) {
+		const int slot = (next_slot + i) % slot_count;
+		GLsync& fence = fences[slot];
+		if (!fence) continue;
+
+		const GLenum status = glClientWaitSync(fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return -1;
+		glDeleteSync(fence);
+		fence = nullptr;
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[slot]);
+		glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, counters);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		return slot;
+	}
+	return -1;
+}
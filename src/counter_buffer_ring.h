@@ -0,0 +1,35 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Storage buffers of counters that shaders add to with atomics, read back without stalling. Each
+// frame between begin() and end() counts into a cleared slot of a small ring, which is read once
+// its fence signals. If every slot is still pending, the frame counts into a buffer that is never
+// read. Requires a current OpenGL context.
+class CounterBufferRing {
+public:
+	static constexpr int slot_count = 3;
+
+	CounterBufferRing(GLuint binding, int counter_count);
+	~CounterBufferRing();
+
+	CounterBufferRing(const CounterBufferRing&) = delete;
+	CounterBufferRing& operator=(const CounterBufferRing&) = delete;
+
+	// Binds a cleared buffer to the binding point for the draws that follow. Returns the slot the
+	// frame counts into, or -1 if it counts into the buffer that is never read.
+	int begin();
+	void end();
+	// Copies the counters of the oldest frame that was not read yet into counters and returns its
+	// slot, or -1 if that frame is still in flight or every frame was read.
+	int read_next(GLuint* counters);
+
+private:
+	// The last buffer is the one that is never read
+	GLuint buffers[slot_count + 1] = {};
+	GLsync fences[slot_count] = {};
+	GLuint binding;
+	GLsizeiptr size;
+	int next_slot = 0;
+	int active_slot = -1;
+};
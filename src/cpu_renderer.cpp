@@ -0,0 +1,515 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include <glm/ext/matrix_clip_space.hpp>
+
+#include "cpu_renderer.h"
+#include "formula.h"
+#include "mandelbulb.h"
+#include "simplex_noise.h"
+
+namespace {
+
+constexpr int background_type_solid = 0;
+constexpr int background_type_dynamic = 1;
+constexpr int coloring_method_orbit_trap = 0;
+
+struct FrameContext {
+	const AppSettings& settings;
+	const std::vector<unsigned char>& gradient;
+	FractalParams params;
+	int width;
+	int height;
+	// Part of the image that is rendered, which the output pixels cover
+	ImageRegion region;
+	glm::vec3 camera_pos;
+	glm::vec3 ray_origin;
+	glm::vec3 background_color;
+	glm::vec3 light_color;
+	glm::vec3 bloom_color;
+
+	// Normalized ray directions at the quad corners, as output by shader.vert.
+	glm::vec3 bottom_left;
+	glm::vec3 bottom_right;
+	glm::vec3 top_left;
+	glm::vec3 top_right;
+};
+
+struct RayHit {
+	glm::vec3 pos;
+	float ray_progress;
+	bool exceeded_max_distance;
+	float orbit_trap_dist;
+};
+
+struct ShadowRay {
+	glm::vec3 origin;
+	glm::vec3 direction;
+	float current_dist;
+	float max_dist;
+	float result;
+};
+
+glm::vec3 corner_ray_direction(const glm::mat4& inverse_view_matrix, const glm::mat4& inverse_projection_matrix, const glm::vec3& camera_world_pos, const float x, const float y) {
+	const glm::vec4 view_space_pos = inverse_projection_matrix * glm::vec4(x, y, 0.0f, 1.0f);
+	glm::vec4 world_space_pos = inverse_view_matrix * view_space_pos;
+	world_space_pos /= world_space_pos.w;
+	return glm::normalize(glm::vec3(world_space_pos) - camera_world_pos);
+}
+
+// The vertex shader normalizes the ray direction per vertex and the rasterizer interpolates it
+// linearly across each of the quad's two triangles, so the fragment shader sees slightly
+// shortened directions away from the corners. This reproduces that interpolation exactly.
+glm::vec3 ray_direction(const FrameContext& ctx, const float ndc_x, const float ndc_y) {
+	if (ndc_x + ndc_y <= 0.0f) {
+		return ctx.bottom_left
+			+ (ndc_x + 1.0f) * 0.5f * (ctx.bottom_right - ctx.bottom_left)
+			+ (ndc_y + 1.0f) * 0.5f * (ctx.top_left - ctx.bottom_left);
+	}
+	return ctx.top_right
+		+ (1.0f - ndc_x) * 0.5f * (ctx.top_left - ctx.top_right)
+		+ (1.0f - ndc_y) * 0.5f * (ctx.bottom_right - ctx.top_right);
+}
+
+// Per-thread buffers reused across tiles. Rays are marched in lockstep and the positions of all
+// rays that are still active are gathered into structure-of-arrays batches for fractal_batch().
+// Aligned to a cache line, since the scratches of all threads are kept side by side.
+struct alignas(64) TileScratch {
+	std::vector<glm::vec3> directions;
+	std::vector<RayHit> hits;
+	std::vector<float> depths;
+	std::vector<int> active;
+
+	std::vector<glm::vec3> colors;
+	std::vector<int> lit_pixels;
+	std::vector<glm::vec3> normals;
+	std::vector<ShadowRay> shadow_rays;
+
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	std::vector<float> dist;
+	std::vector<float> orbit_trap_dist;
+
+	unsigned long long ray_steps = 0;
+
+	void resize_batch(const size_t count) {
+		if (x.size() < count) {
+			x.resize(count);
+			y.resize(count);
+			z.resize(count);
+			dist.resize(count);
+			orbit_trap_dist.resize(count);
+		}
+	}
+
+	void set_point(const size_t index, const glm::vec3 pos) {
+		x[index] = pos.x;
+		y[index] = pos.y;
+		z[index] = pos.z;
+	}
+};
+
+void evaluate_batch(const FrameContext& ctx, TileScratch& scratch, const int count, const bool with_orbit_trap) {
+	fractal_batch(scratch.x.data(), scratch.y.data(), scratch.z.data(), count, ctx.params,
+		scratch.dist.data(), with_orbit_trap ? scratch.orbit_trap_dist.data() : nullptr);
+}
+
+// Marches scratch.directions from the camera and fills scratch.hits, matching ray_march() in shader.frag.
+void march_rays(const FrameContext& ctx, TileScratch& scratch) {
+	const AppSettings& s = ctx.settings;
+	const size_t ray_count = scratch.directions.size();
+	scratch.hits.assign(ray_count, RayHit{ctx.ray_origin, 0.0f, false, 1e20f});
+	scratch.depths.assign(ray_count, 0.0f);
+	scratch.active.resize(ray_count);
+	for (size_t i = 0; i < ray_count; i++) {
+		scratch.active[i] = static_cast<int>(i);
+	}
+	scratch.resize_batch(ray_count);
+
+	std::vector<RayHit>& hits = scratch.hits;
+	std::vector<float>& depths = scratch.depths;
+	std::vector<int>& active = scratch.active;
+	int i;
+
+	// All rays take their i-th step together, so a ray that stops here has taken i steps.
+	for (i = 0; i < s.step_limit && !active.empty(); i++) {
+		for (size_t k = 0; k < active.size(); k++) {
+			const int ray = active[k];
+			hits[ray].pos = ctx.ray_origin + depths[ray] * scratch.directions[ray];
+			scratch.set_point(k, hits[ray].pos);
+		}
+		evaluate_batch(ctx, scratch, static_cast<int>(active.size()), true);
+		scratch.ray_steps += active.size();
+
+		size_t remaining = 0;
+		for (size_t k = 0; k < active.size(); k++) {
+			const int ray = active[k];
+			RayHit& hit = hits[ray];
+			hit.orbit_trap_dist = std::min(hit.orbit_trap_dist, scratch.orbit_trap_dist[k]);
+
+			const float dist = scratch.dist[k];
+			depths[ray] += dist;
+
+			bool stop;
+			if (depths[ray] > s.max_distance) {
+				hit.exceeded_max_distance = true;
+				stop = true;
+			} else if (s.background_type == background_type_dynamic) {
+				stop = (dist < s.epsilon || dist > 20.0f) && i > 2;
+			} else {
+				stop = dist < s.epsilon;
+			}
+
+			if (stop) {
+				hit.ray_progress = 1.0f - static_cast<float>(i) / static_cast<float>(s.step_limit);
+			} else {
+				active[remaining++] = ray;
+			}
+		}
+		active.resize(remaining);
+	}
+
+	for (const int ray : active) {
+		hits[ray].ray_progress = 0.0f;
+	}
+}
+
+// Fills scratch.normals for scratch.lit_pixels, matching calculate_normal() in shader.frag. The
+// finite-difference taps of all pixels are evaluated in one batch.
+void calculate_normals(const FrameContext& ctx, TileScratch& scratch) {
+	const size_t count = scratch.lit_pixels.size();
+	scratch.normals.resize(count);
+
+	const bool analytic = formula_info(ctx.params.formula).analytic_normal;
+	if (ctx.settings.normal_method == normal_method_analytic && analytic) {
+		const MandelbulbParams& params = ctx.params.mandelbulb;
+		for (size_t k = 0; k < count; k++) {
+			const glm::vec3 pos = scratch.hits[scratch.lit_pixels[k]].pos;
+			scratch.normals[k] = mandelbulb_analytic_normal(pos, params.power, params.iterations, params.escape_radius);
+		}
+		return;
+	}
+
+	// Formulas without an analytic normal use central differences
+	const int method = ctx.settings.normal_method == normal_method_analytic ? normal_method_central_differences : ctx.settings.normal_method;
+	const std::span<const glm::vec3> taps = normal_taps(method);
+	const size_t tap_count = taps.size();
+	scratch.resize_batch(count * tap_count);
+
+	for (size_t k = 0; k < count; k++) {
+		const glm::vec3 pos = scratch.hits[scratch.lit_pixels[k]].pos;
+		for (size_t tap = 0; tap < tap_count; tap++) {
+			scratch.set_point(k * tap_count + tap, pos + normal_epsilon * taps[tap]);
+		}
+	}
+	evaluate_batch(ctx, scratch, static_cast<int>(count * tap_count), false);
+
+	for (size_t k = 0; k < count; k++) {
+		glm::vec3 sum(0.0f);
+		for (size_t tap = 0; tap < tap_count; tap++) {
+			sum += taps[tap] * scratch.dist[k * tap_count + tap];
+		}
+		scratch.normals[k] = glm::normalize(sum);
+	}
+}
+
+// Fills scratch.shadow_rays with the shadow factor for scratch.lit_pixels, matching soft_shadow() in shader.frag.
+void soft_shadows(const FrameContext& ctx, TileScratch& scratch) {
+	const AppSettings& s = ctx.settings;
+	constexpr float epsilon = 0.001f;
+	const size_t count = scratch.lit_pixels.size();
+	std::vector<ShadowRay>& rays = scratch.shadow_rays;
+	std::vector<int>& active = scratch.active;
+
+	rays.resize(count);
+	active.clear();
+	for (size_t k = 0; k < count; k++) {
+		const glm::vec3 origin = scratch.hits[scratch.lit_pixels[k]].pos;
+		rays[k] = ShadowRay{origin, glm::normalize(s.light_pos - origin), s.shadow_min_distance, glm::length(s.light_pos - origin), 1.0f};
+		if (rays[k].current_dist < rays[k].max_dist) {
+			active.push_back(static_cast<int>(k));
+		}
+	}
+	scratch.resize_batch(count);
+
+	for (int i = 0; i < s.shadow_max_iterations && !active.empty(); i++) {
+		for (size_t k = 0; k < active.size(); k++) {
+			const ShadowRay& ray = rays[active[k]];
+			scratch.set_point(k, ray.origin + ray.current_dist * ray.direction);
+		}
+		evaluate_batch(ctx, scratch, static_cast<int>(active.size()), false);
+
+		size_t remaining = 0;
+		for (size_t k = 0; k < active.size(); k++) {
+			ShadowRay& ray = rays[active[k]];
+			const float surface_dist = scratch.dist[k];
+
+			if (surface_dist < epsilon) {
+				ray.result = 0.0f;
+				continue;
+			}
+
+			ray.result = std::min(ray.result, s.shadow_softness * surface_dist / ray.current_dist);
+			ray.current_dist += std::clamp(surface_dist, s.shadow_min_step_size, s.shadow_max_step_size);
+
+			if (ray.current_dist < ray.max_dist) {
+				active[remaining++] = active[k];
+			}
+		}
+		active.resize(remaining);
+	}
+
+	for (ShadowRay& ray : rays) {
+		const float result = std::max(ray.result, -1.0f);
+		ray.result = 0.25f * (1.0f + result) * (1.0f + result) * (2.0f - result);
+	}
+}
+
+glm::vec3 blinn_phong(const FrameContext& ctx, const glm::vec3 color, const glm::vec3 pos, const glm::vec3 normal) {
+	const AppSettings& s = ctx.settings;
+	const auto light_color = glm::vec3(1.0f, 1.0f, 1.0f);
+	const auto spec_color = glm::vec3(1.0f, 1.0f, 1.0f);
+	constexpr float gamma = 2.2f;
+
+	const glm::vec3 light_dir = glm::normalize(s.light_pos - pos);
+	const glm::vec3 view_dir = glm::normalize(ctx.camera_pos - pos);
+	const glm::vec3 half_dir = glm::normalize(light_dir + view_dir);
+
+	const glm::vec3 ambient = s.ambient_strength * color;
+
+	const float diff = std::max(glm::dot(normal, light_dir), 0.0f);
+	const glm::vec3 diffuse = s.diffuse_strength * diff * color * light_color * s.light_power;
+
+	const float spec = std::pow(std::max(glm::dot(normal, half_dir), 0.0f), s.specular_shininess);
+	const glm::vec3 specular = s.specular_strength * spec * spec_color * light_color * s.light_power;
+
+	const glm::vec3 result = ambient + diffuse + specular;
+	return glm::pow(result, glm::vec3(1.0f / gamma));
+}
+
+// Matches a GL_LINEAR, GL_CLAMP_TO_EDGE lookup into the 1D gradient texture.
+glm::vec3 sample_gradient(const FrameContext& ctx, const float position) {
+	const int texel_count = static_cast<int>(ctx.gradient.size() / 3);
+	const float u = std::clamp(position, 0.0f, 1.0f) * static_cast<float>(texel_count) - 0.5f;
+	const float u_floor = std::floor(u);
+	const float t = u - u_floor;
+	const int i0 = std::clamp(static_cast<int>(u_floor), 0, texel_count - 1);
+	const int i1 = std::clamp(static_cast<int>(u_floor) + 1, 0, texel_count - 1);
+
+	const glm::vec3 c0(ctx.gradient[i0 * 3], ctx.gradient[i0 * 3 + 1], ctx.gradient[i0 * 3 + 2]);
+	const glm::vec3 c1(ctx.gradient[i1 * 3], ctx.gradient[i1 * 3 + 1], ctx.gradient[i1 * 3 + 2]);
+	return glm::mix(c0, c1, t) / 255.0f;
+}
+
+unsigned char to_unorm8(const float value) {
+	if (!std::isfinite(value)) {
+		return 0;
+	}
+	return static_cast<unsigned char>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+// Distance along ray_direction to where the ray enters the light sphere, or -1 if it misses it,
+// matching light_intersection() in shader.frag.
+float light_intersection(const AppSettings& s, const glm::vec3 ray_origin, const glm::vec3 ray_direction) {
+	const glm::vec3 offset = ray_origin - s.light_pos;
+	const float b = glm::dot(offset, ray_direction);
+	const float c = glm::dot(offset, offset) - s.light_radius * s.light_radius;
+	const float h = b * b - c;
+	if (h < 0.0f) return -1.0f;
+	return -b - std::sqrt(h);
+}
+
+// Renders the part of tile inside the region.
+void render_tile(const FrameContext& ctx, TileScratch& scratch, const Tile& tile, std::vector<unsigned char>& pixels) {
+	const AppSettings& s = ctx.settings;
+	const int tile_x = tile.x;
+	const int tile_y = tile.y;
+	const int tile_width = std::min(tile.size, ctx.region.x + ctx.region.width - tile_x);
+	const int tile_height = std::min(tile.size, ctx.region.y + ctx.region.height - tile_y);
+	// Bottom row of the tile, measured from the bottom-left corner like gl_FragCoord.
+	const int y0 = ctx.height - tile_y - tile_height;
+
+	// Normal visualization stands in for dFdx/dFdy by also marching one column to the right
+	// and one row above the tile.
+	const int border = s.enable_normal_visualization ? 1 : 0;
+	const int columns = tile_width + border;
+	const int rows = tile_height + border;
+
+	scratch.directions.resize(static_cast<size_t>(columns) * rows);
+	for (int row = 0; row < rows; row++) {
+		const float ndc_y = (static_cast<float>(y0 + row) + 0.5f) / static_cast<float>(ctx.height) * 2.0f - 1.0f;
+		for (int column = 0; column < columns; column++) {
+			const float ndc_x = (static_cast<float>(tile_x + column) + 0.5f) / static_cast<float>(ctx.width) * 2.0f - 1.0f;
+			scratch.directions[row * columns + column] = ray_direction(ctx, ndc_x, ndc_y);
+		}
+	}
+	march_rays(ctx, scratch);
+
+	// Base color and noise
+	scratch.colors.resize(static_cast<size_t>(tile_width) * tile_height);
+	scratch.lit_pixels.clear();
+	for (int row = 0; row < tile_height; row++) {
+		for (int column = 0; column < tile_width; column++) {
+			const int ray = row * columns + column;
+			const RayHit& hit = scratch.hits[ray];
+			const glm::vec3& current_pos = hit.pos;
+			glm::vec3& color = scratch.colors[row * tile_width + column];
+
+			// The light is not marched, so it is drawn where its sphere is in front of the hit
+			const float light_depth = s.show_light ? light_intersection(s, ctx.ray_origin, scratch.directions[ray]) : -1.0f;
+			const bool hit_light = light_depth >= 0.0f && (hit.exceeded_max_distance || light_depth < glm::length(current_pos - ctx.ray_origin));
+
+			if (s.enable_step_heatmap) {
+				const float steps = (1.0f - hit.ray_progress) * static_cast<float>(s.step_limit);
+				color = sample_gradient(ctx, steps / static_cast<float>(std::max(s.heatmap_max_steps, 1)));
+			} else if (hit_light && !s.enable_normal_visualization) {
+				color = ctx.light_color;
+			} else if (s.background_type == background_type_solid && (hit.exceeded_max_distance || hit.ray_progress < s.ray_hit_threshold)) {
+				color = ctx.background_color;
+			} else if (s.enable_normal_visualization) {
+				const glm::vec3 dx = scratch.hits[ray + 1].pos - current_pos;
+				const glm::vec3 dy = scratch.hits[ray + columns].pos - current_pos;
+				const glm::vec3 surface_normal = glm::normalize(glm::cross(dx, dy));
+				color = (surface_normal + 1.0f) * 0.5f;
+			} else {
+				if (s.coloring_method == coloring_method_orbit_trap) {
+					color = sample_gradient(ctx, hit.orbit_trap_dist);
+				} else {
+					color = sample_gradient(ctx, hit.ray_progress);
+				}
+				if (s.apply_noise) {
+					const float noise_1 = snoise(current_pos * 2.0f * s.noise_scale) * s.noise_amplitude;
+					const float noise_2 = snoise(current_pos * 8.0f * s.noise_scale) * s.noise_amplitude;
+					const float noise = glm::mix(noise_1, noise_2, 0.1f) * s.noise_amplitude;
+					color -= noise;
+				}
+				scratch.lit_pixels.push_back(ray);
+			}
+		}
+	}
+
+	// Lighting of the surface pixels
+	if (s.apply_blinn_phong) {
+		calculate_normals(ctx, scratch);
+	}
+	if (s.apply_soft_shadow) {
+		soft_shadows(ctx, scratch);
+	}
+	for (size_t k = 0; k < scratch.lit_pixels.size(); k++) {
+		const int ray = scratch.lit_pixels[k];
+		const RayHit& hit = scratch.hits[ray];
+		glm::vec3& color = scratch.colors[(ray / columns) * tile_width + ray % columns];
+
+		if (s.apply_blinn_phong) {
+			color = blinn_phong(ctx, color, hit.pos, scratch.normals[k]);
+		}
+		if (s.apply_soft_shadow) {
+			color *= scratch.shadow_rays[k].result;
+		}
+		if (s.apply_bloom) {
+			const float bloom_intensity = std::exp(-hit.ray_progress * s.bloom_intensity_factor);
+			color = glm::mix(color, ctx.bloom_color, bloom_intensity);
+		}
+		if (s.apply_ambient_occlusion) {
+			color = glm::mix(0.5f * color, color, hit.ray_progress);
+		}
+	}
+
+	for (int row = 0; row < tile_height; row++) {
+		const int region_row = tile_y + tile_height - 1 - row - ctx.region.y;
+		for (int column = 0; column < tile_width; column++) {
+			const glm::vec3& color = scratch.colors[row * tile_width + column];
+			unsigned char* pixel = &pixels[(static_cast<size_t>(region_row) * ctx.region.width + tile_x - ctx.region.x + column) * 3];
+			pixel[0] = to_unorm8(color.x);
+			pixel[1] = to_unorm8(color.y);
+			pixel[2] = to_unorm8(color.z);
+		}
+	}
+}
+
+}
+
+CpuRenderer::CpuRenderer(const unsigned int thread_count)
+	: thread_count(thread_count != 0 ? thread_count : std::max(1u, std::thread::hardware_concurrency())) {
+
+}
+
+std::vector<unsigned char> CpuRenderer::render(const AppSettings& settings, const Camera& camera,
+	const std::vector<unsigned char>& gradient, const int width, const int height) {
+	return render(settings, camera, gradient, width, height, ImageRegion{0, 0, width, height});
+}
+
+std::vector<unsigned char> CpuRenderer::render(const AppSettings& settings, const Camera& camera,
+	const std::vector<unsigned char>& gradient, const int width, const int height, const ImageRegion& region) {
+	const float aspect_ratio = static_cast<float>(width) / static_cast<float>(height);
+	const glm::mat4 projection_matrix = glm::perspective(glm::radians(camera.zoom), aspect_ratio, 0.1f, 100.0f);
+	const glm::mat4 inverse_view_matrix = glm::inverse(camera.view_matrix());
+	const glm::mat4 inverse_projection_matrix = glm::inverse(projection_matrix);
+	const glm::vec3 camera_world_pos = glm::vec3(inverse_view_matrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+
+	const FrameContext ctx{
+		settings,
+		gradient,
+		make_fractal_params(settings),
+		width,
+		height,
+		region,
+		camera.position,
+		camera_world_pos,
+		glm::vec3(settings.background_color[0], settings.background_color[1], settings.background_color[2]),
+		glm::vec3(settings.light_color[0], settings.light_color[1], settings.light_color[2]),
+		glm::vec3(settings.bloom_color[0], settings.bloom_color[1], settings.bloom_color[2]),
+		corner_ray_direction(inverse_view_matrix, inverse_projection_matrix, camera_world_pos, -1.0f, -1.0f),
+		corner_ray_direction(inverse_view_matrix, inverse_projection_matrix, camera_world_pos, 1.0f, -1.0f),
+		corner_ray_direction(inverse_view_matrix, inverse_projection_matrix, camera_world_pos, -1.0f, 1.0f),
+		corner_ray_direction(inverse_view_matrix, inverse_projection_matrix, camera_world_pos, 1.0f, 1.0f)
+	};
+
+	std::vector<unsigned char> pixels(static_cast<size_t>(region.width) * region.height * 3);
+	std::vector<TileScratch> scratches(thread_count);
+
+	const auto start_time = std::chrono::steady_clock::now();
+	scheduler.run(width, height, region, thread_count, [&](const unsigned int worker, const Tile& tile) {
+		render_tile(ctx, scratches[worker], tile, pixels);
+	});
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+
+	unsigned long long ray_steps = 0;
+	for (const TileScratch& scratch : scratches) {
+		ray_steps += scratch.ray_steps;
+	}
+
+	last_stats.width = region.width;
+	last_stats.height = region.height;
+	last_stats.thread_count = thread_count;
+	last_stats.seconds = elapsed.count();
+	last_stats.pixels_per_second = static_cast<double>(region.width) * region.height / std::max(elapsed.count(), 1e-9);
+	last_stats.pixels_per_second_per_core = last_stats.pixels_per_second / thread_count;
+	last_stats.ray_steps = ray_steps;
+	last_stats.ray_steps_per_pixel = static_cast<double>(last_stats.ray_steps) / (static_cast<double>(region.width) * region.height);
+
+	last_stats.tile_count = scheduler.get_tile_count();
+	last_stats.cost_history = scheduler.used_cost_history();
+	last_stats.threads = scheduler.worker_stats();
+	last_stats.stolen_tiles = 0;
+	last_stats.mean_utilization = 0.0;
+	last_stats.min_utilization = 1.0;
+	for (const TileWorkerStats& worker : last_stats.threads) {
+		last_stats.stolen_tiles += worker.stolen_tiles;
+		last_stats.mean_utilization += worker.utilization / thread_count;
+		last_stats.min_utilization = std::min(last_stats.min_utilization, worker.utilization);
+	}
+
+	return pixels;
+}
+
+const CpuRenderStats& CpuRenderer::stats() const {
+	return last_stats;
+}
+
+unsigned int CpuRenderer::get_thread_count() const {
+	return thread_count;
+}
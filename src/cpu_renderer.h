@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+
+#include "app_settings.h"
+#include "camera.h"
+#include "image_writer.h"
+#include "tile_scheduler.h"
+
+struct CpuRenderStats {
+	int width = 0;
+	int height = 0;
+	unsigned int thread_count = 0;
+	double seconds = 0.0;
+	double pixels_per_second = 0.0;
+	double pixels_per_second_per_core = 0.0;
+	// Distance estimates taken by camera rays, not counting normals and shadows
+	unsigned long long ray_steps = 0;
+	double ray_steps_per_pixel = 0.0;
+
+	// Scheduling
+	int tile_count = 0;
+	// Whether tiles were subdivided by the render times of the previous frame of the same region
+	bool cost_history = false;
+	int stolen_tiles = 0;
+	double mean_utilization = 0.0;
+	double min_utilization = 0.0;
+	std::vector<TileWorkerStats> threads;
+};
+
+// Multithreaded CPU reference implementation of shaders/shader.vert and shaders/shader.frag.
+// The frame is split into square tiles that a TileScheduler distributes over worker threads.
+class CpuRenderer {
+public:
+	static constexpr int tile_size = 32;
+
+	explicit CpuRenderer(unsigned int thread_count = 0);
+
+	// Returns tightly packed, top-down 8-bit RGB pixels. The gradient is the 256 * 3 byte LUT
+	// produced by GradientEditor::generate_gradient().
+	[[nodiscard]] std::vector<unsigned char> render(const AppSettings& settings, const Camera& camera,
+		const std::vector<unsigned char>& gradient, int width, int height);
+	// Renders only region of the width x height image, as tightly packed, top-down rows of region.width
+	// pixels. Joining the regions of an image gives the same pixels as rendering it whole.
+	[[nodiscard]] std::vector<unsigned char> render(const AppSettings& settings, const Camera& camera,
+		const std::vector<unsigned char>& gradient, int width, int height, const ImageRegion& region);
+	[[nodiscard]] const CpuRenderStats& stats() const;
+	[[nodiscard]] unsigned int get_thread_count() const;
+
+private:
+	unsigned int thread_count;
+	TileScheduler scheduler{tile_size};
+	CpuRenderStats last_stats;
+};
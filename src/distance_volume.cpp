@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+#include "distance_volume.h"
+
+namespace {
+
+constexpr int samples_per_brick = distance_volume_brick_samples * distance_volume_brick_samples * distance_volume_brick_samples;
+
+// Per-thread positions and estimates of one batch
+struct BakeScratch {
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	std::vector<float> dist;
+
+	explicit BakeScratch(const int size) : x(size), y(size), z(size), dist(size) {}
+};
+
+// Interior points and the origin give infinite or undefined estimates. Both are on or inside the
+// surface, where the exact estimator takes over anyway.
+float sanitize(const float dist) {
+	return std::isfinite(dist) ? std::max(dist, -distance_volume_extent) : 0.0f;
+}
+
+// Runs function(i, scratch) for i in [0, count) on thread_count threads pulling from a shared
+// counter, and returns false if cancel was set before all of them ran.
+template <typename Function>
+bool parallel_for(const unsigned int thread_count, const int count, const int scratch_size, const std::atomic<bool>& cancel, Function function) {
+	std::atomic<int> next = 0;
+	auto worker = [&] {
+		BakeScratch scratch(scratch_size);
+		for (int i = next++; i < count && !cancel; i = next++) {
+			function(i, scratch);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 1; i < thread_count; i++) {
+		workers.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& thread : workers) {
+		thread.join();
+	}
+	return !cancel;
+}
+
+}
+
+bool bake_distance_volume(const FractalParams& params, const int resolution, unsigned int thread_count,
+	const std::atomic<bool>& cancel, DistanceVolume& volume) {
+	const auto start_time = std::chrono::steady_clock::now();
+	if (thread_count == 0) {
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	const int grid_size = std::max(resolution / distance_volume_brick_size, 1);
+	const int brick_total = grid_size * grid_size * grid_size;
+	const float brick_edge = 2.0f * distance_volume_extent / static_cast<float>(grid_size);
+	const float voxel_size = brick_edge / distance_volume_brick_size;
+	// A brick that is not sampled must keep every point in it out of the exact band, with a voxel
+	// to spare for the filtering error of the sampled bricks next to it.
+	const float near_distance = brick_edge * std::sqrt(3.0f) * 0.5f + (distance_volume_exact_band + 1) * voxel_size;
+
+	volume.params = params;
+	volume.resolution = grid_size * distance_volume_brick_size;
+	volume.grid_size = grid_size;
+	volume.indirection.assign(static_cast<size_t>(brick_total) * 2, -1.0f);
+
+	// Estimates at the brick centers, a slice of bricks at a time
+	const bool centers_done = parallel_for(thread_count, grid_size, grid_size * grid_size, cancel, [&](const int z, BakeScratch& scratch) {
+		for (int y = 0; y < grid_size; y++) {
+			for (int x = 0; x < grid_size; x++) {
+				const int i = y * grid_size + x;
+				scratch.x[i] = (static_cast<float>(x) + 0.5f) * brick_edge - distance_volume_extent;
+				scratch.y[i] = (static_cast<float>(y) + 0.5f) * brick_edge - distance_volume_extent;
+				scratch.z[i] = (static_cast<float>(z) + 0.5f) * brick_edge - distance_volume_extent;
+			}
+		}
+		fractal_batch(scratch.x.data(), scratch.y.data(), scratch.z.data(), grid_size * grid_size, params, scratch.dist.data());
+		for (int i = 0; i < grid_size * grid_size; i++) {
+			volume.indirection[(static_cast<size_t>(z) * grid_size * grid_size + i) * 2 + 1] = sanitize(scratch.dist[i]);
+		}
+	});
+	if (!centers_done) {
+		return false;
+	}
+
+	std::vector<int> near_bricks;
+	for (int brick = 0; brick < brick_total; brick++) {
+		if (volume.indirection[static_cast<size_t>(brick) * 2 + 1] < near_distance) {
+			volume.indirection[static_cast<size_t>(brick) * 2] = static_cast<float>(near_bricks.size());
+			near_bricks.push_back(brick);
+		}
+	}
+
+	const int brick_count = static_cast<int>(near_bricks.size());
+	const int atlas_layer_bricks = distance_volume_atlas_bricks * distance_volume_atlas_bricks;
+	// At least one brick, so that the atlas texture is never empty
+	const int atlas_bricks_x = std::clamp(brick_count, 1, distance_volume_atlas_bricks);
+	const int atlas_bricks_y = std::clamp((brick_count + distance_volume_atlas_bricks - 1) / distance_volume_atlas_bricks, 1, distance_volume_atlas_bricks);
+	const int atlas_bricks_z = std::max((brick_count + atlas_layer_bricks - 1) / atlas_layer_bricks, 1);
+	volume.atlas_width = atlas_bricks_x * distance_volume_brick_samples;
+	volume.atlas_height = atlas_bricks_y * distance_volume_brick_samples;
+	volume.atlas_depth = atlas_bricks_z * distance_volume_brick_samples;
+	volume.atlas.assign(static_cast<size_t>(volume.atlas_width) * volume.atlas_height * volume.atlas_depth, 0.0f);
+	volume.brick_count = brick_count;
+
+	const bool bricks_done = parallel_for(thread_count, brick_count, samples_per_brick, cancel, [&](const int index, BakeScratch& scratch) {
+		const int brick = near_bricks[index];
+		const glm::vec3 origin = glm::vec3(brick % grid_size, brick / grid_size % grid_size, brick / (grid_size * grid_size)) * brick_edge - distance_volume_extent;
+		for (int i = 0; i < samples_per_brick; i++) {
+			scratch.x[i] = origin.x + static_cast<float>(i % distance_volume_brick_samples) * voxel_size;
+			scratch.y[i] = origin.y + static_cast<float>(i / distance_volume_brick_samples % distance_volume_brick_samples) * voxel_size;
+			scratch.z[i] = origin.z + static_cast<float>(i / (distance_volume_brick_samples * distance_volume_brick_samples)) * voxel_size;
+		}
+		fractal_batch(scratch.x.data(), scratch.y.data(), scratch.z.data(), samples_per_brick, params, scratch.dist.data());
+
+		const int atlas_x = index % distance_volume_atlas_bricks * distance_volume_brick_samples;
+		const int atlas_y = index / distance_volume_atlas_bricks % distance_volume_atlas_bricks * distance_volume_brick_samples;
+		const int atlas_z = index / atlas_layer_bricks * distance_volume_brick_samples;
+		for (int z = 0; z < distance_volume_brick_samples; z++) {
+			for (int y = 0; y < distance_volume_brick_samples; y++) {
+				const size_t row = (static_cast<size_t>(atlas_z + z) * volume.atlas_height + atlas_y + y) * volume.atlas_width + atlas_x;
+				const int sample = (z * distance_volume_brick_samples + y) * distance_volume_brick_samples;
+				for (int x = 0; x < distance_volume_brick_samples; x++) {
+					volume.atlas[row + x] = sanitize(scratch.dist[sample + x]);
+				}
+			}
+		}
+	});
+	if (!bricks_done) {
+		return false;
+	}
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+	volume.bake_time = elapsed.count();
+	return true;
+}
+
+DistanceVolumeBaker::DistanceVolumeBaker() {
+	// Started once every member it uses is constructed
+	thread = std::thread(&DistanceVolumeBaker::work, this);
+}
+
+DistanceVolumeBaker::~DistanceVolumeBaker() {
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+		cancel = true;
+	}
+	requested.notify_one();
+	thread.join();
+}
+
+void DistanceVolumeBaker::request(const FractalParams& params, const int resolution) {
+	{
+		std::lock_guard lock(mutex);
+		if (resolution == request_resolution && params == request_params) {
+			return;
+		}
+		request_params = params;
+		request_resolution = resolution;
+		has_request = true;
+		baking = true;
+		result.reset();
+		cancel = true;
+	}
+	requested.notify_one();
+}
+
+std::unique_ptr<DistanceVolume> DistanceVolumeBaker::take_result() {
+	std::lock_guard lock(mutex);
+	return std::move(result);
+}
+
+bool DistanceVolumeBaker::is_baking() const {
+	std::lock_guard lock(mutex);
+	return baking;
+}
+
+void DistanceVolumeBaker::work() {
+	std::unique_lock lock(mutex);
+	while (true) {
+		requested.wait(lock, [this] { return stopping || has_request; });
+		if (stopping) {
+			return;
+		}
+		const FractalParams params = request_params;
+		const int resolution = request_resolution;
+		has_request = false;
+		cancel = false;
+		lock.unlock();
+
+		auto volume = std::make_unique<DistanceVolume>();
+		const bool finished = bake_distance_volume(params, resolution, 0, cancel, *volume);
+
+		lock.lock();
+		// A newer request cancels the bake, or finished it just too late
+		if (finished && !has_request) {
+			result = std::move(volume);
+			baking = false;
+		}
+	}
+}
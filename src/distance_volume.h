@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "formula.h"
+
+// Half the edge of the cube around the origin that distance volumes cover. The constants below
+// must match their counterparts in shaders/shader.frag.
+constexpr float distance_volume_extent = 2.0f;
+// Voxels along each edge of a brick. A brick stores a sample at every voxel corner, one more than
+// its voxels per edge, so that it can be filtered without its neighbors.
+constexpr int distance_volume_brick_size = 8;
+constexpr int distance_volume_brick_samples = distance_volume_brick_size + 1;
+// Bricks per row and per column of the atlas; further bricks go into more layers.
+constexpr int distance_volume_atlas_bricks = 32;
+// Within this many voxels of the surface, rays evaluate the exact distance estimator.
+constexpr int distance_volume_exact_band = 3;
+// Voxels along each edge of the volume that can be selected
+constexpr int distance_volume_resolutions[] = {128, 256, 512};
+
+// Distance estimates of a fractal sampled in a sparse grid of bricks. Only the bricks that
+// the surface may pass near are sampled; every other brick only stores the estimate at its center,
+// which bounds the distance anywhere in the brick.
+struct DistanceVolume {
+	FractalParams params{};
+	// Voxels along each edge
+	int resolution = 0;
+	// Bricks along each edge
+	int grid_size = 0;
+	// Two floats per brick, x fastest: the index of the brick in the atlas or -1 if it was not
+	// sampled, and the distance estimate at its center.
+	std::vector<float> indirection;
+	// Samples of the bricks, x fastest, with the bricks laid out as in the atlas texture
+	std::vector<float> atlas;
+	int atlas_width = 0;
+	int atlas_height = 0;
+	int atlas_depth = 0;
+	int brick_count = 0;
+	double bake_time = 0.0; // seconds
+};
+
+// Samples the volume on thread_count threads, or one per core if it is 0, with the batched
+// distance estimator. Returns false, leaving volume incomplete, as soon as cancel is set.
+bool bake_distance_volume(const FractalParams& params, int resolution, unsigned int thread_count,
+	const std::atomic<bool>& cancel, DistanceVolume& volume);
+
+// Bakes distance volumes on a background thread. A request for other parameters abandons the bake
+// in progress, so only the volume of the latest request is ever finished.
+class DistanceVolumeBaker {
+public:
+	DistanceVolumeBaker();
+	~DistanceVolumeBaker();
+
+	DistanceVolumeBaker(const DistanceVolumeBaker&) = delete;
+	DistanceVolumeBaker& operator=(const DistanceVolumeBaker&) = delete;
+
+	// Starts a bake unless params and resolution are those of the last request.
+	void request(const FractalParams& params, int resolution);
+	// Returns the volume of the last request once it is finished, and null until then or after it
+	// was taken.
+	[[nodiscard]] std::unique_ptr<DistanceVolume> take_result();
+	[[nodiscard]] bool is_baking() const;
+
+private:
+	std::thread thread;
+	mutable std::mutex mutex;
+	std::condition_variable requested;
+	FractalParams request_params{};
+	int request_resolution = 0;
+	bool has_request = false;
+	bool baking = false;
+	bool stopping = false;
+	std::atomic<bool> cancel = false;
+	std::unique_ptr<DistanceVolume> result;
+
+	void work();
+};
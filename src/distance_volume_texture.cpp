@@ -0,0 +1,74 @@
+#include "distance_volume_texture.h"
+
+static void set_parameters(const GLuint texture, const GLint filter) {
+	glBindTexture(GL_TEXTURE_3D, texture);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, filter);
+}
+
+DistanceVolumeTexture::DistanceVolumeTexture() {
+	glGenTextures(1, &indirection_texture);
+	glGenTextures(1, &atlas_texture);
+	set_parameters(indirection_texture, GL_NEAREST);
+	set_parameters(atlas_texture, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+DistanceVolumeTexture::~DistanceVolumeTexture() {
+	glDeleteTextures(1, &indirection_texture);
+	glDeleteTextures(1, &atlas_texture);
+}
+
+void DistanceVolumeTexture::upload(const DistanceVolume& volume) {
+	const int grid_size = volume.grid_size;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_3D, indirection_texture);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_RG32F, grid_size, grid_size, grid_size, 0, GL_RG, GL_FLOAT, volume.indirection.data());
+	// Half floats keep the relative precision that matters near the surface
+	glBindTexture(GL_TEXTURE_3D, atlas_texture);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_R16F, volume.atlas_width, volume.atlas_height, volume.atlas_depth, 0, GL_RED, GL_FLOAT, volume.atlas.data());
+	glBindTexture(GL_TEXTURE_3D, 0);
+
+	uploaded = true;
+	uploaded_params = volume.params;
+	uploaded_resolution = volume.resolution;
+	brick_count = volume.brick_count;
+	bake_time = volume.bake_time;
+	size = static_cast<size_t>(grid_size) * grid_size * grid_size * 2 * sizeof(float)
+		+ static_cast<size_t>(volume.atlas_width) * volume.atlas_height * volume.atlas_depth * sizeof(GLhalf);
+}
+
+void DistanceVolumeTexture::bind(const GLuint indirection_unit, const GLuint atlas_unit) const {
+	glActiveTexture(GL_TEXTURE0 + indirection_unit);
+	glBindTexture(GL_TEXTURE_3D, indirection_texture);
+	glActiveTexture(GL_TEXTURE0 + atlas_unit);
+	glBindTexture(GL_TEXTURE_3D, atlas_texture);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+bool DistanceVolumeTexture::matches(const FractalParams& params, const int resolution) const {
+	return uploaded && resolution == uploaded_resolution && params == uploaded_params;
+}
+
+bool DistanceVolumeTexture::has_volume() const {
+	return uploaded;
+}
+
+int DistanceVolumeTexture::get_resolution() const {
+	return uploaded_resolution;
+}
+
+int DistanceVolumeTexture::get_brick_count() const {
+	return brick_count;
+}
+
+double DistanceVolumeTexture::get_bake_time() const {
+	return bake_time;
+}
+
+size_t DistanceVolumeTexture::get_size() const {
+	return size;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include "distance_volume.h"
+
+// A DistanceVolume as two 3D textures for shaders/shader.frag: an RG32F indirection texture with a
+// texel per brick, read with texelFetch(), and an R16F atlas of the brick samples, filtered
+// linearly. Requires a current OpenGL context.
+class DistanceVolumeTexture {
+public:
+	DistanceVolumeTexture();
+	~DistanceVolumeTexture();
+
+	DistanceVolumeTexture(const DistanceVolumeTexture&) = delete;
+	DistanceVolumeTexture& operator=(const DistanceVolumeTexture&) = delete;
+
+	void upload(const DistanceVolume& volume);
+	void bind(GLuint indirection_unit, GLuint atlas_unit) const;
+
+	// Whether a volume for params at resolution was uploaded
+	[[nodiscard]] bool matches(const FractalParams& params, int resolution) const;
+	[[nodiscard]] bool has_volume() const;
+	[[nodiscard]] int get_resolution() const;
+	[[nodiscard]] int get_brick_count() const;
+	[[nodiscard]] double get_bake_time() const;
+	// Texture memory in bytes
+	[[nodiscard]] size_t get_size() const;
+
+private:
+	GLuint indirection_texture = 0;
+	GLuint atlas_texture = 0;
+	bool uploaded = false;
+	FractalParams uploaded_params{};
+	int uploaded_resolution = 0;
+	int brick_count = 0;
+	double bake_time = 0.0;
+	size_t size = 0;
+};
@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "formula.h"
+
+namespace {
+
+constexpr float orbit_trap_radius = 0.5f;
+// The Mandelbox ignores the escape radius, since its orbits leave any small radius and come back
+constexpr float mandelbox_bailout = 1024.0f;
+
+// CPU ports of the formulas in shaders/shader.frag. Each evaluates the distance estimate from a
+// running derivative of the iteration and lowers orbit_trap_dist to the orbit's trap distance.
+struct Mandelbox {
+	static float distance(const glm::vec3 pos, const FractalParams& params, float& orbit_trap_dist) {
+		const float limit = params.mandelbox_folding_limit;
+		const float min_radius2 = params.mandelbox_min_radius * params.mandelbox_min_radius;
+		const float fixed_radius2 = params.mandelbox_fixed_radius * params.mandelbox_fixed_radius;
+		glm::vec3 z = pos;
+		float dr = 1.0f;
+
+		for (int i = 0; i < params.mandelbulb.iterations; i++) {
+			// Box fold, then sphere fold
+			z = glm::clamp(z, -limit, limit) * 2.0f - z;
+			const float r2 = glm::dot(z, z);
+			orbit_trap_dist = std::min(orbit_trap_dist, std::sqrt(r2) - orbit_trap_radius);
+			if (r2 < min_radius2) {
+				z *= fixed_radius2 / min_radius2;
+				dr *= fixed_radius2 / min_radius2;
+			} else if (r2 < fixed_radius2) {
+				z *= fixed_radius2 / r2;
+				dr *= fixed_radius2 / r2;
+			}
+
+			z = params.mandelbox_scale * z + pos;
+			dr = dr * std::abs(params.mandelbox_scale) + 1.0f;
+			if (glm::dot(z, z) > mandelbox_bailout * mandelbox_bailout) break;
+		}
+		return glm::length(z) / std::abs(dr);
+	}
+};
+
+struct MengerSponge {
+	static float distance(const glm::vec3 pos, const FractalParams& params, float& orbit_trap_dist) {
+		glm::vec3 z = pos;
+		float scale = 1.0f;
+
+		for (int i = 0; i < params.mandelbulb.iterations; i++) {
+			// Folds every octant and permutation onto x >= y >= z >= 0, then scales the corner cube
+			// of the 20 that remain up to the whole
+			z = glm::abs(z);
+			if (z.x < z.y) std::swap(z.x, z.y);
+			if (z.x < z.z) std::swap(z.x, z.z);
+			if (z.y < z.z) std::swap(z.y, z.z);
+			z = z * 3.0f - 2.0f;
+			if (z.z < -1.0f) z.z += 2.0f;
+			scale *= 3.0f;
+			orbit_trap_dist = std::min(orbit_trap_dist, glm::length(z) - orbit_trap_radius);
+		}
+
+		// Distance to the cube from -1 to 1, in the scale of pos
+		const glm::vec3 d = glm::abs(z) - 1.0f;
+		const float box = std::min(std::max(d.x, std::max(d.y, d.z)), 0.0f) + glm::length(glm::max(d, glm::vec3(0.0f)));
+		return box / scale;
+	}
+};
+
+struct QuaternionJulia {
+	static float distance(const glm::vec3 pos, const FractalParams& params, float& orbit_trap_dist) {
+		glm::vec4 z(pos, 0.0f);
+		// Squared length of the derivative of z
+		float dz2 = 1.0f;
+		float r2 = glm::dot(z, z);
+
+		for (int i = 0; i < params.mandelbulb.iterations; i++) {
+			dz2 *= 4.0f * r2;
+			z = glm::vec4(z.x * z.x - z.y * z.y - z.z * z.z - z.w * z.w, 2.0f * z.x * z.y, 2.0f * z.x * z.z, 2.0f * z.x * z.w) + params.julia_c;
+			r2 = glm::dot(z, z);
+			orbit_trap_dist = std::min(orbit_trap_dist, std::sqrt(r2) - orbit_trap_radius);
+			if (r2 > params.mandelbulb.escape_radius * params.mandelbulb.escape_radius) break;
+		}
+		const float r = std::sqrt(r2);
+		return 0.5f * r * std::log(r) / std::sqrt(dz2);
+	}
+};
+
+// Specializes the batch loop on the formula, so points never branch on it
+template <typename F>
+void formula_kernel(const float* x, const float* y, const float* z, const int count, const FractalParams& params,
+	float* dist, float* orbit_trap_dist) {
+	for (int i = 0; i < count; i++) {
+		float trap = 1e20f;
+		dist[i] = F::distance(glm::vec3(x[i], y[i], z[i]), params, trap);
+		if (orbit_trap_dist) {
+			orbit_trap_dist[i] = trap;
+		}
+	}
+}
+
+void mandelbulb_kernel(const float* x, const float* y, const float* z, const int count, const FractalParams& params,
+	float* dist, float* orbit_trap_dist) {
+	mandelbulb_batch(x, y, z, count, params.mandelbulb, dist, orbit_trap_dist);
+}
+
+constexpr FormulaInfo formula_infos[formula_count] = {
+	{"Mandelbulb", 2.0f, true, mandelbulb_kernel},
+	{"Mandelbox", 12.0f, false, formula_kernel<Mandelbox>},
+	{"Menger Sponge", 3.0f, false, formula_kernel<MengerSponge>},
+	{"Quaternion Julia", 2.5f, false, formula_kernel<QuaternionJulia>}
+};
+
+}
+
+FractalParams make_fractal_params(const AppSettings& settings) {
+	FractalParams params;
+	params.formula = std::clamp(settings.formula, 0, formula_count - 1);
+	params.mandelbulb = make_mandelbulb_params(settings.power, settings.max_iterations, static_cast<float>(settings.escape_radius));
+	switch (params.formula) {
+	case formula_mandelbox:
+		params.mandelbulb.power = 0.0f;
+		params.mandelbulb.integer_power = 0;
+		params.mandelbulb.escape_radius = 0.0f;
+		params.mandelbox_scale = settings.mandelbox_scale;
+		params.mandelbox_min_radius = settings.mandelbox_min_radius;
+		params.mandelbox_fixed_radius = settings.mandelbox_fixed_radius;
+		params.mandelbox_folding_limit = settings.mandelbox_folding_limit;
+		break;
+	case formula_menger_sponge:
+		params.mandelbulb.power = 0.0f;
+		params.mandelbulb.integer_power = 0;
+		params.mandelbulb.escape_radius = 0.0f;
+		break;
+	case formula_quaternion_julia:
+		params.mandelbulb.power = 0.0f;
+		params.mandelbulb.integer_power = 0;
+		params.julia_c = glm::vec4(settings.julia_c[0], settings.julia_c[1], settings.julia_c[2], settings.julia_c[3]);
+		break;
+	default:
+		break;
+	}
+	return params;
+}
+
+const FormulaInfo& formula_info(const int formula) {
+	return formula_infos[std::clamp(formula, 0, formula_count - 1)];
+}
+
+void fractal_batch(const float* x, const float* y, const float* z, const int count, const FractalParams& params,
+	float* dist, float* orbit_trap_dist) {
+	formula_info(params.formula).kernel(x, y, z, count, params, dist, orbit_trap_dist);
+}
+
+float fractal_distance(const glm::vec3 pos, const FractalParams& params) {
+	float dist = 0.0f;
+	fractal_batch(&pos.x, &pos.y, &pos.z, 1, params, &dist);
+	return dist;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "app_settings.h"
+#include "mandelbulb_simd.h"
+
+// Fractals that can be rendered, selected by AppSettings::formula. Every formula is compiled into
+// shader variants of its own with FORMULA defined to its value (see shaders/shader.frag), so
+// selecting one swaps programs and the march never branches on it. The values must match the
+// formula_ constants there.
+enum Formula {
+	formula_mandelbulb,
+	formula_mandelbox,
+	formula_menger_sponge,
+	formula_quaternion_julia,
+	formula_count
+};
+
+// Parameters of the selected formula. Members that it does not read are zero, so equal params
+// mean an equal fractal.
+struct FractalParams {
+	int formula = formula_mandelbulb;
+	// Power, iterations and escape radius. Every formula iterates max_iterations times; the
+	// Mandelbulb and the quaternion Julia set also stop at the escape radius.
+	MandelbulbParams mandelbulb{};
+	float mandelbox_scale = 0.0f;
+	float mandelbox_min_radius = 0.0f;
+	float mandelbox_fixed_radius = 0.0f;
+	float mandelbox_folding_limit = 0.0f;
+	// Constant of the quaternion Julia set
+	glm::vec4 julia_c = glm::vec4(0.0f);
+
+	bool operator==(const FractalParams&) const = default;
+};
+
+[[nodiscard]] FractalParams make_fractal_params(const AppSettings& settings);
+
+// Evaluates the distance estimate of a formula for count points given in structure-of-arrays
+// layout, and the orbit trap distance of each point's orbit if orbit_trap_dist is not null.
+using FormulaKernel = void (*)(const float* x, const float* y, const float* z, int count, const FractalParams& params,
+	float* dist, float* orbit_trap_dist);
+
+// Registry entry of a formula
+struct FormulaInfo {
+	const char* name;
+	// Distance from the origin that the default camera looks at the fractal from
+	float camera_distance;
+	// Whether calculate_normal() in shader.frag can differentiate it analytically
+	bool analytic_normal;
+	// CPU kernel matching the DE() of its shader variants
+	FormulaKernel kernel;
+};
+
+[[nodiscard]] const FormulaInfo& formula_info(int formula);
+
+// The kernel of params.formula, see FormulaKernel. The Mandelbulb uses mandelbulb_batch().
+void fractal_batch(const float* x, const float* y, const float* z, int count, const FractalParams& params,
+	float* dist, float* orbit_trap_dist = nullptr);
+[[nodiscard]] float fractal_distance(glm::vec3 pos, const FractalParams& params);
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <utility>
+
+#include "frame_writer.h"
+#include "image_writer.h"
+
+FrameWriter::FrameWriter(const unsigned int thread_count, const int max_pending) : max_pending(std::max(max_pending, 1)) {
+	for (unsigned int i = 0; i < std::max(thread_count, 1u); i++) {
+		threads.emplace_back(&FrameWriter::work, this);
+	}
+}
+
+FrameWriter::~FrameWriter() {
+	finish();
+}
+
+void FrameWriter::submit(std::string path, std::vector<unsigned char> pixels, const int width, const int height, const int channels, const bool bottom_up) {
+	std::unique_lock lock(mutex);
+	frame_taken.wait(lock, [this] { return static_cast<int>(queue.size()) < max_pending; });
+	queue.push_back({std::move(path), std::move(pixels), width, height, channels, bottom_up});
+	frame_queued.notify_one();
+}
+
+bool FrameWriter::finish() {
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+	frame_queued.notify_all();
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	threads.clear();
+	return !failed;
+}
+
+int FrameWriter::get_frames_written() const {
+	return frames_written;
+}
+
+unsigned int FrameWriter::get_thread_count() const {
+	return static_cast<unsigned int>(threads.size());
+}
+
+void FrameWriter::work() {
+	while (true) {
+		Frame frame;
+		{
+			std::unique_lock lock(mutex);
+			frame_queued.wait(lock, [this] { return stopping || !queue.empty(); });
+			if (queue.empty()) {
+				return;
+			}
+			frame = std::move(queue.front());
+			queue.pop_front();
+		}
+		frame_taken.notify_one();
+
+		if (write(frame)) {
+			frames_written++;
+		} else {
+			failed = true;
+		}
+	}
+}
+
+bool FrameWriter::write(const Frame& frame) {
+	ImageStreamWriter writer;
+	if (!writer.open(frame.path, frame.width, frame.height)) {
+		return false;
+	}
+	// Converted in batches of rows, each of which becomes one PNG data chunk
+	constexpr int batch_rows = 64;
+	const size_t row_size = static_cast<size_t>(frame.width) * 3;
+	std::vector<unsigned char> rows(row_size * std::min(batch_rows, frame.height));
+	for (int y = 0; y < frame.height; y += batch_rows) {
+		const int row_count = std::min(batch_rows, frame.height - y);
+		for (int row = 0; row < row_count; row++) {
+			const int source_row = frame.bottom_up ? frame.height - 1 - (y + row) : y + row;
+			const unsigned char* source = &frame.pixels[static_cast<size_t>(source_row) * frame.width * frame.channels];
+			unsigned char* destination = &rows[row * row_size];
+			for (int x = 0; x < frame.width; x++) {
+				destination[x * 3] = source[x * frame.channels];
+				destination[x * 3 + 1] = source[x * frame.channels + 1];
+				destination[x * 3 + 2] = source[x * frame.channels + 2];
+			}
+		}
+		if (!writer.write_rows(rows.data(), row_count)) {
+			return false;
+		}
+	}
+	return writer.close();
+}
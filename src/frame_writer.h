@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes image files on worker threads, so encoding and disk writes overlap with rendering.
+// submit() blocks while max_pending frames are queued, which bounds the memory in flight.
+class FrameWriter {
+public:
+	FrameWriter(unsigned int thread_count, int max_pending);
+	~FrameWriter();
+
+	FrameWriter(const FrameWriter&) = delete;
+	FrameWriter& operator=(const FrameWriter&) = delete;
+
+	// Queues 8-bit rows of channels (3 or 4) components, of which the first three are RGB, to be
+	// written to path with ImageStreamWriter. OpenGL reads pixels back bottom-up.
+	void submit(std::string path, std::vector<unsigned char> pixels, int width, int height, int channels, bool bottom_up);
+	// Waits until every queued frame is written and returns whether all of them were.
+	bool finish();
+
+	[[nodiscard]] int get_frames_written() const;
+	[[nodiscard]] unsigned int get_thread_count() const;
+
+private:
+	struct Frame {
+		std::string path;
+		std::vector<unsigned char> pixels;
+		int width;
+		int height;
+		int channels;
+		bool bottom_up;
+	};
+
+	int max_pending;
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable frame_queued;
+	std::condition_variable frame_taken;
+	std::deque<Frame> queue;
+	bool stopping = false;
+	std::atomic<int> frames_written = 0;
+	std::atomic<bool> failed = false;
+
+	void work();
+	static bool write(const Frame& frame);
+};
@@ -0,0 +1,85 @@
+#include <cstdio>
+#include <utility>
+
+#include "framebuffer.h"
+
+Framebuffer::Framebuffer(std::vector<GLenum> color_formats) : color_formats(std::move(color_formats)) {
+	glGenFramebuffers(1, &framebuffer_id);
+}
+
+Framebuffer::~Framebuffer() {
+	if (!textures.empty()) {
+		glDeleteTextures(static_cast<GLsizei>(textures.size()), textures.data());
+	}
+	if (framebuffer_id != 0) {
+		glDeleteFramebuffers(1, &framebuffer_id);
+		framebuffer_id = 0;
+	}
+}
+
+bool Framebuffer::resize(const int width, const int height) {
+	if (width == this->width && height == this->height) {
+		return false;
+	}
+	this->width = width;
+	this->height = height;
+
+	// Immutable storage cannot be resized, so the textures are recreated.
+	if (!textures.empty()) {
+		glDeleteTextures(static_cast<GLsizei>(textures.size()), textures.data());
+	}
+	textures.assign(color_formats.size(), 0);
+	glGenTextures(static_cast<GLsizei>(textures.size()), textures.data());
+
+	std::vector<GLenum> draw_buffers;
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id);
+	for (size_t i = 0; i < textures.size(); i++) {
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+		glTexStorage2D(GL_TEXTURE_2D, 1, color_formats[i], width, height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		const GLenum attachment = GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(i);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, textures[i], 0);
+		draw_buffers.push_back(attachment);
+	}
+	glDrawBuffers(static_cast<GLsizei>(draw_buffers.size()), draw_buffers.data());
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		fprintf(stderr, "Error: framebuffer of size %dx%d is incomplete\n", width, height);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return true;
+}
+
+void Framebuffer::bind() const {
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id);
+	glViewport(0, 0, width, height);
+}
+
+void Framebuffer::blit_to_screen(const Viewport& viewport) const {
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_id);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	const bool scaled = width != viewport.width || height != viewport.height;
+	glBlitFramebuffer(0, 0, width, height,
+		viewport.x, viewport.y, viewport.x + viewport.width, viewport.y + viewport.height,
+		GL_COLOR_BUFFER_BIT, scaled ? GL_LINEAR : GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(viewport.x, viewport.y, viewport.width, viewport.height);
+}
+
+GLuint Framebuffer::get_texture(const int attachment) const {
+	return textures[attachment];
+}
+
+int Framebuffer::get_width() const {
+	return width;
+}
+
+int Framebuffer::get_height() const {
+	return height;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "window.h"
+
+// Offscreen render target with one texture per color attachment, in the order of color_formats.
+class Framebuffer {
+public:
+	explicit Framebuffer(std::vector<GLenum> color_formats);
+	~Framebuffer();
+
+	Framebuffer(const Framebuffer&) = delete;
+	Framebuffer& operator=(const Framebuffer&) = delete;
+
+	// Reallocates the attachments if the size changed and returns whether it did, in which case
+	// their contents are undefined.
+	bool resize(int width, int height);
+	// Binds the framebuffer for drawing with a viewport covering all of it.
+	void bind() const;
+	// Copies attachment 0 into viewport of the default framebuffer, filtered if it is scaled, and
+	// binds the default framebuffer.
+	void blit_to_screen(const Viewport& viewport) const;
+
+	[[nodiscard]] GLuint get_texture(int attachment) const;
+	[[nodiscard]] int get_width() const;
+	[[nodiscard]] int get_height() const;
+
+private:
+	GLuint framebuffer_id = 0;
+	std::vector<GLenum> color_formats;
+	std::vector<GLuint> textures;
+	int width = 0;
+	int height = 0;
+};
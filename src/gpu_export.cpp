@@ -0,0 +1,77 @@
+#include <cstdio>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "gpu_export.h"
+
+GpuExport::GpuExport(const AppSettings& settings, const Camera& camera, const GradientEditor& gradient_editor, const int width, const int height, const int tile_size)
+	: settings(settings),
+	  camera(camera),
+	  gradient_editor(gradient_editor),
+	  image(width, height, tile_size),
+	  gbuffer(Renderer::make_gbuffer()),
+	  framebuffer({GL_RGBA8}),
+	  readbacks(readback_count, tile_size, tile_size) {
+
+}
+
+bool GpuExport::start(const std::string& path) {
+	failed = !image.open(path);
+	return !failed;
+}
+
+bool GpuExport::step(Renderer& renderer) {
+	if (failed) {
+		return false;
+	}
+
+	while (receive_tile(false)) {}
+	if (tiles_submitted < image.get_tile_count()) {
+		// Without a free buffer the oldest readback is waited for, which only happens when the GPU
+		// falls readback_count tiles behind.
+		if (readbacks.is_full() && !receive_tile(true)) {
+			return false;
+		}
+		submit_tile(renderer);
+	}
+	return !failed && !image.is_done();
+}
+
+bool GpuExport::finish() {
+	return image.finish() && !failed;
+}
+
+void GpuExport::submit_tile(Renderer& renderer) {
+	const ImageRegion tile = image.get_tile(tiles_submitted);
+	const float aspect_ratio = static_cast<float>(image.get_width()) / static_cast<float>(image.get_height());
+	const glm::mat4 projection_matrix = glm::perspective(glm::radians(camera.zoom), aspect_ratio, 0.1f, 100.0f);
+	renderer.render_offscreen(settings, camera, gradient_editor,
+		tile_projection(projection_matrix, image.get_width(), image.get_height(), tile),
+		tile.width, tile.height, gbuffer, framebuffer);
+	readbacks.read(tile.width, tile.height);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	tiles_submitted++;
+}
+
+// Adds the oldest pending tile to the image once its readback finished, or waits for it.
+bool GpuExport::receive_tile(const bool wait) {
+	const unsigned char* pixels = readbacks.map_oldest(wait);
+	if (!pixels) {
+		failed |= readbacks.has_failed();
+		return false;
+	}
+	if (!image.add_tile(pixels, 4, true)) {
+		fprintf(stderr, "Error: could not write export tile %d\n", image.get_tiles_done());
+		failed = true;
+	}
+	readbacks.release_oldest();
+	return !failed;
+}
+
+ExportProgress GpuExport::get_progress() const {
+	return image.get_progress();
+}
+
+const std::string& GpuExport::get_path() const {
+	return image.get_path();
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+
+#include <GL/glew.h>
+
+#include "app_settings.h"
+#include "camera.h"
+#include "framebuffer.h"
+#include "gradient_editor.h"
+#include "readback_ring.h"
+#include "renderer.h"
+#include "tiled_export.h"
+
+// Exports a still of any size with the GPU renderer, one tile per frame so the window stays
+// responsive. Tiles are rendered into framebuffers of their own and read back through a
+// ReadbackRing a few frames later, so neither the GPU nor the main thread waits for a transfer.
+// The settings, camera and gradient are captured when the export starts, so later edits do not
+// tear the image. Requires a current OpenGL context.
+class GpuExport {
+public:
+	GpuExport(const AppSettings& settings, const Camera& camera, const GradientEditor& gradient_editor, int width, int height, int tile_size);
+
+	GpuExport(const GpuExport&) = delete;
+	GpuExport& operator=(const GpuExport&) = delete;
+
+	bool start(const std::string& path);
+	// Writes out every finished readback and renders the next tile if a buffer is free. Returns
+	// false once the image is complete or the export failed.
+	bool step(Renderer& renderer);
+	// Closes the file, which fails if the export was cut short.
+	bool finish();
+
+	[[nodiscard]] ExportProgress get_progress() const;
+	[[nodiscard]] const std::string& get_path() const;
+
+private:
+	static constexpr int readback_count = 3;
+
+	AppSettings settings;
+	Camera camera;
+	GradientEditor gradient_editor;
+	TiledExport image;
+	Framebuffer gbuffer;
+	Framebuffer framebuffer;
+	ReadbackRing readbacks;
+	int tiles_submitted = 0;
+	bool failed = false;
+
+	void submit_tile(Renderer& renderer);
+	bool receive_tile(bool wait);
+};
@@ -0,0 +1,59 @@
+#include "gpu_timer.h"
+
+GpuTimer::GpuTimer() {
+	glGenQueries(query_count, queries);
+}
+
+GpuTimer::~GpuTimer() {
+	glDeleteQueries(query_count, queries);
+}
+
+void GpuTimer::begin(const int tag) {
+	collect_results();
+	if (pending[next_query]) {
+		active_query = -1;
+		return;
+	}
+	active_query = next_query;
+	tags[active_query] = tag;
+	glBeginQuery(GL_TIME_ELAPSED, queries[active_query]);
+}
+
+void GpuTimer::end() {
+	if (active_query < 0) return;
+	glEndQuery(GL_TIME_ELAPSED);
+	pending[active_query] = true;
+	next_query = (next_query + 1) % query_count;
+	active_query = -1;
+}
+
+double GpuTimer::get_elapsed() const {
+	return elapsed;
+}
+
+unsigned long long GpuTimer::get_result_count() const {
+	return result_count;
+}
+
+int GpuTimer::get_tag() const {
+	return tag;
+}
+
+void GpuTimer::collect_results() {
+	// Results arrive in submission order, starting with the oldest query at next_query.
+	for (int i = 0; i < query_count; i++) {
+		const int query = (next_query + i) % query_count;
+		if (!pending[query]) continue;
+
+		GLint available = 0;
+		glGetQueryObjectiv(queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) break;
+
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(queries[query], GL_QUERY_RESULT, &nanoseconds);
+		elapsed = static_cast<double>(nanoseconds) * 1e-6;
+		result_count++;
+		tag = tags[query];
+		pending[query] = false;
+	}
+}
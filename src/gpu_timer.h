@@ -0,0 +1,39 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Measures GPU time between begin() and end() with GL_TIME_ELAPSED queries. Queries rotate through
+// a small ring and are read once their results are available, so timing never stalls the CPU. A
+// frame whose query slot is still pending is not timed.
+class GpuTimer {
+public:
+	static constexpr int query_count = 4;
+
+	GpuTimer();
+	~GpuTimer();
+
+	GpuTimer(const GpuTimer&) = delete;
+	GpuTimer& operator=(const GpuTimer&) = delete;
+
+	// tag is returned with the result, to tell apart the kinds of frames that are timed.
+	void begin(int tag = 0);
+	void end();
+	// Milliseconds between the last begin() and end() whose result has arrived.
+	[[nodiscard]] double get_elapsed() const;
+	// Number of results that have arrived, which tells whether get_elapsed() has a new one
+	[[nodiscard]] unsigned long long get_result_count() const;
+	// Tag of the result returned by get_elapsed()
+	[[nodiscard]] int get_tag() const;
+
+private:
+	GLuint queries[query_count] = {};
+	bool pending[query_count] = {};
+	int tags[query_count] = {};
+	int next_query = 0;
+	int active_query = -1;
+	double elapsed = 0.0;
+	unsigned long long result_count = 0;
+	int tag = 0;
+
+	void collect_results();
+};
@@ -8,6 +8,23 @@ size_t GradientEditor::get_num_stops() const {
 	return stops.size();
 }
 
+uint64_t GradientEditor::get_version() const {
+	return version;
+}
+
+void GradientEditor::mark_changed() {
+	version = ++last_version;
+}
+
+const std::vector<ColorStop>& GradientEditor::get_sorted_stops() const {
+	if (sorted_version != version) {
+		sorted_stops = stops;
+		std::ranges::stable_sort(sorted_stops, stop_comparator);
+		sorted_version = version;
+	}
+	return sorted_stops;
+}
+
 void GradientEditor::handle_mouse_input(const ImVec2& preview_pos) {
     const ImGuiIO& io = ImGui::GetIO();
     const ImVec2 mouse_pos = io.MousePos;
@@ -31,8 +48,11 @@ void GradientEditor::handle_mouse_input(const ImVec2& preview_pos) {
         const ImVec2 stop_pos(preview_pos.x + stops[selected_stop_index].position * preview_size.x - 5, preview_pos.y - 18);
 
         if (is_dragging_stop || ImGui::IsMouseHoveringRect(stop_pos, ImVec2(stop_pos.x + stop_size.x, stop_pos.y + stop_size.y))) {
-	        const float position = (mouse_pos.x - preview_pos.x) / preview_size.x;
-	        stops[selected_stop_index].position = std::clamp(position, 0.0f, 1.0f);
+	        const float position = std::clamp((mouse_pos.x - preview_pos.x) / preview_size.x, 0.0f, 1.0f);
+	        if (stops[selected_stop_index].position != position) {
+		        stops[selected_stop_index].position = position;
+		        mark_changed();
+	        }
 	        is_dragging_stop = true;
         }
     }
@@ -45,6 +65,7 @@ void GradientEditor::handle_mouse_input(const ImVec2& preview_pos) {
 	            float position = (mouse_pos.x - preview_pos.x) / preview_size.x;
 	            stops.emplace_back(position, interpolate(position));
 	            std::ranges::sort(stops, stop_comparator);
+	            mark_changed();
 
 	            for (size_t i = 0; i < stops.size(); i++) {
 		            if (std::abs(stops[i].position - position) < FLT_EPSILON) {
@@ -64,6 +85,7 @@ void GradientEditor::handle_mouse_input(const ImVec2& preview_pos) {
 	            if (ImGui::IsMouseHoveringRect(stop_pos, ImVec2(stop_pos.x + stop_size.x, stop_pos.y + stop_size.y))) {
                     if (get_num_stops() > 1) {
 	                    stops.erase(stops.begin() + static_cast<int>(i));
+	                    mark_changed();
 
 	                    if (!stops.empty()) {
 		                    selected_stop_index = 0;
@@ -133,30 +155,13 @@ void GradientEditor::draw_stop(const ColorStop& stop, const ImVec2& preview_pos)
     }
 }
 
-void GradientEditor::show() {
+void GradientEditor::show(const ImTextureID preview_texture) {
 	const ImVec2 cursor_screen_pos = ImGui::GetCursorScreenPos();
 	const ImVec2 preview_pos(cursor_screen_pos.x + 10, cursor_screen_pos.y + 20);
     ImDrawList* draw_list = ImGui::GetWindowDrawList();
 
     // Preview
-    for (int x = 0; x < static_cast<int>(preview_size.x); ++x) {
-        const auto x_float = static_cast<float>(x);
-	    const float position = x_float / preview_size.x;
-	    const ImVec2 start(preview_pos.x + x_float, preview_pos.y);
-	    const ImVec2 end(preview_pos.x + x_float + 1, preview_pos.y + preview_size.y);
-	    const ImVec4 color = interpolate(position);
-
-        draw_list->AddRectFilled(
-            start,
-            end,
-            IM_COL32(
-	            static_cast<int>(color.x * 255),
-	            static_cast<int>(color.y * 255),
-	            static_cast<int>(color.z * 255),
-	            static_cast<int>(color.w * 255)
-            )
-        );
-    }
+    draw_list->AddImage(preview_texture, preview_pos, ImVec2(preview_pos.x + preview_size.x, preview_pos.y + preview_size.y));
 
     // Stops
     for (auto stop : stops) {
@@ -180,7 +185,9 @@ void GradientEditor::show() {
         ImGui::SetCursorPosX(ImGui::GetCursorPosX() + 10);
         ImGui::SetNextItemWidth(250.0f);
         ImGui::BeginChild("ColorPicker", ImVec2(250.0f, 250.0f), false, ImGuiWindowFlags_NoScrollbar);
-		ImGui::ColorPicker3("Color", (float*)&selected_stop->color, ImGuiColorEditFlags_DisplayRGB | ImGuiColorEditFlags_NoSidePreview);
+		if (ImGui::ColorPicker3("Color", (float*)&selected_stop->color, ImGuiColorEditFlags_DisplayRGB | ImGuiColorEditFlags_NoSidePreview)) {
+			mark_changed();
+		}
     	ImGui::EndChild();
     }
 
@@ -188,50 +195,55 @@ void GradientEditor::show() {
 }
 
 ImVec4 GradientEditor::interpolate(const float position) const {
-    if (stops.empty()) {
+    const std::vector<ColorStop>& sorted = get_sorted_stops();
+    if (sorted.empty()) {
         return {0, 0, 0, 1};
     }
 
-    std::vector<ColorStop> sorted_stops = stops;
-    std::ranges::sort(sorted_stops, stop_comparator);
-
-    if (position < sorted_stops.front().position) {
-	    return sorted_stops.front().color;
+    if (!(position >= sorted.front().position)) {
+	    return sorted.front().color;
     }
-	if (position > sorted_stops.back().position) {
-		return sorted_stops.back().color;
+	if (position >= sorted.back().position) {
+		return sorted.back().color;
     }
 
-    for (size_t i = 0; i < sorted_stops.size() - 1; i++) {
-        const ColorStop& current = sorted_stops[i];
-        const ColorStop& next = sorted_stops[i + 1];
-
-        if (position >= current.position && position <= next.position) {
-            const float t = (position - current.position) / (next.position - current.position);
-            return {
-                ImLerp(current.color.x, next.color.x, t),
-                ImLerp(current.color.y, next.color.y, t),
-                ImLerp(current.color.z, next.color.z, t),
-                ImLerp(current.color.w, next.color.w, t)
-            };
-        }
-    }
-    
-    return sorted_stops.back().color;
+    // First stop after position; the one before it starts the segment.
+    const auto next = std::upper_bound(sorted.begin(), sorted.end(), position, [](const float p, const ColorStop& stop) {
+        return p < stop.position;
+    });
+    const ColorStop& current = *(next - 1);
+    const float t = (position - current.position) / (next->position - current.position);
+    return {
+        ImLerp(current.color.x, next->color.x, t),
+        ImLerp(current.color.y, next->color.y, t),
+        ImLerp(current.color.z, next->color.z, t),
+        ImLerp(current.color.w, next->color.w, t)
+    };
 }
 
-std::vector<unsigned char> GradientEditor::generate_gradient() const {
-	std::vector<unsigned char> gradient;
+const std::vector<float>& GradientEditor::bake(const int size) const {
+	if (lut_version == version && lut.size() == static_cast<size_t>(size) * 3) {
+		return lut;
+	}
 
-	for (int i = 0; i < 256; i++) {
-		const float position = static_cast<float>(i) / 255.0f;
+	lut.resize(static_cast<size_t>(size) * 3);
+	for (int i = 0; i < size; i++) {
+		const float position = size > 1 ? static_cast<float>(i) / static_cast<float>(size - 1) : 0.0f;
 		const ImVec4 color = interpolate(position);
-
-		gradient.push_back(static_cast<unsigned char>(color.x * 255.0f));
-		gradient.push_back(static_cast<unsigned char>(color.y * 255.0f));
-		gradient.push_back(static_cast<unsigned char>(color.z * 255.0f));
+		lut[i * 3] = color.x;
+		lut[i * 3 + 1] = color.y;
+		lut[i * 3 + 2] = color.z;
 	}
+	lut_version = version;
+	return lut;
+}
 
+std::vector<unsigned char> GradientEditor::generate_gradient(const int size) const {
+	const std::vector<float>& colors = bake(size);
+	std::vector<unsigned char> gradient(colors.size());
+	for (size_t i = 0; i < colors.size(); i++) {
+		gradient[i] = static_cast<unsigned char>(colors[i] * 255.0f);
+	}
 	return gradient;
 }
 
@@ -242,6 +254,7 @@ void GradientEditor::set_default_gradient() {
 	stops.emplace_back(1.0, ImVec4(1.0, 1.0, 1.0, 1.0));
     selected_stop_index = 1;
     selected_stop = &stops.front();
+    mark_changed();
 }
 
 void GradientEditor::random_gradient() {
@@ -265,6 +278,16 @@ void GradientEditor::random_gradient() {
 	std::ranges::sort(stops, stop_comparator);
     selected_stop_index = 1;
     selected_stop = &stops.front();
+    mark_changed();
+}
+
+void GradientEditor::set_stops(const std::vector<ColorStop>& new_stops) {
+	stops = new_stops;
+	std::ranges::sort(stops, stop_comparator);
+	selected_stop_index = -1;
+	selected_stop = nullptr;
+	is_dragging_stop = false;
+	mark_changed();
 }
 
 bool GradientEditor::stop_comparator(const ColorStop& a, const ColorStop& b) {
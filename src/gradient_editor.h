@@ -3,10 +3,13 @@
 #include <vector>
 #include <random>
 #include <chrono>
+#include <cstdint>
 
 #include <imgui.h>
 #include <imgui_internal.h>
 
+#include "app_settings.h"
+
 struct ColorStop {
 	float position;
 	ImVec4 color;
@@ -30,13 +33,21 @@ public:
 	GradientEditor();
 
 	[[nodiscard]] size_t get_num_stops() const;
+	// Changes on every edit. Versions are unique across all editors, so an assigned editor never
+	// matches a version that was baked or uploaded before.
+	[[nodiscard]] uint64_t get_version() const;
 	void handle_mouse_input(const ImVec2& preview_pos);
 	void draw_stop(const ColorStop& stop, const ImVec2& preview_pos) const;
-	void show();
+	// Draws the editor with preview_texture (the baked LUT, see GradientTexture) as the preview.
+	void show(ImTextureID preview_texture);
 	[[nodiscard]] ImVec4 interpolate(float position) const;
-	[[nodiscard]] std::vector<unsigned char> generate_gradient() const;
+	// RGB colors at size evenly spaced positions from 0 to 1. Baked once per version and size.
+	[[nodiscard]] const std::vector<float>& bake(int size) const;
+	[[nodiscard]] std::vector<unsigned char> generate_gradient(int size = default_gradient_lut_size) const;
 	void set_default_gradient();
 	void random_gradient();
+	// Replaces the stops and clears the selection.
+	void set_stops(const std::vector<ColorStop>& new_stops);
 
 private:
 	ImVec2 preview_size = ImVec2(400, 40);
@@ -45,6 +56,17 @@ private:
 	bool is_dragging_stop = false;
 	ColorStop* selected_stop = nullptr;
 	std::vector<ColorStop> stops;
+	uint64_t version = 0;
+
+	// Caches derived from stops, valid while their version matches
+	mutable std::vector<ColorStop> sorted_stops;
+	mutable uint64_t sorted_version = 0;
+	mutable std::vector<float> lut;
+	mutable uint64_t lut_version = 0;
+
+	static inline uint64_t last_version = 0;
 
+	void mark_changed();
+	const std::vector<ColorStop>& get_sorted_stops() const;
 	static bool stop_comparator(const ColorStop& a, const ColorStop& b);
 };
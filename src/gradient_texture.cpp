@@ -0,0 +1,60 @@
+#include <cstdint>
+
+#include "gradient_texture.h"
+
+GradientTexture::GradientTexture() {
+	glGenTextures(1, &texture_id);
+	glBindTexture(GL_TEXTURE_2D, texture_id);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+GradientTexture::~GradientTexture() {
+	if (texture_id != 0) {
+		glDeleteTextures(1, &texture_id);
+		texture_id = 0;
+	}
+}
+
+bool GradientTexture::update(const GradientEditor& editor, const int size, const bool use_float) {
+	if (editor.get_version() == uploaded_version && size == uploaded_size && use_float == uploaded_float) {
+		return false;
+	}
+
+	const std::vector<float>& colors = editor.bake(size);
+	const GLenum type = use_float ? GL_FLOAT : GL_UNSIGNED_BYTE;
+	const void* texels = colors.data();
+	if (!use_float) {
+		unorm_texels.resize(colors.size());
+		for (size_t i = 0; i < colors.size(); i++) {
+			unorm_texels[i] = static_cast<unsigned char>(colors[i] * 255.0f);
+		}
+		texels = unorm_texels.data();
+	}
+
+	// RGB rows are not 4-byte aligned for every size.
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glBindTexture(GL_TEXTURE_2D, texture_id);
+	if (size != uploaded_size || use_float != uploaded_float) {
+		glTexImage2D(GL_TEXTURE_2D, 0, use_float ? GL_RGB32F : GL_RGB8, size, 1, 0, GL_RGB, type, texels);
+	} else {
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, 1, GL_RGB, type, texels);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	uploaded_version = editor.get_version();
+	uploaded_size = size;
+	uploaded_float = use_float;
+	return true;
+}
+
+GLuint GradientTexture::get_id() const {
+	return texture_id;
+}
+
+ImTextureID GradientTexture::get_imgui_id() const {
+	// ImTextureID is a pointer in older Dear ImGui versions and an integer in newer ones.
+	return (ImTextureID)(intptr_t)texture_id;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <imgui.h>
+
+#include "gradient_editor.h"
+
+// Nx1 2D texture holding a GradientEditor's baked LUT. A 2D texture rather than a 1D one lets the
+// GUI draw the same texture as its gradient previews.
+class GradientTexture {
+public:
+	GradientTexture();
+	~GradientTexture();
+
+	GradientTexture(const GradientTexture&) = delete;
+	GradientTexture& operator=(const GradientTexture&) = delete;
+
+	// Uploads the LUT if the gradient, size or precision changed since the last upload and returns
+	// whether it did. Float LUTs keep full precision; otherwise texels are 8 bits per channel.
+	bool update(const GradientEditor& editor, int size, bool use_float);
+
+	[[nodiscard]] GLuint get_id() const;
+	[[nodiscard]] ImTextureID get_imgui_id() const;
+
+private:
+	GLuint texture_id = 0;
+	uint64_t uploaded_version = 0;
+	int uploaded_size = 0;
+	bool uploaded_float = false;
+	std::vector<unsigned char> unorm_texels;
+};
@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdio>
+
+#include "image_writer.h"
+
+// Largest payload of a deflate stored block
+static constexpr size_t max_stored_block_size = 65535;
+
+static const std::array<uint32_t, 256>& crc_table() {
+	static const std::array<uint32_t, 256> table = [] {
+		std::array<uint32_t, 256> result{};
+		for (uint32_t n = 0; n < 256; n++) {
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++) {
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			}
+			result[n] = c;
+		}
+		return result;
+	}();
+	return table;
+}
+
+static uint32_t update_crc(uint32_t crc, const unsigned char* data, const size_t size) {
+	const std::array<uint32_t, 256>& table = crc_table();
+	for (size_t i = 0; i < size; i++) {
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return crc;
+}
+
+static void append_u32_big_endian(std::vector<unsigned char>& out, const uint32_t value) {
+	out.push_back(static_cast<unsigned char>(value >> 24));
+	out.push_back(static_cast<unsigned char>(value >> 16));
+	out.push_back(static_cast<unsigned char>(value >> 8));
+	out.push_back(static_cast<unsigned char>(value));
+}
+
+// Appends a stored block header: the final-block bit, then LEN and NLEN in little-endian order.
+static void append_stored_block_header(std::vector<unsigned char>& out, const size_t size, const bool final_block) {
+	const auto len = static_cast<uint16_t>(size);
+	const auto nlen = static_cast<uint16_t>(~len);
+	out.push_back(final_block ? 1 : 0);
+	out.push_back(static_cast<unsigned char>(len));
+	out.push_back(static_cast<unsigned char>(len >> 8));
+	out.push_back(static_cast<unsigned char>(nlen));
+	out.push_back(static_cast<unsigned char>(nlen >> 8));
+}
+
+ImageFormat image_format_for_path(const std::string& path) {
+	if (path.size() < 4) {
+		return ImageFormat::ppm;
+	}
+	std::string extension = path.substr(path.size() - 4);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](const unsigned char c) {
+		return static_cast<char>(std::tolower(c));
+	});
+	return extension == ".png" ? ImageFormat::png : ImageFormat::ppm;
+}
+
+ImageStreamWriter::~ImageStreamWriter() {
+	if (is_open()) {
+		close();
+	}
+}
+
+bool ImageStreamWriter::open(const std::string& path, const int width, const int height) {
+	this->path = path;
+	this->width = width;
+	this->height = height;
+	format = image_format_for_path(path);
+	rows_written = 0;
+	adler_a = 1;
+	adler_b = 0;
+
+	file.open(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		fprintf(stderr, "Error opening image file: %s\n", path.c_str());
+		return false;
+	}
+
+	if (format == ImageFormat::ppm) {
+		file << "P6\n" << width << " " << height << "\n255\n";
+		return check_stream();
+	}
+
+	constexpr unsigned char signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+	// 8-bit truecolor, deflate, adaptive filtering (every row uses filter 0), no interlacing
+	std::vector<unsigned char> header;
+	append_u32_big_endian(header, static_cast<uint32_t>(width));
+	append_u32_big_endian(header, static_cast<uint32_t>(height));
+	header.insert(header.end(), {8, 2, 0, 0, 0});
+	write_png_chunk("IHDR", header);
+	return check_stream();
+}
+
+bool ImageStreamWriter::write_rows(const unsigned char* rows, int row_count) {
+	row_count = std::min(row_count, height - rows_written);
+	if (!is_open() || row_count <= 0) {
+		return false;
+	}
+	const size_t row_size = static_cast<size_t>(width) * 3;
+
+	if (format == ImageFormat::ppm) {
+		file.write(reinterpret_cast<const char*>(rows), static_cast<std::streamsize>(row_size * row_count));
+		rows_written += row_count;
+		return check_stream();
+	}
+
+	// One IDAT chunk per call. The zlib stream (RFC 1950) starts with a header in the first chunk,
+	// and each scanline is prefixed with its filter type.
+	chunk_data.clear();
+	if (rows_written == 0) {
+		chunk_data.push_back(0x78);
+		chunk_data.push_back(0x01);
+	}
+	std::vector<unsigned char> scanlines;
+	scanlines.reserve((row_size + 1) * row_count);
+	for (int row = 0; row < row_count; row++) {
+		scanlines.push_back(0);
+		scanlines.insert(scanlines.end(), rows + row * row_size, rows + (row + 1) * row_size);
+	}
+
+	for (size_t offset = 0; offset < scanlines.size(); offset += max_stored_block_size) {
+		const size_t size = std::min(max_stored_block_size, scanlines.size() - offset);
+		append_stored_block_header(chunk_data, size, false);
+		chunk_data.insert(chunk_data.end(), scanlines.begin() + static_cast<std::ptrdiff_t>(offset), scanlines.begin() + static_cast<std::ptrdiff_t>(offset + size));
+	}
+
+	// Adler-32, reduced every 5552 bytes before the sums can overflow
+	constexpr uint32_t adler_modulus = 65521;
+	constexpr size_t adler_run = 5552;
+	for (size_t offset = 0; offset < scanlines.size(); offset += adler_run) {
+		const size_t end = std::min(offset + adler_run, scanlines.size());
+		for (size_t i = offset; i < end; i++) {
+			adler_a += scanlines[i];
+			adler_b += adler_a;
+		}
+		adler_a %= adler_modulus;
+		adler_b %= adler_modulus;
+	}
+
+	write_png_chunk("IDAT", chunk_data);
+	rows_written += row_count;
+	return check_stream();
+}
+
+bool ImageStreamWriter::close() {
+	if (!is_open()) {
+		return false;
+	}
+	bool complete = rows_written == height;
+	if (!complete) {
+		fprintf(stderr, "Error: image file %s is incomplete, %d of %d rows written\n", path.c_str(), rows_written, height);
+	}
+
+	if (format == ImageFormat::png) {
+		// An empty final block ends the deflate stream, followed by the checksum of the data
+		chunk_data.clear();
+		if (rows_written == 0) {
+			chunk_data.push_back(0x78);
+			chunk_data.push_back(0x01);
+		}
+		append_stored_block_header(chunk_data, 0, true);
+		append_u32_big_endian(chunk_data, (adler_b << 16) | adler_a);
+		write_png_chunk("IDAT", chunk_data);
+		write_png_chunk("IEND", {});
+	}
+
+	complete &= check_stream();
+	file.close();
+	return complete;
+}
+
+bool ImageStreamWriter::is_open() const {
+	return file.is_open();
+}
+
+int ImageStreamWriter::get_rows_written() const {
+	return rows_written;
+}
+
+void ImageStreamWriter::write_png_chunk(const char* type, const std::vector<unsigned char>& data) {
+	std::vector<unsigned char> length;
+	append_u32_big_endian(length, static_cast<uint32_t>(data.size()));
+	file.write(reinterpret_cast<const char*>(length.data()), 4);
+	file.write(type, 4);
+	file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+	uint32_t crc = update_crc(0xFFFFFFFFu, reinterpret_cast<const unsigned char*>(type), 4);
+	crc = update_crc(crc, data.data(), data.size()) ^ 0xFFFFFFFFu;
+	std::vector<unsigned char> checksum;
+	append_u32_big_endian(checksum, crc);
+	file.write(reinterpret_cast<const char*>(checksum.data()), 4);
+}
+
+bool ImageStreamWriter::check_stream() {
+	if (!file) {
+		fprintf(stderr, "Error writing image file: %s\n", path.c_str());
+		return false;
+	}
+	return true;
+}
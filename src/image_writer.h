@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Rectangle of an image in top-down pixel coordinates.
+struct ImageRegion {
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+};
+
+enum class ImageFormat {
+	ppm,
+	png
+};
+
+// PNG for paths ending in .png (any case), binary PPM (P6) otherwise.
+[[nodiscard]] ImageFormat image_format_for_path(const std::string& path);
+
+// Writes tightly packed, top-down 8-bit RGB rows as they become available, so an image of any size
+// needs only the rows in flight in memory. PNG image data is stored in uncompressed deflate blocks,
+// which needs no compression library and keeps writing as fast as the disk, at the size of a PPM.
+class ImageStreamWriter {
+public:
+	ImageStreamWriter() = default;
+	~ImageStreamWriter();
+
+	ImageStreamWriter(const ImageStreamWriter&) = delete;
+	ImageStreamWriter& operator=(const ImageStreamWriter&) = delete;
+
+	bool open(const std::string& path, int width, int height);
+	bool write_rows(const unsigned char* rows, int row_count);
+	// Finishes the file, which fails unless every row was written.
+	bool close();
+
+	[[nodiscard]] bool is_open() const;
+	[[nodiscard]] int get_rows_written() const;
+
+private:
+	std::ofstream file;
+	std::string path;
+	ImageFormat format = ImageFormat::ppm;
+	int width = 0;
+	int height = 0;
+	int rows_written = 0;
+	// Running Adler-32 checksum of the zlib stream, see RFC 1950
+	uint32_t adler_a = 1;
+	uint32_t adler_b = 0;
+	std::vector<unsigned char> chunk_data;
+
+	void write_png_chunk(const char* type, const std::vector<unsigned char>& data);
+	bool check_stream();
+};
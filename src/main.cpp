@@ -10,9 +10,19 @@
 
 #include "window.h"
 #include "camera.h"
-#include "shader.h"
 #include "gradient_editor.h"
 #include "app_settings.h"
+#include "animation.h"
+#include "animation_renderer.h"
+#include "command_line.h"
+#include "cpu_renderer.h"
+#include "formula.h"
+#include "gpu_export.h"
+#include "mandelbulb.h"
+#include "mandelbulb_simd.h"
+#include "mesh_extractor.h"
+#include "renderer.h"
+#include "tiled_export.h"
 
 // Global variables
 AppSettings settings;
@@ -21,9 +31,13 @@ Camera camera;
 GradientEditor gradient_editor;
 glm::vec2 resolution = glm::vec2(default_width, default_height);
 GLfloat aspect_ratio = resolution.x / resolution.y;
-std::vector<unsigned char> gradient_data(768); // 256 * 1 * 3 = 768
+Renderer* renderer;
+GpuExport* gpu_export = nullptr;
 
 // Function declarations
+int render_headless(const CommandLineOptions& options);
+int render_animation(const CommandLineOptions& options);
+int extract_mesh(const CommandLineOptions& options);
 void key_callback(GLFWwindow* glfw_window, int key, int scancode, int action, int mods);
 void cursor_position_callback(GLFWwindow* glfw_window, double xpos, double ypos);
 void resize_callback(GLFWwindow* glfw_window, const int w, const int h);
@@ -33,10 +47,33 @@ bool slider_float(const char* label, float* v, const float v_min, const float v_
 bool drag_float3(const char* label, float v[3], const float v_min, const float v_max, const float v_default[3], const char* format = "%.3f", const ImGuiSliderFlags flags = 0);
 void gradient_preview(int width, int height);
 void show_gradient_editor();
+void show_export();
+void show_formula();
+void show_distance_volume();
+void show_noise_volume();
+void show_precision();
+void show_resolution();
+void show_anti_aliasing();
+void show_profiler();
+void show_ray_stats();
 void show_main_window();
 void render_gui();
 
-int main() {
+int main(int argc, char* argv[]) {
+	CommandLineOptions options;
+	if (!parse_command_line(argc, argv, options)) {
+		return -1;
+	}
+	if (options.headless) {
+		return render_headless(options);
+	}
+	if (!options.animation_path.empty()) {
+		return render_animation(options);
+	}
+	if (!options.mesh_path.empty()) {
+		return extract_mesh(options);
+	}
+
 	// Initialize window
 	try {
 		window = new Window("Cloven");
@@ -63,40 +100,8 @@ int main() {
 
 	init_gui(window->glfw_window);
 
-	// Create and bind shader
-	Shader shader("shaders/shader.vert", "shaders/shader.frag");
-
-	shader.bind();
-
-	// Set up VAO and VBO
-	constexpr float quad_vertices[] = {
-		-1.0f,  1.0f,
-		-1.0f, -1.0f,
-		 1.0f, -1.0f,
-	
-		-1.0f,  1.0f,
-		 1.0f, -1.0f,
-		 1.0f,  1.0f
-	};
-	unsigned int quad_vao, quad_vbo;
-	glGenVertexArrays(1, &quad_vao);
-	glGenBuffers(1, &quad_vbo);
-	glBindVertexArray(quad_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices), quad_vertices, GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
-	glEnableVertexAttribArray(0);
-
-	// Generate and bind gradient texture
-	GLuint texture_id = 0;
-	glGenTextures(1, &texture_id);
-	glBindTexture(GL_TEXTURE_1D, texture_id);
-	glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	constexpr GLuint texture_unit = 0;
-	glActiveTexture(GL_TEXTURE0 + texture_unit);
-	glBindTexture(GL_TEXTURE_1D, texture_id);
+	// Create the renderer, which owns the shader, the gradient texture and the offscreen framebuffer
+	renderer = new Renderer();
 
 	camera = Camera();
 	int nb_frames = 0;
@@ -106,6 +111,20 @@ int main() {
 
 	// Main update_viewport loop
 	while (!window->should_close()) {
+		// Advance a running export by one tile, outside the profiled frame so that its passes are
+		// not counted as the window's
+		if (gpu_export && !gpu_export->step(*renderer)) {
+			const ExportProgress progress = gpu_export->get_progress();
+			if (gpu_export->finish()) {
+				printf("Exported %s: %d tiles in %.1f s, %.1f tiles/s\n", gpu_export->get_path().c_str(), progress.tile_count, progress.seconds, progress.tiles_per_second);
+			}
+			delete gpu_export;
+			gpu_export = nullptr;
+		}
+
+		Profiler& profiler = renderer->get_profiler();
+		profiler.begin_frame();
+
 		// Update FPS
 		nb_frames++;
 		current_time = glfwGetTime();
@@ -119,90 +138,17 @@ int main() {
 		}
 
 		// Handle camera input
+		profiler.begin(ProfilePhase::input);
 		if (glfwGetInputMode(window->glfw_window, GLFW_CURSOR) == GLFW_CURSOR_DISABLED) {
 			camera.handle_keyboard_input(window->glfw_window, static_cast<float>(settings.frame_delta_time));
 		}
+		profiler.end(ProfilePhase::input);
 
 		// Clear the screen
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		// Set uniforms
-		shader.bind();
-		const glm::mat4 projection_matrix = glm::perspective(glm::radians(camera.zoom), aspect_ratio, 0.1f, 100.0f);
-		const glm::mat4 inverse_view_matrix = glm::inverse(camera.view_matrix());
-		const glm::mat4 inverse_projection_matrix = glm::inverse(projection_matrix);
-
-		shader.set_uniform_mat4("u_inverse_view_matrix", inverse_view_matrix);
-		shader.set_uniform_mat4("u_inverse_projection_matrix", inverse_projection_matrix);
-		shader.set_uniform_2f("u_resolution", default_width, default_height);
-		shader.set_uniform_vec3("u_camera_pos", camera.position);
-		shader.set_uniform_1i("u_enable_normal_visualization", settings.enable_normal_visualization);
-
-		shader.set_uniform_1i("u_max_iterations", settings.max_iterations);
-		shader.set_uniform_1i("u_escape_radius", settings.escape_radius);
-		shader.set_uniform_1i("u_step_limit", settings.step_limit);
-		shader.set_uniform_1f("u_max_distance", settings.max_distance);
-		shader.set_uniform_1f("u_power", settings.power);
-		shader.set_uniform_1f("u_epsilon", settings.epsilon);
-		shader.set_uniform_1f("u_ray_hit_threshold", settings.ray_hit_threshold);
-
-		shader.set_uniform_1i("u_coloring_method", settings.coloring_method);
-		shader.set_uniform_1i("u_background_type", settings.background_type);
-		shader.set_uniform_vec3("u_background_color", glm::vec3(
-			settings.background_color[0],
-			settings.background_color[1],
-			settings.background_color[2]
-		));
-
-		shader.set_uniform_vec3("u_light_pos", settings.light_pos);
-		shader.set_uniform_1f("u_light_power", settings.light_power);
-		shader.set_uniform_1f("u_noise_scale", settings.noise_scale);
-		shader.set_uniform_1f("u_noise_amplitude", settings.noise_amplitude);
-		shader.set_uniform_1f("u_ambient_strength", settings.ambient_strength);
-		shader.set_uniform_1f("u_diffuse_strength", settings.diffuse_strength);
-		shader.set_uniform_1f("u_specular_strength", settings.specular_strength);
-		shader.set_uniform_1f("u_specular_shininess", settings.specular_shininess);
-		shader.set_uniform_1f("u_shadow_softness", settings.shadow_softness);
-		shader.set_uniform_1f("u_shadow_min_distance", settings.shadow_min_distance);
-		shader.set_uniform_1f("u_shadow_min_step_size", settings.shadow_min_step_size);
-		shader.set_uniform_1f("u_shadow_max_step_size", settings.shadow_max_step_size);
-		shader.set_uniform_1i("u_shadow_max_iterations", settings.shadow_max_iterations);
-		shader.set_uniform_1f("u_bloom_intensity_factor", settings.bloom_intensity_factor);
-		shader.set_uniform_vec3("u_bloom_color", glm::vec3(
-			settings.bloom_color[0],
-			settings.bloom_color[1],
-			settings.bloom_color[2]
-		));
-		shader.set_uniform_1f("u_light_radius", settings.light_radius);
-		shader.set_uniform_vec3("u_light_color", glm::vec3(
-			settings.light_color[0],
-			settings.light_color[1],
-			settings.light_color[2]
-		));
-		shader.set_uniform_1i("u_show_light", settings.show_light);
-		shader.set_uniform_1i("u_apply_noise", settings.apply_noise);
-		shader.set_uniform_1i("u_apply_blinn_phong", settings.apply_blinn_phong);
-		shader.set_uniform_1i("u_apply_soft_shadow", settings.apply_soft_shadow);
-		shader.set_uniform_1i("u_apply_bloom", settings.apply_bloom);
-		shader.set_uniform_1i("u_apply_ambient_occlusion", settings.apply_ambient_occlusion);
-
-		// Update gradient texture
-		glActiveTexture(GL_TEXTURE0 + texture_unit);
-		glBindTexture(GL_TEXTURE_1D, texture_id);
-		shader.set_uniform_1i("u_gradient_texture", static_cast<int>(texture_unit));
-		for (size_t i = 0; i < 256; ++i) {
-		    const float position = static_cast<float>(i) / 255.0f;
-			const ImVec4 color = gradient_editor.interpolate(position);
-			gradient_data[i * 3] = static_cast<unsigned char>(color.x * 255.0f);
-		    gradient_data[i * 3 + 1] = static_cast<unsigned char>(color.y * 255.0f);
-		    gradient_data[i * 3 + 2] = static_cast<unsigned char>(color.z * 255.0f);
-		}
-		glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, 256, 0, GL_RGB, GL_UNSIGNED_BYTE, gradient_data.data());
-
-		// Draw the scene
-		glBindVertexArray(quad_vao);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-		glBindVertexArray(0);
+		// Draw the scene, which is only ray marched again when something changed
+		renderer->render(settings, camera, gradient_editor, window->get_viewport(), aspect_ratio);
 
 		// Render the GUI if visible
 		if (settings.show_gui) {
@@ -210,20 +156,142 @@ int main() {
 		}
 
 		// Update window
+		profiler.begin(ProfilePhase::swap);
 		window->update();
+		profiler.end(ProfilePhase::swap);
+		profiler.end_frame();
 	}
 
 	// Cleanup
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
 	ImGui::DestroyContext();
-	glDeleteVertexArrays(1, &quad_vao);
-	glDeleteBuffers(1, &quad_vbo);
+	if (gpu_export) {
+		gpu_export->finish();
+		delete gpu_export;
+	}
+	delete renderer;
 	delete window;
 
 	return 0;
 }
 
+int render_headless(const CommandLineOptions& options) {
+	set_simd_level(options.simd_level);
+	CpuRenderer cpu_renderer(options.threads);
+	TiledExport image(options.width, options.height, options.tile_size);
+	printf("Rendering %dx%d in %d tiles on %u threads (%s)...\n", options.width, options.height, image.get_tile_count(), cpu_renderer.get_thread_count(), simd_level_name(get_simd_level()));
+	if (!image.open(options.output_path)) {
+		return -1;
+	}
+
+	const std::vector<unsigned char> gradient = gradient_editor.generate_gradient(settings.gradient_lut_size);
+	// Time each thread spent rendering, over the time spent in the renderer
+	std::vector<double> busy_seconds(cpu_renderer.get_thread_count());
+	double render_seconds = 0.0;
+	int stolen_tiles = 0;
+	int scheduled_tiles = 0;
+	for (int tile = 0; tile < image.get_tile_count(); tile++) {
+		const std::vector<unsigned char> pixels = cpu_renderer.render(settings, camera, gradient, options.width, options.height, image.get_tile(tile));
+		const CpuRenderStats& stats = cpu_renderer.stats();
+		for (size_t thread = 0; thread < stats.threads.size(); thread++) {
+			busy_seconds[thread] += stats.threads[thread].busy_seconds;
+		}
+		render_seconds += stats.seconds;
+		stolen_tiles += stats.stolen_tiles;
+		scheduled_tiles += stats.tile_count;
+		if (!image.add_tile(pixels.data(), 3, false)) {
+			image.finish();
+			return -1;
+		}
+		const ExportProgress progress = image.get_progress();
+		printf("\rTile %d of %d (%.0f%%), %.2f tiles/s", progress.tiles_done, progress.tile_count, 100.0 * progress.tiles_done / progress.tile_count, progress.tiles_per_second);
+		fflush(stdout);
+	}
+
+	const ExportProgress progress = image.get_progress();
+	const double pixels_per_second = static_cast<double>(options.width) * options.height / progress.seconds;
+	printf("\nRendered in %.3f s: %.0f pixels/s, %.0f pixels/s per core\n", progress.seconds, pixels_per_second, pixels_per_second / cpu_renderer.get_thread_count());
+	const auto [min_busy, max_busy] = std::minmax_element(busy_seconds.begin(), busy_seconds.end());
+	double total_busy = 0.0;
+	for (const double seconds : busy_seconds) {
+		total_busy += seconds;
+	}
+	render_seconds = std::max(render_seconds, 1e-9);
+	printf("Thread utilization: %.1f%% mean, %.1f%% min, %.1f%% max; %d of %d tiles stolen\n",
+		100.0 * total_busy / (render_seconds * busy_seconds.size()), 100.0 * *min_busy / render_seconds, 100.0 * *max_busy / render_seconds,
+		stolen_tiles, scheduled_tiles);
+	if (!image.finish()) {
+		return -1;
+	}
+	printf("Wrote %s\n", options.output_path.c_str());
+	return 0;
+}
+
+int extract_mesh(const CommandLineOptions& options) {
+	set_simd_level(options.simd_level);
+	MeshExtractor extractor(options.threads);
+	MeshStreamWriter writer;
+	printf("Extracting a %d^3 mesh on %u threads (%s)...\n", options.mesh_resolution, extractor.get_thread_count(), simd_level_name(get_simd_level()));
+	if (!writer.open(options.mesh_path)) {
+		return -1;
+	}
+
+	const bool extracted = extractor.extract(settings, options.mesh_resolution, static_cast<float>(options.mesh_extent), writer, [](const int layers_done, const int layer_count) {
+		printf("\rLayer %d of %d (%.0f%%)", layers_done, layer_count, 100.0 * layers_done / layer_count);
+		fflush(stdout);
+	});
+	if (!writer.close() || !extracted) {
+		return -1;
+	}
+
+	const MeshStats& stats = extractor.stats();
+	printf("\nExtracted in %.3f s: %llu vertices, %llu triangles, %.1f%% of the samples evaluated\n", stats.seconds,
+		static_cast<unsigned long long>(stats.vertex_count), static_cast<unsigned long long>(stats.triangle_count),
+		100.0 * static_cast<double>(stats.evaluated_samples) / static_cast<double>(stats.sample_count));
+	printf("Wrote %s\n", options.mesh_path.c_str());
+	return 0;
+}
+
+int render_animation(const CommandLineOptions& options) {
+	Animation animation;
+	if (!animation.load(options.animation_path)) {
+		return -1;
+	}
+
+	// The window is never shown, it only provides the OpenGL context
+	try {
+		window = new Window("Cloven", 1, 1, false);
+	} catch (std::exception& e) {
+		fprintf(stderr, "%s\n", e.what());
+		return -1;
+	}
+	const GLenum glew_error = glewInit();
+	if (glew_error != GLEW_OK) {
+		fprintf(stderr, "Error: %s\n", glewGetErrorString(glew_error));
+		delete window;
+		return -1;
+	}
+
+	AnimationRenderOptions render_options;
+	render_options.output_pattern = options.output_path;
+	render_options.width = options.width;
+	render_options.height = options.height;
+	render_options.fps = options.fps;
+	render_options.writer_threads = options.threads != 0 ? options.threads : default_animation_writer_threads;
+
+	renderer = new Renderer();
+	AnimationRenderer animation_renderer(render_options);
+	printf("Rendering %.2f s of animation (%d keyed values) at %dx%d, %g frames/s...\n", animation.get_duration(), animation.get_track_count(), options.width, options.height, options.fps);
+	const bool success = animation_renderer.render(animation, settings, camera, gradient_editor, *renderer);
+	const AnimationRenderStats& stats = animation_renderer.stats();
+	printf("Wrote %d frames in %.3f s: %.2f frames/s end to end\n", stats.frame_count, stats.seconds, stats.frames_per_second);
+
+	delete renderer;
+	delete window;
+	return success ? 0 : -1;
+}
+
 void key_callback(GLFWwindow* glfw_window, int key, int scancode, int action, int mods) {
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
 		glfwSetWindowShouldClose(glfw_window, true);
@@ -349,27 +417,7 @@ bool drag_float3(const char* label, float v[3], const float v_min, const float v
 }
 
 void gradient_preview(const int width, const int height) {
-	const ImVec2 canvas_size(width, height);
-    const ImVec2 gradient_pos = ImGui::GetCursorScreenPos();
-
-    ImDrawList* draw_list = ImGui::GetWindowDrawList();
-
-    for (int i = 0; i < width; ++i) {
-        const ImVec2 p0(gradient_pos.x + i, gradient_pos.y);
-        const ImVec2 p1(gradient_pos.x + i, gradient_pos.y + canvas_size.y);
-		const auto position = static_cast<float>(i) / width;
-		const auto color = gradient_editor.interpolate(position);
-		const ImU32 col = IM_COL32(
-			static_cast<int>(color.x * 255),
-            static_cast<int>(color.y * 255),
-            static_cast<int>(color.z * 255),
-            static_cast<int>(color.w * 255)
-		);
-
-        draw_list->AddLine(p0, p1, col);
-    }
-
-	ImGui::Dummy(canvas_size);
+	ImGui::Image(renderer->get_gradient_texture_id(), ImVec2(static_cast<float>(width), static_cast<float>(height)));
 }
 
 void show_gradient_editor() {
@@ -384,7 +432,7 @@ void show_gradient_editor() {
     ImGui::SetNextWindowSize(window_size, ImGuiCond_Once);
 	ImGui::Begin("Gradient Editor", &settings.show_gradient_editor, ImGuiWindowFlags_NoResize);
 	
-	gradient_editor.show();
+	gradient_editor.show(renderer->get_gradient_texture_id());
 
 	ImGui::SetCursorPosX(ImGui::GetCursorPosX() + 10);
 	ImGui::SetCursorPosY(ImGui::GetCursorPosY() + 5);
@@ -404,6 +452,249 @@ void show_gradient_editor() {
 	ImGui::End();
 }
 
+void show_export() {
+	static int width = default_headless_width * 4;
+	static int height = default_headless_height * 4;
+	static int tile_size = default_export_tile_size;
+	static char path[256] = "cloven.png";
+
+	if (gpu_export) {
+		const ExportProgress progress = gpu_export->get_progress();
+		char overlay[64];
+		snprintf(overlay, sizeof(overlay), "%d / %d tiles", progress.tiles_done, progress.tile_count);
+		ImGui::ProgressBar(static_cast<float>(progress.tiles_done) / static_cast<float>(progress.tile_count), ImVec2(-1.0f, 0.0f), overlay);
+		ImGui::Text("%.1f tiles/s, %.1f s elapsed", progress.tiles_per_second, progress.seconds);
+		if (ImGui::Button("Cancel##Export")) {
+			gpu_export->finish();
+			delete gpu_export;
+			gpu_export = nullptr;
+		}
+		return;
+	}
+
+	ImGui::InputInt("Width##Export", &width, 256, 1024);
+	ImGui::InputInt("Height##Export", &height, 256, 1024);
+	slider_int("Tile Size##Export", &tile_size, 64, 2048, default_export_tile_size, "%d", ImGuiSliderFlags_AlwaysClamp);
+	ImGui::InputText("File##Export", path, sizeof(path));
+	width = std::max(width, 1);
+	height = std::max(height, 1);
+	ImGui::TextDisabled("PNG if the file ends in .png, PPM otherwise");
+	if (ImGui::Button("Export##Export")) {
+		gpu_export = new GpuExport(settings, camera, gradient_editor, width, height, tile_size);
+		if (!gpu_export->start(path)) {
+			delete gpu_export;
+			gpu_export = nullptr;
+		}
+	}
+}
+
+void show_formula() {
+	const int previous_formula = settings.formula;
+	if (ImGui::BeginCombo("Formula##Fractal", formula_info(settings.formula).name)) {
+		for (int formula = 0; formula < formula_count; formula++) {
+			if (ImGui::Selectable(formula_info(formula).name, formula == settings.formula)) {
+				settings.formula = formula;
+			}
+		}
+		ImGui::EndCombo();
+	}
+	// Each formula has its own size, so the camera moves back to where the whole of it is in view
+	if (settings.formula != previous_formula) {
+		camera.position = glm::vec3(0.0f, 0.0f, formula_info(settings.formula).camera_distance);
+		camera.position_low = glm::vec3(0.0f);
+		camera.set_orientation(Camera::default_yaw, Camera::default_pitch);
+	}
+
+	switch (settings.formula) {
+	case formula_mandelbox:
+		slider_float("Scale##Mandelbox", &settings.mandelbox_scale, -3.0f, 3.0f, default_mandelbox_scale, "%.3f");
+		slider_float("Min Radius##Mandelbox", &settings.mandelbox_min_radius, 0.0f, 1.0f, default_mandelbox_min_radius, "%.3f");
+		slider_float("Fixed Radius##Mandelbox", &settings.mandelbox_fixed_radius, 0.0f, 2.0f, default_mandelbox_fixed_radius, "%.3f");
+		slider_float("Folding Limit##Mandelbox", &settings.mandelbox_folding_limit, 0.0f, 2.0f, default_mandelbox_folding_limit, "%.3f");
+		break;
+	case formula_quaternion_julia:
+		ImGui::SliderFloat4("C##Julia", settings.julia_c, -1.0f, 1.0f, "%.3f");
+		if (ImGui::BeginPopupContextItem("C##Julia")) {
+			if (ImGui::MenuItem("Reset")) std::copy(std::begin(default_julia_c), std::end(default_julia_c), settings.julia_c);
+			ImGui::MenuItem("Close");
+			ImGui::EndPopup();
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void show_distance_volume() {
+	ImGui::Checkbox("Use Distance Volume##Fractal", &settings.use_distance_volume);
+	const auto selected = std::ranges::find(distance_volume_resolutions, settings.distance_volume_resolution);
+	int resolution_index = static_cast<int>(selected - std::ranges::begin(distance_volume_resolutions));
+	if (ImGui::Combo("Volume Resolution##Fractal", &resolution_index, "128\0" "256\0" "512\0\0")) {
+		settings.distance_volume_resolution = distance_volume_resolutions[resolution_index];
+	}
+	if (!settings.use_distance_volume) {
+		ImGui::TextDisabled("Marches through a baked volume away from the surface");
+		return;
+	}
+
+	const DistanceVolumeTexture& volume = renderer->get_distance_volume();
+	if (renderer->is_baking_distance_volume()) {
+		ImGui::TextDisabled("Baking, marching exactly until it is ready");
+	} else if (volume.has_volume()) {
+		const int grid_size = volume.get_resolution() / distance_volume_brick_size;
+		ImGui::Text("Bricks: %d of %d", volume.get_brick_count(), grid_size * grid_size * grid_size);
+		ImGui::Text("Memory: %.1f MB, baked in %.0f ms", static_cast<double>(volume.get_size()) / (1024.0 * 1024.0), volume.get_bake_time() * 1000.0);
+	}
+}
+
+void show_noise_volume() {
+	ImGui::Checkbox("Baked Noise Volume##Noise", &settings.baked_noise);
+	const auto selected = std::ranges::find(noise_volume_resolutions, settings.noise_volume_resolution);
+	int resolution_index = static_cast<int>(selected - std::ranges::begin(noise_volume_resolutions));
+	if (ImGui::Combo("Volume Resolution##Noise", &resolution_index, "64\0" "128\0" "256\0\0")) {
+		settings.noise_volume_resolution = noise_volume_resolutions[resolution_index];
+	}
+	if (!settings.baked_noise) {
+		ImGui::TextDisabled("Samples a baked tileable volume instead of evaluating the noise per pixel");
+		return;
+	}
+
+	const NoiseVolumeTexture& volume = renderer->get_noise_volume();
+	if (renderer->is_baking_noise_volume()) {
+		ImGui::TextDisabled("Baking, evaluating the noise per pixel until it is ready");
+	} else if (volume.has_volume()) {
+		ImGui::Text("Memory: %.1f MB, baked in %.0f ms", static_cast<double>(volume.get_size()) / (1024.0 * 1024.0), volume.get_bake_time() * 1000.0);
+	}
+}
+
+void show_precision() {
+	ImGui::Combo("Mode##Precision", &settings.precision_mode, "Auto\0FP32\0DF64 (Emulated)\0FP64 (Native)\0\0");
+	slider_int("Precise Iterations##Precision", &settings.precise_iterations, 0, 16, default_precise_iterations, "%d", ImGuiSliderFlags_AlwaysClamp);
+	constexpr const char* precision_names[] = {"Auto", "FP32", "DF64", "FP64"};
+	ImGui::Text("Marching In: %s", precision_names[renderer->get_stats().precision]);
+	if (integer_power(settings.power) == 0) {
+		ImGui::TextDisabled("Only whole-number powers iterate in extended precision");
+	}
+}
+
+void show_resolution() {
+	ImGui::Checkbox("Dynamic Resolution##Resolution", &settings.dynamic_resolution);
+	if (settings.dynamic_resolution) {
+		slider_float("Frame Time Budget##Resolution", &settings.frame_time_budget, 1.0f, 50.0f, default_frame_time_budget, "%.1f ms", ImGuiSliderFlags_AlwaysClamp);
+		slider_float("Min Scale##Resolution", &settings.min_resolution_scale, 0.1f, 1.0f, default_min_resolution_scale, "%.2f", ImGuiSliderFlags_AlwaysClamp);
+	} else {
+		slider_float("Scale##Resolution", &settings.resolution_scale, 0.1f, 1.0f, 1.0f, "%.2f", ImGuiSliderFlags_AlwaysClamp);
+	}
+	ImGui::Combo("Interleaving##Resolution", &settings.interleave_mode, "Off\0Checkerboard (1/2)\0" "2x2 (1/4)\0\0");
+
+	const RendererStats& renderer_stats = renderer->get_stats();
+	ImGui::Text("Internal Resolution: %dx%d (%.0f%%)", renderer_stats.render_width, renderer_stats.render_height, renderer_stats.resolution_scale * 100.0f);
+	if (renderer_stats.interleave > 1) {
+		ImGui::Text("Marching 1/%d of the pixels (%d/%d frames of this view)", renderer_stats.interleave,
+			renderer_stats.interleaved_frames, renderer_stats.interleave);
+	} else if (settings.interleave_mode != interleave_off) {
+		ImGui::TextDisabled("Interleaving is off for extended precision");
+	}
+	if (!settings.dynamic_resolution) {
+		return;
+	}
+
+	const ResolutionController& controller = renderer->get_resolution_controller();
+	if (controller.get_frame_time() > 0.0) {
+		ImGui::Text("GPU Frame Time: %.2f ms", controller.get_frame_time());
+	} else {
+		ImGui::TextDisabled("GPU Frame Time: settling");
+	}
+	const std::vector<float>& history = controller.get_history();
+	char overlay[32];
+	snprintf(overlay, sizeof(overlay), "Scale: %.2f", controller.get_scale());
+	ImGui::PlotLines("##Resolution", history.data(), static_cast<int>(history.size()), 0, overlay, 0.0f, 1.0f, ImVec2(-1.0f, 48.0f));
+	ImGui::TextDisabled("Adjusted on frames that render the fractal");
+}
+
+void show_anti_aliasing() {
+	ImGui::Checkbox("Adaptive Anti-Aliasing##AA", &settings.adaptive_aa);
+	slider_float("Edge Threshold##AA", &settings.aa_threshold, 0.0f, 1.0f, default_aa_threshold, "%.3f", ImGuiSliderFlags_AlwaysClamp);
+	slider_int("Rays per Edge Pixel##AA", &settings.aa_samples, 1, 16, default_aa_samples, "%d", ImGuiSliderFlags_AlwaysClamp);
+	slider_int("Ray Budget##AA", &settings.aa_ray_budget, 10000, 10000000, default_aa_ray_budget, "%d", ImGuiSliderFlags_AlwaysClamp | ImGuiSliderFlags_Logarithmic);
+	if (!settings.adaptive_aa) {
+		ImGui::TextDisabled("Supersamples silhouettes and fine detail");
+		return;
+	}
+	if (renderer->get_stats().precision != precision_fp32 || settings.enable_normal_visualization || settings.enable_step_heatmap) {
+		ImGui::TextDisabled("Off for extended precision and debug views");
+		return;
+	}
+
+	const AdaptiveAaStats& stats = renderer->get_adaptive_aa_stats();
+	if (!stats.valid || stats.pixels == 0) {
+		ImGui::TextDisabled("Waiting for the first frame");
+		return;
+	}
+	const double pixels = static_cast<double>(stats.pixels);
+	ImGui::Text("Edge Pixels: %llu (%.1f%%)", stats.edge_pixels, 100.0 * stats.edge_pixels / pixels);
+	ImGui::Text("Supersampled: %llu (%.1f%%)", stats.sampled_pixels, 100.0 * stats.sampled_pixels / pixels);
+	ImGui::Text("Extra Rays: %llu per frame", stats.extra_rays);
+	ImGui::Text("Full SSAA: %llu per frame (%.1f%% used)", stats.ssaa_extra_rays,
+		100.0 * static_cast<double>(stats.extra_rays) / static_cast<double>(std::max(stats.ssaa_extra_rays, 1ull)));
+}
+
+void show_profiler() {
+	static char csv_path[256] = "cloven_profile.csv";
+	static char trace_path[256] = "cloven_profile.json";
+
+	Profiler& profiler = renderer->get_profiler();
+	const std::vector<ProfileFrame> history = profiler.get_history();
+	std::vector<float> values(history.size());
+	for (int i = 0; i < profile_phase_count; i++) {
+		const auto phase = static_cast<ProfilePhase>(i);
+		float max_value = 0.0f;
+		for (size_t frame = 0; frame < history.size(); frame++) {
+			values[frame] = static_cast<float>(std::max(history[frame].phase_duration[i], 0.0));
+			max_value = std::max(max_value, values[frame]);
+		}
+
+		char overlay[64];
+		snprintf(overlay, sizeof(overlay), "%s (%s): %.3f ms", profile_phase_name(phase), is_gpu_phase(phase) ? "GPU" : "CPU", profiler.get_average(phase));
+		ImGui::PushID(i);
+		ImGui::PlotLines("##Profiler", values.data(), static_cast<int>(values.size()), 0, overlay, 0.0f, std::max(max_value, 0.1f), ImVec2(-1.0f, 36.0f));
+		ImGui::PopID();
+	}
+	ImGui::TextDisabled("Averages over the last %d frames", Profiler::history_size);
+
+	ImGui::InputText("CSV##Profiler", csv_path, sizeof(csv_path));
+	if (ImGui::Button("Export CSV##Profiler") && profiler.export_csv(csv_path)) {
+		printf("Exported %s\n", csv_path);
+	}
+	ImGui::InputText("Trace##Profiler", trace_path, sizeof(trace_path));
+	if (ImGui::Button("Export Trace##Profiler") && profiler.export_trace(trace_path)) {
+		printf("Exported %s\n", trace_path);
+	}
+}
+
+void show_ray_stats() {
+	ImGui::Checkbox("Step Heatmap##Stats", &settings.enable_step_heatmap);
+	slider_int("Heatmap Max Steps##Stats", &settings.heatmap_max_steps, 1, default_step_limit, default_heatmap_max_steps, "%d", ImGuiSliderFlags_AlwaysClamp);
+	ImGui::Checkbox("Collect Statistics##Stats", &settings.collect_ray_stats);
+	if (!settings.collect_ray_stats) {
+		ImGui::TextDisabled("Counts steps and distance estimates in the shader");
+		return;
+	}
+
+	const RayStats& stats = renderer->get_ray_stats();
+	if (!stats.valid || stats.pixels == 0) {
+		ImGui::TextDisabled("Waiting for the first frame");
+		return;
+	}
+	const double pixels = static_cast<double>(stats.pixels);
+	ImGui::Text("Pixels: %llu", stats.pixels);
+	ImGui::Text("March Steps: %llu (%.1f per pixel)", stats.march_steps, stats.march_steps / pixels);
+	ImGui::Text("Shadow Steps: %llu (%.1f per pixel)", stats.shadow_steps, stats.shadow_steps / pixels);
+	ImGui::Text("Distance Estimates: %llu (%.1f per pixel)", stats.de_evaluations, stats.de_evaluations / pixels);
+	ImGui::Text("Misses: %llu (%.1f%%)", stats.misses, 100.0 * stats.misses / pixels);
+	ImGui::Text("Step Limit Reached: %llu (%.2f%%)", stats.step_limit_hits, 100.0 * stats.step_limit_hits / pixels);
+}
+
 void show_main_window() {
 	ImGui::SetNextWindowPos(ImVec2(0, 0));
 	ImGui::SetNextWindowSize(ImVec2(gui_width, resolution.y));
@@ -412,6 +703,7 @@ void show_main_window() {
 
 	if (ImGui::CollapsingHeader("Fractal", ImGuiTreeNodeFlags_DefaultOpen)) {
 		ImGui::SeparatorText("General##Fractal");
+		show_formula();
 		slider_int("Max Iterations##Fractal", &settings.max_iterations, 1, 100, default_max_iterations, "%d");
 		slider_int("Escape Radius##Fractal", &settings.escape_radius, 1, 1000, default_escape_radius, "%d");
 		slider_float("Power##Fractal", &settings.power, -64.0f, 64.0f, default_power, "%.3f");
@@ -428,7 +720,16 @@ void show_main_window() {
 			settings.epsilon = default_epsilon;
 			settings.max_distance = default_max_distance;
 			settings.ray_hit_threshold = default_ray_hit_threshold;
+			settings.mandelbox_scale = default_mandelbox_scale;
+			settings.mandelbox_min_radius = default_mandelbox_min_radius;
+			settings.mandelbox_fixed_radius = default_mandelbox_fixed_radius;
+			settings.mandelbox_folding_limit = default_mandelbox_folding_limit;
+			std::copy(std::begin(default_julia_c), std::end(default_julia_c), settings.julia_c);
 		}
+		ImGui::SeparatorText("Distance Volume##Fractal");
+		show_distance_volume();
+		ImGui::SeparatorText("Precision##Fractal");
+		show_precision();
 	}
 
 	if (ImGui::CollapsingHeader("Coloring", ImGuiTreeNodeFlags_DefaultOpen)) {
@@ -439,6 +740,8 @@ void show_main_window() {
 		if (ImGui::Button("Edit Gradient##Coloring")) {
 			settings.show_gradient_editor = true;
 		}
+		slider_int("LUT Size##Coloring", &settings.gradient_lut_size, 2, 4096, default_gradient_lut_size, "%d", ImGuiSliderFlags_AlwaysClamp);
+		ImGui::Checkbox("Float LUT##Coloring", &settings.gradient_float_lut);
 		ImGui::SeparatorText("Background##Coloring");
 		ImGui::Combo("Type##Background", &settings.background_type, "Solid\0Dynamic\0\0");
 		if (settings.background_type == 1) ImGui::BeginDisabled();
@@ -446,6 +749,8 @@ void show_main_window() {
 		if (settings.background_type == 1) ImGui::EndDisabled();
 		if (ImGui::Button("Reset Coloring")) {
 			settings.coloring_method = 0;
+			settings.gradient_lut_size = default_gradient_lut_size;
+			settings.gradient_float_lut = false;
 			settings.background_type = 0;
 			settings.background_color[0] = default_background_color[0];
 			settings.background_color[1] = default_background_color[1];
@@ -476,8 +781,11 @@ void show_main_window() {
 		ImGui::Checkbox("Apply Noise##Noise", &settings.apply_noise);
 		slider_float("Scale##Noise", &settings.noise_scale, 0, 100, default_noise_scale, "%.7f");
 		slider_float("Amplitude##Noise", &settings.noise_amplitude, 0, 10, default_noise_amplitude, "%.7f");
+		show_noise_volume();
 		if (ImGui::Button("Reset Noise")) {
 			settings.apply_noise = true;
+			settings.baked_noise = false;
+			settings.noise_volume_resolution = default_noise_volume_resolution;
 			settings.noise_scale = default_noise_scale;
 			settings.noise_amplitude = default_noise_amplitude;
 		}
@@ -489,8 +797,10 @@ void show_main_window() {
 		slider_float("Diffuse Strength##Shading", &settings.diffuse_strength, -10, 10, default_diffuse_strength, "%.7f");
 		slider_float("Specular Strength##Shading", &settings.specular_strength, -10, 10, default_specular_strength, "%.7f");
 		slider_float("Specular Shininess##Shading", &settings.specular_shininess, -100, 100, default_specular_shininess, "%.7f");
+		ImGui::Combo("Normals##Shading", &settings.normal_method, "Central Differences\0Tetrahedral\0Analytic\0\0");
 		if (ImGui::Button("Reset Shading")) {
 			settings.apply_blinn_phong = true;
+			settings.normal_method = 0;
 			settings.ambient_strength = default_ambient_strength;
 			settings.diffuse_strength = default_diffuse_strength;
 			settings.specular_strength = default_specular_strength;
@@ -531,22 +841,58 @@ void show_main_window() {
 	if (ImGui::CollapsingHeader("Camera", ImGuiTreeNodeFlags_DefaultOpen)) {
 		drag_float3("Position##Camera", reinterpret_cast<float*>(&camera.position), 0, 0, default_camera_pos);
 		slider_float("Field of View##Camera", &camera.zoom, 1.0f, 120.0f, Camera::default_zoom, "%.1f", ImGuiSliderFlags_AlwaysClamp);
-		slider_float("Speed##Camera", &camera.speed, 0.0f, 1.0f, Camera::default_speed, "%.2f", ImGuiSliderFlags_AlwaysClamp);
+		// Deep zooms need speeds far below the default
+		slider_float("Speed##Camera", &camera.speed, 0.0000001f, 1.0f, Camera::default_speed, "%.7f", ImGuiSliderFlags_AlwaysClamp | ImGuiSliderFlags_Logarithmic);
 		slider_float("Sensitivity##Camera", &camera.sensitivity, 0.01f, 1.0f, Camera::default_sensitivity, "%.2f", ImGuiSliderFlags_AlwaysClamp);
 		if (ImGui::Button("Reset Camera")) {
 			camera.reset();
 		}
 	}
 
+	if (ImGui::CollapsingHeader("Resolution")) {
+		show_resolution();
+	}
+
+	if (ImGui::CollapsingHeader("Anti-Aliasing")) {
+		show_anti_aliasing();
+	}
+
+	if (ImGui::CollapsingHeader("Export")) {
+		show_export();
+	}
+
+	if (ImGui::CollapsingHeader("Profiler")) {
+		show_profiler();
+	}
+
+	if (ImGui::CollapsingHeader("Ray Statistics")) {
+		show_ray_stats();
+	}
+
 	if (ImGui::CollapsingHeader("Debug")) {
 		ImGui::Checkbox("Enable Normal Visualization##Misc", &settings.enable_normal_visualization);
+		ImGui::Checkbox("Specialize Shaders##Misc", &settings.specialize_shaders);
+		ImGui::Checkbox("Render on Demand##Misc", &settings.render_on_demand);
+		ImGui::Checkbox("Compute Ray March##Misc", &settings.compute_march);
+		const RendererStats& renderer_stats = renderer->get_stats();
+		const ShaderBuildStats& shader_build_stats = renderer->get_shader_build_stats();
 		ImGui::Text("FPS: %d", settings.fps);
+		const char* last_passes = renderer_stats.last_geometry_pass ? "geometry + shading" : renderer_stats.last_shading_pass ? "shading" : "idle";
+		ImGui::Text("GPU Frame Time: %.2f ms (%s)", renderer_stats.gpu_frame_time, last_passes);
+		ImGui::Text("Geometry Passes: %llu of %llu frames", renderer_stats.geometry_pass_count, renderer_stats.frame_count);
+		ImGui::Text("Last Geometry Pass: %s", renderer_stats.compute_march ? "compute" : "fragment");
+		ImGui::Text("Shading Passes: %llu of %llu frames", renderer_stats.shading_pass_count, renderer_stats.frame_count);
+		ImGui::Text("Shader Variants: %d (%d cached)", shader_build_stats.variant_count, shader_build_stats.cached_variant_count);
+		ImGui::Text("Last Variant Build: %.1f ms (%s)", shader_build_stats.last_build_time, shader_build_stats.last_build_cached ? "cached" : "compiled");
+		ImGui::Text("Total Variant Builds: %.1f ms", shader_build_stats.total_build_time);
 	}
 
 	ImGui::End();
 }
 
 void render_gui() {
+	Profiler& profiler = renderer->get_profiler();
+	profiler.begin(ProfilePhase::gui_build);
 	ImGui_ImplOpenGL3_NewFrame();
 	ImGui_ImplGlfw_NewFrame();
 	ImGui::NewFrame();
@@ -564,5 +910,9 @@ void render_gui() {
 	ImGui::PopStyleVar(3);
 
 	ImGui::Render();
+	profiler.end(ProfilePhase::gui_build);
+
+	profiler.begin(ProfilePhase::gui_render);
 	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+	profiler.end(ProfilePhase::gui_render);
 }
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <cmath>
+
+#include "mandelbulb.h"
+
+static glm::vec2 complex_mul(const glm::vec2 a, const glm::vec2 b) {
+	return {a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x};
+}
+
+static glm::vec2 complex_pow(glm::vec2 c, int n) {
+	glm::vec2 result(1.0f, 0.0f);
+	for (; n > 0; n >>= 1) {
+		if (n & 1) result = complex_mul(result, c);
+		c = complex_mul(c, c);
+	}
+	return result;
+}
+
+static float integer_pow(float x, int n) {
+	float result = 1.0f;
+	for (; n > 0; n >>= 1) {
+		if (n & 1) result *= x;
+		x *= x;
+	}
+	return result;
+}
+
+// A value and its gradient with respect to the sample position.
+struct Dual {
+	float value;
+	glm::vec3 gradient;
+};
+
+static Dual dual_add(const Dual a, const Dual b) {
+	return {a.value + b.value, a.gradient + b.gradient};
+}
+
+static Dual dual_mul(const Dual a, const Dual b) {
+	return {a.value * b.value, a.value * b.gradient + b.value * a.gradient};
+}
+
+static Dual dual_scale(const Dual a, const float s) {
+	return {a.value * s, a.gradient * s};
+}
+
+static Dual dual_div(const Dual a, const Dual b) {
+	return {a.value / b.value, (a.gradient * b.value - a.value * b.gradient) / (b.value * b.value)};
+}
+
+static Dual dual_sqrt(const Dual a) {
+	const float root = std::sqrt(a.value);
+	return {root, a.gradient * (0.5f / root)};
+}
+
+static Dual dual_sin(const Dual a) {
+	return {std::sin(a.value), std::cos(a.value) * a.gradient};
+}
+
+static Dual dual_cos(const Dual a) {
+	return {std::cos(a.value), -std::sin(a.value) * a.gradient};
+}
+
+static Dual dual_acos(const Dual a) {
+	return {std::acos(a.value), a.gradient * (-1.0f / std::sqrt(std::max(1.0f - a.value * a.value, 1e-12f)))};
+}
+
+static Dual dual_atan2(const Dual y, const Dual x) {
+	return {std::atan2(y.value, x.value), (x.value * y.gradient - y.value * x.gradient) / (x.value * x.value + y.value * y.value)};
+}
+
+static float max_abs(const glm::vec3 v) {
+	return std::max({std::abs(v.x), std::abs(v.y), std::abs(v.z)});
+}
+
+static Dual dual_log(const Dual a) {
+	return {std::log(a.value), a.gradient / a.value};
+}
+
+static Dual dual_pow(const Dual a, const float n) {
+	const float power_minus_one = std::pow(a.value, n - 1.0f);
+	return {power_minus_one * a.value, a.gradient * (n * power_minus_one)};
+}
+
+float sphere(const glm::vec3 pos, const glm::vec3 center, const float radius) {
+	return glm::length(pos - center) - radius;
+}
+
+float mandelbulb(const glm::vec3 pos, const float power, const int iterations, const float escape_radius, float& orbit_trap_dist) {
+	constexpr auto orbit_trap_center = glm::vec3(0.0f, 0.0f, 0.0f);
+	constexpr float orbit_trap_radius = 0.5f;
+
+	glm::vec3 z = pos;
+	float dr = 1.0f;
+	float r = 0.0f;
+
+	for (int i = 0; i < iterations; i++) {
+		r = glm::length(z);
+		if (r > escape_radius) break;
+
+		const float dist_to_trap = glm::length(z - orbit_trap_center) - orbit_trap_radius;
+		orbit_trap_dist = std::min(orbit_trap_dist, dist_to_trap);
+
+		float theta = std::acos(z.z / r);
+		float phi = std::atan2(z.y, z.x);
+		dr = std::pow(r, power - 1.0f) * power * dr + 1.0f;
+
+		const float zr = std::pow(r, power);
+		theta = theta * power;
+		phi = phi * power;
+
+		z = zr * glm::vec3(
+			std::sin(theta) * std::cos(phi),
+			std::sin(phi) * std::sin(theta),
+			std::cos(theta)
+		) + pos;
+	}
+	return 0.5f * std::log(r) * r / dr;
+}
+
+// With (cos(theta), sin(theta)) = (z, rho) / r and (cos(phi), sin(phi)) = (x, y) / rho, the
+// multiplied angles of the generic formula are the arguments of complex powers, so each
+// iteration needs only multiplications, two square roots and two divisions.
+float mandelbulb_integer_power(const glm::vec3 pos, const int power, const int iterations, const float escape_radius, float& orbit_trap_dist) {
+	constexpr auto orbit_trap_center = glm::vec3(0.0f, 0.0f, 0.0f);
+	constexpr float orbit_trap_radius = 0.5f;
+
+	glm::vec3 z = pos;
+	float dr = 1.0f;
+	float r = 0.0f;
+
+	for (int i = 0; i < iterations; i++) {
+		r = glm::length(z);
+		if (r > escape_radius) break;
+
+		const float dist_to_trap = glm::length(z - orbit_trap_center) - orbit_trap_radius;
+		orbit_trap_dist = std::min(orbit_trap_dist, dist_to_trap);
+
+		const float rho = std::sqrt(z.x * z.x + z.y * z.y);
+		const glm::vec2 theta = complex_pow(glm::vec2(z.z, rho) / r, power);
+		const glm::vec2 phi = complex_pow(rho > 0.0f ? glm::vec2(z.x, z.y) / rho : glm::vec2(1.0f, 0.0f), power);
+
+		const float r_power_minus_one = integer_pow(r, power - 1);
+		dr = r_power_minus_one * static_cast<float>(power) * dr + 1.0f;
+
+		z = r_power_minus_one * r * glm::vec3(
+			theta.y * phi.x,
+			theta.y * phi.y,
+			theta.x
+		) + pos;
+	}
+	return 0.5f * std::log(r) * r / dr;
+}
+
+int integer_power(const float power) {
+	const float rounded = std::round(power);
+	if (rounded != power || rounded < min_integer_power || rounded > max_integer_power) {
+		return 0;
+	}
+	return static_cast<int>(rounded);
+}
+
+std::span<const glm::vec3> normal_taps(const int normal_method) {
+	static constexpr glm::vec3 central_differences[] = {
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+	};
+	// Corners of a tetrahedron, at the same distance from the center as the central-difference taps
+	constexpr float k = 0.57735027f;
+	static constexpr glm::vec3 tetrahedral[] = {
+		glm::vec3(k, -k, -k), glm::vec3(-k, -k, k),
+		glm::vec3(-k, k, -k), glm::vec3(k, k, k)
+	};
+
+	switch (normal_method) {
+	case normal_method_central_differences:
+		return central_differences;
+	case normal_method_tetrahedral:
+		return tetrahedral;
+	default:
+		return {};
+	}
+}
+
+// mandelbulb() on dual numbers, which yields the exact gradient of the distance estimate.
+glm::vec3 mandelbulb_analytic_normal(const glm::vec3 pos, const float power, const int iterations, const float escape_radius) {
+	// Gradients grow like dr and would overflow within a few dozen iterations. Only the direction
+	// of the result matters, so all of them are kept rescaled, including that of the added pos.
+	constexpr float max_gradient = 1e10f;
+	float pos_scale = 1.0f;
+	Dual z[3] = {
+		{pos.x, glm::vec3(1.0f, 0.0f, 0.0f)},
+		{pos.y, glm::vec3(0.0f, 1.0f, 0.0f)},
+		{pos.z, glm::vec3(0.0f, 0.0f, 1.0f)}
+	};
+	Dual dr{1.0f, glm::vec3(0.0f)};
+	Dual r{};
+
+	for (int i = 0; i < iterations; i++) {
+		r = dual_sqrt(dual_add(dual_add(dual_mul(z[0], z[0]), dual_mul(z[1], z[1])), dual_mul(z[2], z[2])));
+		if (r.value > escape_radius) break;
+
+		const Dual theta = dual_scale(dual_acos(dual_div(z[2], r)), power);
+		const Dual phi = dual_scale(dual_atan2(z[1], z[0]), power);
+		const Dual r_power_minus_one = dual_pow(r, power - 1.0f);
+		dr = dual_add(dual_scale(dual_mul(r_power_minus_one, dr), power), {1.0f, glm::vec3(0.0f)});
+
+		const Dual zr = dual_mul(r_power_minus_one, r);
+		const Dual sin_theta = dual_sin(theta);
+		z[0] = dual_add(dual_mul(zr, dual_mul(sin_theta, dual_cos(phi))), {pos.x, glm::vec3(pos_scale, 0.0f, 0.0f)});
+		z[1] = dual_add(dual_mul(zr, dual_mul(dual_sin(phi), sin_theta)), {pos.y, glm::vec3(0.0f, pos_scale, 0.0f)});
+		z[2] = dual_add(dual_mul(zr, dual_cos(theta)), {pos.z, glm::vec3(0.0f, 0.0f, pos_scale)});
+
+		const float largest = std::max({max_abs(z[0].gradient), max_abs(z[1].gradient), max_abs(z[2].gradient), max_abs(dr.gradient)});
+		if (largest > max_gradient) {
+			const float scale = 1.0f / largest;
+			for (Dual& component : z) {
+				component.gradient *= scale;
+			}
+			dr.gradient *= scale;
+			r.gradient *= scale;
+			pos_scale *= scale;
+		}
+	}
+
+	const Dual dist = dual_div(dual_mul(dual_log(r), r), dr);
+	return glm::normalize(dist.gradient);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <span>
+
+#include <glm/glm.hpp>
+
+// CPU ports of the distance estimators in shaders/shader.frag.
+float sphere(glm::vec3 pos, glm::vec3 center, float radius);
+float mandelbulb(glm::vec3 pos, float power, int iterations, float escape_radius, float& orbit_trap_dist);
+float mandelbulb_integer_power(glm::vec3 pos, int power, int iterations, float escape_radius, float& orbit_trap_dist);
+
+// Returns power as an integer if it is a whole number in [min_integer_power, max_integer_power],
+// which selects the trig-free mandelbulb_integer_power(), or 0 otherwise.
+constexpr int min_integer_power = 2;
+constexpr int max_integer_power = 64;
+int integer_power(float power);
+
+// Methods of calculate_normal() in shaders/shader.frag, selected by AppSettings::normal_method.
+constexpr int normal_method_central_differences = 0;
+constexpr int normal_method_tetrahedral = 1;
+constexpr int normal_method_analytic = 2;
+constexpr float normal_epsilon = 0.001f;
+
+// Sample directions of the finite-difference normal methods: the normal at pos is the normalized
+// sum of direction * DE(pos + normal_epsilon * direction) over all of them. Central differences
+// take 6 samples and the tetrahedral method 4. Empty for the analytic method.
+std::span<const glm::vec3> normal_taps(int normal_method);
+
+// Normal from the exact gradient of the distance estimate, carried through the iteration with
+// dual numbers. Needs one evaluation instead of one per tap, at a few times its arithmetic.
+glm::vec3 mandelbulb_analytic_normal(glm::vec3 pos, float power, int iterations, float escape_radius);
@@ -0,0 +1,91 @@
+#include <immintrin.h>
+
+#include "mandelbulb_simd.h"
+
+// Compiled with AVX2 and FMA enabled (see CMakeLists.txt). Only called after detect_simd_level() confirms support.
+
+namespace {
+
+struct Vec8 {
+	static constexpr int width = 8;
+
+	struct Mask {
+		__m256 m;
+	};
+
+	__m256 v;
+
+	Vec8() = default;
+	Vec8(const __m256 v) : v(v) {}
+	explicit Vec8(const float s) : v(_mm256_set1_ps(s)) {}
+
+	static Mask tail_mask(const int lanes) {
+		const __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		return {_mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(lanes), index))};
+	}
+
+	static Vec8 load(const float* p, const int lanes, const float padding) {
+		if (lanes == width) {
+			return _mm256_loadu_ps(p);
+		}
+		const Mask mask = tail_mask(lanes);
+		const __m256 loaded = _mm256_maskload_ps(p, _mm256_castps_si256(mask.m));
+		return _mm256_blendv_ps(_mm256_set1_ps(padding), loaded, mask.m);
+	}
+
+	static void store(float* p, const int lanes, const Vec8 value) {
+		if (lanes == width) {
+			_mm256_storeu_ps(p, value.v);
+		} else {
+			_mm256_maskstore_ps(p, _mm256_castps_si256(tail_mask(lanes).m), value.v);
+		}
+	}
+};
+
+Vec8 operator+(const Vec8 a, const Vec8 b) { return _mm256_add_ps(a.v, b.v); }
+Vec8 operator-(const Vec8 a, const Vec8 b) { return _mm256_sub_ps(a.v, b.v); }
+Vec8 operator*(const Vec8 a, const Vec8 b) { return _mm256_mul_ps(a.v, b.v); }
+Vec8 operator/(const Vec8 a, const Vec8 b) { return _mm256_div_ps(a.v, b.v); }
+Vec8::Mask operator<(const Vec8 a, const Vec8 b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)}; }
+Vec8::Mask operator>(const Vec8 a, const Vec8 b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)}; }
+Vec8::Mask operator<=(const Vec8 a, const Vec8 b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)}; }
+Vec8::Mask operator&(const Vec8::Mask a, const Vec8::Mask b) { return {_mm256_and_ps(a.m, b.m)}; }
+
+Vec8::Mask vandnot(const Vec8::Mask a, const Vec8::Mask b) { return {_mm256_andnot_ps(a.m, b.m)}; }
+bool vany(const Vec8::Mask a) { return _mm256_movemask_ps(a.m) != 0; }
+Vec8 vselect(const Vec8::Mask mask, const Vec8 a, const Vec8 b) { return _mm256_blendv_ps(b.v, a.v, mask.m); }
+Vec8 vfmadd(const Vec8 a, const Vec8 b, const Vec8 c) { return _mm256_fmadd_ps(a.v, b.v, c.v); }
+Vec8 vsqrt(const Vec8 a) { return _mm256_sqrt_ps(a.v); }
+Vec8 vmin(const Vec8 a, const Vec8 b) { return _mm256_min_ps(a.v, b.v); }
+Vec8 vmax(const Vec8 a, const Vec8 b) { return _mm256_max_ps(a.v, b.v); }
+Vec8 vabs(const Vec8 a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+Vec8 vround(const Vec8 a) { return _mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+Vec8 vfloor(const Vec8 a) { return _mm256_floor_ps(a.v); }
+
+// Returns the mantissa of x in [1, 2) and stores its unbiased exponent.
+Vec8 vsplit_exponent(const Vec8 x, Vec8& exponent) {
+	const __m256i bits = _mm256_castps_si256(x.v);
+	const __m256i biased = _mm256_srli_epi32(bits, 23);
+	exponent = _mm256_cvtepi32_ps(_mm256_sub_epi32(biased, _mm256_set1_epi32(127)));
+	const __m256i mantissa = _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F800000));
+	return _mm256_castsi256_ps(mantissa);
+}
+
+// 2^n for integral n in [-126, 127].
+Vec8 vpow2i(const Vec8 n) {
+	const __m256i biased = _mm256_add_epi32(_mm256_cvtps_epi32(n.v), _mm256_set1_epi32(127));
+	return _mm256_castsi256_ps(_mm256_slli_epi32(biased, 23));
+}
+
+}
+
+#include "mandelbulb_simd_kernel.h"
+
+void mandelbulb_batch_avx2(const float* x, const float* y, const float* z, const int count, const MandelbulbParams& params,
+	float* dist, float* orbit_trap_dist) {
+	if (params.integer_power > 0) {
+		mandelbulb_integer_power_kernel<Vec8>(x, y, z, count, params, dist, orbit_trap_dist);
+	} else {
+		mandelbulb_kernel<Vec8>(x, y, z, count, params, dist, orbit_trap_dist);
+	}
+}
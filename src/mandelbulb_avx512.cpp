@@ -0,0 +1,88 @@
+#include <immintrin.h>
+
+#include "mandelbulb_simd.h"
+
+// Compiled with AVX-512F enabled (see CMakeLists.txt). Only called after detect_simd_level() confirms support.
+
+namespace {
+
+struct Vec16 {
+	static constexpr int width = 16;
+
+	struct Mask {
+		__mmask16 m;
+	};
+
+	__m512 v;
+
+	Vec16() = default;
+	Vec16(const __m512 v) : v(v) {}
+	explicit Vec16(const float s) : v(_mm512_set1_ps(s)) {}
+
+	static Mask tail_mask(const int lanes) {
+		return {static_cast<__mmask16>((1u << lanes) - 1u)};
+	}
+
+	static Vec16 load(const float* p, const int lanes, const float padding) {
+		if (lanes == width) {
+			return _mm512_loadu_ps(p);
+		}
+		return _mm512_mask_loadu_ps(_mm512_set1_ps(padding), tail_mask(lanes).m, p);
+	}
+
+	static void store(float* p, const int lanes, const Vec16 value) {
+		if (lanes == width) {
+			_mm512_storeu_ps(p, value.v);
+		} else {
+			_mm512_mask_storeu_ps(p, tail_mask(lanes).m, value.v);
+		}
+	}
+};
+
+Vec16 operator+(const Vec16 a, const Vec16 b) { return _mm512_add_ps(a.v, b.v); }
+Vec16 operator-(const Vec16 a, const Vec16 b) { return _mm512_sub_ps(a.v, b.v); }
+Vec16 operator*(const Vec16 a, const Vec16 b) { return _mm512_mul_ps(a.v, b.v); }
+Vec16 operator/(const Vec16 a, const Vec16 b) { return _mm512_div_ps(a.v, b.v); }
+Vec16::Mask operator<(const Vec16 a, const Vec16 b) { return {_mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ)}; }
+Vec16::Mask operator>(const Vec16 a, const Vec16 b) { return {_mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ)}; }
+Vec16::Mask operator<=(const Vec16 a, const Vec16 b) { return {_mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ)}; }
+Vec16::Mask operator&(const Vec16::Mask a, const Vec16::Mask b) { return {static_cast<__mmask16>(a.m & b.m)}; }
+
+Vec16::Mask vandnot(const Vec16::Mask a, const Vec16::Mask b) { return {static_cast<__mmask16>(~a.m & b.m)}; }
+bool vany(const Vec16::Mask a) { return a.m != 0; }
+Vec16 vselect(const Vec16::Mask mask, const Vec16 a, const Vec16 b) { return _mm512_mask_blend_ps(mask.m, b.v, a.v); }
+Vec16 vfmadd(const Vec16 a, const Vec16 b, const Vec16 c) { return _mm512_fmadd_ps(a.v, b.v, c.v); }
+Vec16 vsqrt(const Vec16 a) { return _mm512_sqrt_ps(a.v); }
+Vec16 vmin(const Vec16 a, const Vec16 b) { return _mm512_min_ps(a.v, b.v); }
+Vec16 vmax(const Vec16 a, const Vec16 b) { return _mm512_max_ps(a.v, b.v); }
+Vec16 vabs(const Vec16 a) { return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a.v), _mm512_set1_epi32(0x7FFFFFFF))); }
+Vec16 vround(const Vec16 a) { return _mm512_roundscale_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+Vec16 vfloor(const Vec16 a) { return _mm512_roundscale_ps(a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+
+// Returns the mantissa of x in [1, 2) and stores its unbiased exponent.
+Vec16 vsplit_exponent(const Vec16 x, Vec16& exponent) {
+	const __m512i bits = _mm512_castps_si512(x.v);
+	const __m512i biased = _mm512_srli_epi32(bits, 23);
+	exponent = _mm512_cvtepi32_ps(_mm512_sub_epi32(biased, _mm512_set1_epi32(127)));
+	const __m512i mantissa = _mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi32(0x007FFFFF)), _mm512_set1_epi32(0x3F800000));
+	return _mm512_castsi512_ps(mantissa);
+}
+
+// 2^n for integral n in [-126, 127].
+Vec16 vpow2i(const Vec16 n) {
+	const __m512i biased = _mm512_add_epi32(_mm512_cvtps_epi32(n.v), _mm512_set1_epi32(127));
+	return _mm512_castsi512_ps(_mm512_slli_epi32(biased, 23));
+}
+
+}
+
+#include "mandelbulb_simd_kernel.h"
+
+void mandelbulb_batch_avx512(const float* x, const float* y, const float* z, const int count, const MandelbulbParams& params,
+	float* dist, float* orbit_trap_dist) {
+	if (params.integer_power > 0) {
+		mandelbulb_integer_power_kernel<Vec16>(x, y, z, count, params, dist, orbit_trap_dist);
+	} else {
+		mandelbulb_kernel<Vec16>(x, y, z, count, params, dist, orbit_trap_dist);
+	}
+}
@@ -0,0 +1,122 @@
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "mandelbulb.h"
+#include "mandelbulb_simd.h"
+
+// Defined in mandelbulb_avx2.cpp and mandelbulb_avx512.cpp, which are compiled for their instruction sets.
+void mandelbulb_batch_avx2(const float* x, const float* y, const float* z, int count, const MandelbulbParams& params,
+	float* dist, float* orbit_trap_dist);
+void mandelbulb_batch_avx512(const float* x, const float* y, const float* z, int count, const MandelbulbParams& params,
+	float* dist, float* orbit_trap_dist);
+
+static void mandelbulb_batch_scalar(const float* x, const float* y, const float* z, const int count, const MandelbulbParams& params,
+	float* dist, float* orbit_trap_dist) {
+	for (int i = 0; i < count; i++) {
+		const glm::vec3 pos(x[i], y[i], z[i]);
+		float trap = 1e20f;
+		dist[i] = params.integer_power > 0
+			? mandelbulb_integer_power(pos, params.integer_power, params.iterations, params.escape_radius, trap)
+			: mandelbulb(pos, params.power, params.iterations, params.escape_radius, trap);
+		if (orbit_trap_dist) {
+			orbit_trap_dist[i] = trap;
+		}
+	}
+}
+
+using MandelbulbBatchFunction = void (*)(const float*, const float*, const float*, int, const MandelbulbParams&, float*, float*);
+
+static MandelbulbBatchFunction batch_function(const SimdLevel level) {
+	switch (level) {
+	case SimdLevel::avx512:
+		return mandelbulb_batch_avx512;
+	case SimdLevel::avx2:
+		return mandelbulb_batch_avx2;
+	default:
+		return mandelbulb_batch_scalar;
+	}
+}
+
+static SimdLevel current_level = detect_simd_level();
+static MandelbulbBatchFunction current_function = batch_function(current_level);
+
+SimdLevel detect_simd_level() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return SimdLevel::scalar;
+	}
+
+	__cpuidex(info, 1, 0);
+	const bool has_fma = (info[2] & (1 << 12)) != 0;
+	const bool has_osxsave = (info[2] & (1 << 27)) != 0;
+	if (!has_fma || !has_osxsave) {
+		return SimdLevel::scalar;
+	}
+
+	// The operating system must save the YMM (and for AVX-512, the opmask and ZMM) registers.
+	const unsigned long long xcr0 = _xgetbv(0);
+	__cpuidex(info, 7, 0);
+	const bool has_avx2 = (info[1] & (1 << 5)) != 0 && (xcr0 & 0x06) == 0x06;
+	const bool has_avx512 = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	const bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	const bool has_avx512 = has_avx2 && __builtin_cpu_supports("avx512f");
+#else
+	constexpr bool has_avx2 = false;
+	constexpr bool has_avx512 = false;
+#endif
+
+	if (has_avx512) {
+		return SimdLevel::avx512;
+	}
+	if (has_avx2) {
+		return SimdLevel::avx2;
+	}
+	return SimdLevel::scalar;
+}
+
+MandelbulbParams make_mandelbulb_params(const float power, const int iterations, const float escape_radius) {
+	return {power, iterations, escape_radius, integer_power(power)};
+}
+
+SimdLevel get_simd_level() {
+	return current_level;
+}
+
+void set_simd_level(const SimdLevel level) {
+	current_level = std::min(level, detect_simd_level());
+	current_function = batch_function(current_level);
+}
+
+const char* simd_level_name(const SimdLevel level) {
+	switch (level) {
+	case SimdLevel::avx512:
+		return "AVX-512";
+	case SimdLevel::avx2:
+		return "AVX2";
+	default:
+		return "Scalar";
+	}
+}
+
+int simd_width(const SimdLevel level) {
+	switch (level) {
+	case SimdLevel::avx512:
+		return 16;
+	case SimdLevel::avx2:
+		return 8;
+	default:
+		return 1;
+	}
+}
+
+void mandelbulb_batch(const float* x, const float* y, const float* z, const int count, const MandelbulbParams& params,
+	float* dist, float* orbit_trap_dist) {
+	current_function(x, y, z, count, params, dist, orbit_trap_dist);
+}
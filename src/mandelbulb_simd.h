@@ -0,0 +1,36 @@
+#pragma once
+
+enum class SimdLevel {
+	scalar,
+	avx2,
+	avx512
+};
+
+struct MandelbulbParams {
+	float power;
+	int iterations;
+	float escape_radius;
+	// Whole-number power that selects the trig-free kernel, or 0 for the generic formula.
+	int integer_power;
+
+	bool operator==(const MandelbulbParams&) const = default;
+};
+
+// Fills in integer_power automatically from power (see integer_power() in mandelbulb.h).
+[[nodiscard]] MandelbulbParams make_mandelbulb_params(float power, int iterations, float escape_radius);
+
+// Widest instruction set supported by the CPU and operating system.
+[[nodiscard]] SimdLevel detect_simd_level();
+// Instruction set used by mandelbulb_batch(). Defaults to detect_simd_level().
+[[nodiscard]] SimdLevel get_simd_level();
+// Selects a narrower instruction set, e.g. for comparisons. Levels the CPU lacks are clamped.
+void set_simd_level(SimdLevel level);
+[[nodiscard]] const char* simd_level_name(SimdLevel level);
+[[nodiscard]] int simd_width(SimdLevel level);
+
+// Evaluates mandelbulb() for count points given in structure-of-arrays layout. Points are
+// processed 8 (AVX2) or 16 (AVX-512) at a time with per-lane escape masks. If orbit_trap_dist
+// is not null, it receives the orbit trap distance of each point's orbit. Whole-number powers use
+// the polynomial formula of mandelbulb_integer_power() and need no transcendental functions.
+void mandelbulb_batch(const float* x, const float* y, const float* z, int count, const MandelbulbParams& params,
+	float* dist, float* orbit_trap_dist = nullptr);
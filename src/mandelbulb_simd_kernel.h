@@ -0,0 +1,271 @@
+#pragma once
+
+// Vectorized mandelbulb() shared by the per-instruction-set translation units. Each of those defines
+// a float vector type V (with V::width lanes and a mask type V::Mask) plus the v* primitives used
+// below in an anonymous namespace, then includes this header, so nothing here is compiled for the
+// wrong instruction set. Only headers free of inline library code may be included alongside it.
+//
+// The transcendental approximations follow the Cephes single-precision polynomials and are
+// accurate to a few ulp over the ranges the distance estimator uses.
+
+namespace {
+
+constexpr float simd_pi = 3.14159265358979323846f;
+constexpr float simd_half_pi = 1.57079632679489661923f;
+constexpr float simd_quarter_pi = 0.78539816339744830962f;
+constexpr float simd_ln2 = 0.69314718055994530942f;
+constexpr float simd_log2e = 1.44269504088896340736f;
+
+// atan2(y, x) in [-pi, pi], with atan2(0, 0) = 0.
+template <typename V>
+V vatan2(const V y, const V x) {
+	const V ax = vabs(x);
+	const V ay = vabs(y);
+	const V max_xy = vmax(ax, ay);
+	const V min_xy = vmin(ax, ay);
+	const V a = vselect(max_xy > V(0.0f), min_xy / max_xy, V(0.0f));
+
+	// Reduce to |t| <= tan(pi/8) using atan(a) = pi/4 + atan((a - 1) / (a + 1)).
+	const typename V::Mask reduce = a > V(0.41421356237f);
+	const V t = vselect(reduce, (a - V(1.0f)) / (a + V(1.0f)), a);
+	const V offset = vselect(reduce, V(simd_quarter_pi), V(0.0f));
+
+	const V z = t * t;
+	V p = V(8.05374449538e-2f);
+	p = vfmadd(p, z, V(-1.38776856032e-1f));
+	p = vfmadd(p, z, V(1.99777106478e-1f));
+	p = vfmadd(p, z, V(-3.33329491539e-1f));
+	V result = offset + vfmadd(p * z, t, t);
+
+	result = vselect(ay > ax, V(simd_half_pi) - result, result);
+	result = vselect(x < V(0.0f), V(simd_pi) - result, result);
+	return vselect(y < V(0.0f), V(0.0f) - result, result);
+}
+
+// sin(x) and cos(x) with Cody-Waite reduction to [-pi/4, pi/4].
+template <typename V>
+void vsincos(const V x, V& sin_x, V& cos_x) {
+	const V q = vround(x * V(2.0f / simd_pi));
+	V r = vfmadd(q, V(-1.5703125f), x);
+	r = vfmadd(q, V(-4.837512969970703125e-4f), r);
+	r = vfmadd(q, V(-7.54978995489188216e-8f), r);
+
+	const V z = r * r;
+	V s = V(-1.9515295891e-4f);
+	s = vfmadd(s, z, V(8.3321608736e-3f));
+	s = vfmadd(s, z, V(-1.6666654611e-1f));
+	s = vfmadd(s * z, r, r);
+
+	V c = V(2.443315711809948e-5f);
+	c = vfmadd(c, z, V(-1.388731625493765e-3f));
+	c = vfmadd(c, z, V(4.166664568298827e-2f));
+	c = vfmadd(c * z, z, vfmadd(z, V(-0.5f), V(1.0f)));
+
+	// Quadrant q mod 4 selects and negates the results.
+	const V quadrant = q - V(4.0f) * vfloor(q * V(0.25f));
+	const typename V::Mask odd = quadrant - V(2.0f) * vfloor(quadrant * V(0.5f)) > V(0.5f);
+	const typename V::Mask negate_sin = quadrant > V(1.5f);
+	const typename V::Mask negate_cos = (quadrant > V(0.5f)) & (quadrant < V(2.5f));
+
+	sin_x = vselect(odd, c, s);
+	cos_x = vselect(odd, s, c);
+	sin_x = vselect(negate_sin, V(0.0f) - sin_x, sin_x);
+	cos_x = vselect(negate_cos, V(0.0f) - cos_x, cos_x);
+}
+
+// log2(x) for positive normal x.
+template <typename V>
+V vlog2(const V x) {
+	V exponent;
+	V m = vsplit_exponent(x, exponent);
+
+	// Center the mantissa on 1 so the polynomial argument stays within [-0.29, 0.41].
+	const typename V::Mask high = m > V(1.41421356237f);
+	m = vselect(high, m * V(0.5f), m);
+	exponent = vselect(high, exponent + V(1.0f), exponent);
+
+	const V f = m - V(1.0f);
+	const V z = f * f;
+	V y = V(7.0376836292e-2f);
+	y = vfmadd(y, f, V(-1.1514610310e-1f));
+	y = vfmadd(y, f, V(1.1676998740e-1f));
+	y = vfmadd(y, f, V(-1.2420140846e-1f));
+	y = vfmadd(y, f, V(1.4249322787e-1f));
+	y = vfmadd(y, f, V(-1.6668057665e-1f));
+	y = vfmadd(y, f, V(2.0000714765e-1f));
+	y = vfmadd(y, f, V(-2.4999993993e-1f));
+	y = vfmadd(y, f, V(3.3333331174e-1f));
+	y = y * f * z;
+	y = vfmadd(z, V(-0.5f), y);
+
+	return vfmadd(f + y, V(simd_log2e), exponent);
+}
+
+// 2^x, clamped to the normal float range.
+template <typename V>
+V vexp2(V x) {
+	x = vmin(vmax(x, V(-126.0f)), V(127.0f));
+	const V n = vround(x);
+	const V f = x - n;
+
+	V p = V(1.535336188319500e-4f);
+	p = vfmadd(p, f, V(1.339887440266574e-3f));
+	p = vfmadd(p, f, V(9.618437357674640e-3f));
+	p = vfmadd(p, f, V(5.550332471162809e-2f));
+	p = vfmadd(p, f, V(2.402264791363012e-1f));
+	p = vfmadd(p, f, V(6.931472028550421e-1f));
+	p = vfmadd(p, f, V(1.0f));
+
+	return p * vpow2i(n);
+}
+
+// (re, im)^n for n >= 0 by binary exponentiation. n is the same for all lanes.
+template <typename V>
+void vcomplex_pow(V re, V im, int n, V& result_re, V& result_im) {
+	result_re = V(1.0f);
+	result_im = V(0.0f);
+	for (; n > 0; n >>= 1) {
+		if (n & 1) {
+			const V next_re = vfmadd(result_re, re, V(0.0f) - result_im * im);
+			result_im = vfmadd(result_re, im, result_im * re);
+			result_re = next_re;
+		}
+		const V next_re = vfmadd(re, re, V(0.0f) - im * im);
+		im = V(2.0f) * re * im;
+		re = next_re;
+	}
+}
+
+// x^n for n >= 0 by binary exponentiation. n is the same for all lanes.
+template <typename V>
+V vinteger_pow(V x, int n) {
+	V result(1.0f);
+	for (; n > 0; n >>= 1) {
+		if (n & 1) result = result * x;
+		x = x * x;
+	}
+	return result;
+}
+
+template <typename V>
+void mandelbulb_kernel(const float* x, const float* y, const float* z, const int count, const MandelbulbParams& params,
+	float* dist, float* orbit_trap_dist) {
+	const V power(params.power);
+	const V escape_radius(params.escape_radius);
+	// Padding lanes start outside the escape radius so they never keep the loop running.
+	const float padding = params.escape_radius + 1.0f;
+
+	for (int base = 0; base < count; base += V::width) {
+		const int lanes = (count - base < V::width) ? count - base : V::width;
+		const V cx = V::load(x + base, lanes, padding);
+		const V cy = V::load(y + base, lanes, padding);
+		const V cz = V::load(z + base, lanes, padding);
+
+		V zx = cx;
+		V zy = cy;
+		V zz = cz;
+		V dr(1.0f);
+		V r(0.0f);
+		V trap(1e20f);
+		typename V::Mask active = V::tail_mask(lanes);
+
+		for (int i = 0; i < params.iterations; i++) {
+			const V length = vsqrt(vfmadd(zx, zx, vfmadd(zy, zy, zz * zz)));
+			r = vselect(active, length, r);
+			active = vandnot(length > escape_radius, active);
+			if (!vany(active)) break;
+
+			trap = vselect(active, vmin(trap, r - V(0.5f)), trap);
+
+			// theta = acos(z / r) is evaluated as atan2(sqrt(x^2 + y^2), z), which is equal for r > 0.
+			const V rho = vsqrt(vfmadd(zx, zx, zy * zy));
+			const V theta = vatan2(rho, zz) * power;
+			const V phi = vatan2(zy, zx) * power;
+
+			// pow(r, power) and pow(r, power - 1) share one logarithm.
+			const V log_r = vlog2(r);
+			const V zr = vexp2(power * log_r);
+			V r_power_minus_one = zr / r;
+			const typename V::Mask zero_r = r <= V(0.0f);
+			if (vany(zero_r)) {
+				r_power_minus_one = vselect(zero_r, vexp2((power - V(1.0f)) * log_r), r_power_minus_one);
+			}
+			dr = vselect(active, vfmadd(r_power_minus_one * power, dr, V(1.0f)), dr);
+
+			V sin_theta, cos_theta, sin_phi, cos_phi;
+			vsincos(theta, sin_theta, cos_theta);
+			vsincos(phi, sin_phi, cos_phi);
+
+			const V zr_sin_theta = zr * sin_theta;
+			zx = vselect(active, vfmadd(zr_sin_theta, cos_phi, cx), zx);
+			zy = vselect(active, vfmadd(zr_sin_theta, sin_phi, cy), zy);
+			zz = vselect(active, vfmadd(zr, cos_theta, cz), zz);
+		}
+
+		const V ln_r = vlog2(r) * V(simd_ln2);
+		V::store(dist + base, lanes, V(0.5f) * ln_r * r / dr);
+		if (orbit_trap_dist) {
+			V::store(orbit_trap_dist + base, lanes, trap);
+		}
+	}
+}
+
+// Trig-free kernel for whole-number powers; see mandelbulb_integer_power() in mandelbulb.cpp.
+template <typename V>
+void mandelbulb_integer_power_kernel(const float* x, const float* y, const float* z, const int count, const MandelbulbParams& params,
+	float* dist, float* orbit_trap_dist) {
+	const int n = params.integer_power;
+	const V power(static_cast<float>(n));
+	const V escape_radius(params.escape_radius);
+	const float padding = params.escape_radius + 1.0f;
+
+	for (int base = 0; base < count; base += V::width) {
+		const int lanes = (count - base < V::width) ? count - base : V::width;
+		const V cx = V::load(x + base, lanes, padding);
+		const V cy = V::load(y + base, lanes, padding);
+		const V cz = V::load(z + base, lanes, padding);
+
+		V zx = cx;
+		V zy = cy;
+		V zz = cz;
+		V dr(1.0f);
+		V r(0.0f);
+		V trap(1e20f);
+		typename V::Mask active = V::tail_mask(lanes);
+
+		for (int i = 0; i < params.iterations; i++) {
+			const V length = vsqrt(vfmadd(zx, zx, vfmadd(zy, zy, zz * zz)));
+			r = vselect(active, length, r);
+			active = vandnot(length > escape_radius, active);
+			if (!vany(active)) break;
+
+			trap = vselect(active, vmin(trap, r - V(0.5f)), trap);
+
+			const V rho = vsqrt(vfmadd(zx, zx, zy * zy));
+			const V inverse_r = V(1.0f) / r;
+			const typename V::Mask has_rho = rho > V(0.0f);
+			const V inverse_rho = V(1.0f) / rho;
+
+			V theta_re, theta_im, phi_re, phi_im;
+			vcomplex_pow(zz * inverse_r, rho * inverse_r, n, theta_re, theta_im);
+			vcomplex_pow(vselect(has_rho, zx * inverse_rho, V(1.0f)), vselect(has_rho, zy * inverse_rho, V(0.0f)), n, phi_re, phi_im);
+
+			const V r_power_minus_one = vinteger_pow(r, n - 1);
+			dr = vselect(active, vfmadd(r_power_minus_one * power, dr, V(1.0f)), dr);
+
+			const V zr = r_power_minus_one * r;
+			const V zr_sin_theta = zr * theta_im;
+			zx = vselect(active, vfmadd(zr_sin_theta, phi_re, cx), zx);
+			zy = vselect(active, vfmadd(zr_sin_theta, phi_im, cy), zy);
+			zz = vselect(active, vfmadd(zr, theta_re, cz), zz);
+		}
+
+		const V ln_r = vlog2(r) * V(simd_ln2);
+		V::store(dist + base, lanes, V(0.5f) * ln_r * r / dr);
+		if (orbit_trap_dist) {
+			V::store(orbit_trap_dist + base, lanes, trap);
+		}
+	}
+}
+
+}
@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "formula.h"
+#include "mesh_extractor.h"
+
+namespace {
+
+constexpr uint32_t no_vertex = std::numeric_limits<uint32_t>::max();
+
+// Corners of a cell are numbered by their offsets, x in bit 0, y in bit 1 and z in bit 2.
+constexpr int cell_edges[12][2] = {
+	{0, 1}, {2, 3}, {4, 5}, {6, 7},
+	{0, 2}, {1, 3}, {4, 6}, {5, 7},
+	{0, 4}, {1, 5}, {2, 6}, {3, 7}
+};
+
+// Per-thread positions and estimates of the samples of a row that are evaluated
+struct RowScratch {
+	std::vector<int> columns;
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	std::vector<float> dist;
+};
+
+// Runs function(i, scratch) for i in [0, count) on thread_count threads pulling from a shared counter.
+template <typename Function>
+void parallel_for(const unsigned int thread_count, const int count, Function function) {
+	std::atomic<int> next = 0;
+	auto worker = [&] {
+		RowScratch scratch;
+		for (int i = next++; i < count; i = next++) {
+			function(i, scratch);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 1; i < std::min(thread_count, static_cast<unsigned int>(count)); i++) {
+		workers.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& thread : workers) {
+		thread.join();
+	}
+}
+
+// Appends a quad around a grid edge as two triangles. The cells are given counter-clockwise around
+// the edge's axis, which faces the quad along the axis; flip faces it the other way.
+void add_quad(std::vector<uint32_t>& triangles, const bool flip, const uint32_t a, const uint32_t b, const uint32_t c, const uint32_t d) {
+	if (flip) {
+		triangles.insert(triangles.end(), {a, d, c, a, c, b});
+	} else {
+		triangles.insert(triangles.end(), {a, b, c, a, c, d});
+	}
+}
+
+}
+
+MeshExtractor::MeshExtractor(const unsigned int thread_count)
+	: thread_count(thread_count != 0 ? thread_count : std::max(1u, std::thread::hardware_concurrency())) {
+
+}
+
+bool MeshExtractor::extract(const AppSettings& settings, const int resolution, const float extent, MeshStreamWriter& writer,
+	const std::function<void(int layers_done, int layer_count)>& progress) {
+	const auto start_time = std::chrono::steady_clock::now();
+	const int n = resolution;
+	const int samples = n + 1;
+	const float cell = 2.0f * extent / static_cast<float>(n);
+	const float iso = std::max(settings.epsilon, 0.5f * cell);
+	const FractalParams params = make_fractal_params(settings);
+	auto coordinate = [&](const int index) {
+		return static_cast<float>(index) * cell - extent;
+	};
+
+	// Estimates at the centers of the blocks of the layer of blocks that is being sampled
+	const int block_count = (n + block_size - 1) / block_size;
+	const float block_edge = static_cast<float>(block_size) * cell;
+	std::vector<float> block_dist(static_cast<size_t>(block_count) * block_count);
+	int block_layer = -1;
+
+	std::vector<float> slices[2];
+	std::vector<uint32_t> cell_layers[2];
+	for (int i = 0; i < 2; i++) {
+		slices[i].resize(static_cast<size_t>(samples) * samples);
+		cell_layers[i].assign(static_cast<size_t>(n) * n, no_vertex);
+	}
+	std::vector<std::vector<float>> row_vertices(n);
+	std::vector<std::vector<uint32_t>> row_triangles(samples);
+	std::vector<uint64_t> row_offsets(n);
+	std::atomic<uint64_t> evaluated_samples = 0;
+
+	// Fills slice with the estimates of sample layer z, less the iso value, so that the surface
+	// is where the values change sign.
+	auto sample_slice = [&](const int z, std::vector<float>& slice) {
+		const int block_z = std::min(z / block_size, block_count - 1);
+		if (block_z != block_layer) {
+			parallel_for(thread_count, block_count, [&](const int block_y, RowScratch& scratch) {
+				scratch.x.resize(block_count);
+				scratch.y.assign(block_count, (static_cast<float>(block_y) + 0.5f) * block_edge - extent);
+				scratch.z.assign(block_count, (static_cast<float>(block_z) + 0.5f) * block_edge - extent);
+				scratch.dist.resize(block_count);
+				for (int block_x = 0; block_x < block_count; block_x++) {
+					scratch.x[block_x] = (static_cast<float>(block_x) + 0.5f) * block_edge - extent;
+				}
+				fractal_batch(scratch.x.data(), scratch.y.data(), scratch.z.data(), block_count, params, scratch.dist.data());
+				for (int block_x = 0; block_x < block_count; block_x++) {
+					const float dist = scratch.dist[block_x];
+					block_dist[static_cast<size_t>(block_y) * block_count + block_x] = std::isfinite(dist) ? dist - iso : -iso;
+				}
+			});
+			block_layer = block_z;
+		}
+
+		parallel_for(thread_count, samples, [&](const int y, RowScratch& scratch) {
+			const glm::vec3 row_start(coordinate(0), coordinate(y), coordinate(z));
+			const int block_y = std::min(y / block_size, block_count - 1);
+			const float* row_block_dist = &block_dist[static_cast<size_t>(block_y) * block_count];
+			float* values = &slice[static_cast<size_t>(y) * samples];
+			scratch.columns.clear();
+			scratch.x.clear();
+			for (int x = 0; x < samples; x++) {
+				// The estimate at the block center, less the distance from it, bounds the distance
+				// of every sample in the block. A cell of margin keeps its neighbors outside too.
+				const int block_x = std::min(x / block_size, block_count - 1);
+				const glm::vec3 pos(row_start.x + static_cast<float>(x) * cell, row_start.y, row_start.z);
+				const glm::vec3 center = (glm::vec3(block_x, block_y, block_z) + 0.5f) * block_edge - extent;
+				const float bound = row_block_dist[block_x] - glm::length(pos - center);
+				if (bound > cell) {
+					values[x] = bound;
+				} else {
+					scratch.columns.push_back(x);
+					scratch.x.push_back(pos.x);
+				}
+			}
+
+			const int count = static_cast<int>(scratch.columns.size());
+			scratch.y.assign(count, row_start.y);
+			scratch.z.assign(count, row_start.z);
+			scratch.dist.resize(count);
+			fractal_batch(scratch.x.data(), scratch.y.data(), scratch.z.data(), count, params, scratch.dist.data());
+			for (int i = 0; i < count; i++) {
+				// The origin and some interior points give undefined estimates
+				const float dist = scratch.dist[i];
+				values[scratch.columns[i]] = std::isfinite(dist) ? dist - iso : -iso;
+			}
+			evaluated_samples += count;
+		});
+	};
+
+	sample_slice(0, slices[0]);
+	for (int z = 0; z < n; z++) {
+		const std::vector<float>& lower = slices[z & 1];
+		std::vector<float>& upper = slices[(z + 1) & 1];
+		sample_slice(z + 1, upper);
+
+		// A vertex for every cell of layer z with corners on both sides of the surface
+		std::vector<uint32_t>& current = cell_layers[z & 1];
+		parallel_for(thread_count, n, [&](const int y, RowScratch&) {
+			std::vector<float>& vertices = row_vertices[y];
+			vertices.clear();
+			for (int x = 0; x < n; x++) {
+				float values[8];
+				int inside = 0;
+				for (int corner = 0; corner < 8; corner++) {
+					const std::vector<float>& slice = (corner & 4) ? upper : lower;
+					values[corner] = slice[static_cast<size_t>(y + ((corner >> 1) & 1)) * samples + x + (corner & 1)];
+					inside += values[corner] < 0.0f;
+				}
+				uint32_t& index = current[static_cast<size_t>(y) * n + x];
+				if (inside == 0 || inside == 8) {
+					index = no_vertex;
+					continue;
+				}
+
+				glm::vec3 sum(0.0f);
+				int crossings = 0;
+				for (const auto& edge : cell_edges) {
+					const float a = values[edge[0]];
+					const float b = values[edge[1]];
+					if ((a < 0.0f) == (b < 0.0f)) continue;
+					const glm::vec3 corner_a(edge[0] & 1, (edge[0] >> 1) & 1, (edge[0] >> 2) & 1);
+					const glm::vec3 corner_b(edge[1] & 1, (edge[1] >> 1) & 1, (edge[1] >> 2) & 1);
+					sum += corner_a + (corner_b - corner_a) * (a / (a - b));
+					crossings++;
+				}
+				const glm::vec3 vertex = glm::vec3(coordinate(x), coordinate(y), coordinate(z)) + sum / static_cast<float>(crossings) * cell;
+				index = static_cast<uint32_t>(vertices.size() / 3);
+				vertices.insert(vertices.end(), {vertex.x, vertex.y, vertex.z});
+			}
+		});
+
+		// Vertices are numbered in row order, after those of the previous layers
+		uint64_t offset = writer.get_vertex_count();
+		for (int y = 0; y < n; y++) {
+			row_offsets[y] = offset;
+			offset += row_vertices[y].size() / 3;
+		}
+		if (offset >= no_vertex) {
+			fprintf(stderr, "Error: the mesh has more vertices than 32-bit indices can address\n");
+			return false;
+		}
+		parallel_for(thread_count, n, [&](const int y, RowScratch&) {
+			uint32_t* indices = &current[static_cast<size_t>(y) * n];
+			for (int x = 0; x < n; x++) {
+				if (indices[x] != no_vertex) {
+					indices[x] += static_cast<uint32_t>(row_offsets[y]);
+				}
+			}
+		});
+		for (int y = 0; y < n; y++) {
+			if (!row_vertices[y].empty() && !writer.add_vertices(row_vertices[y].data(), row_vertices[y].size() / 3)) {
+				return false;
+			}
+		}
+
+		// A quad for every grid edge that crosses the surface and has four cells around it: the x
+		// and y edges of sample layer z, between cell layers z - 1 and z, and the z edges between
+		// sample layers z and z + 1. Each faces away from its inside end.
+		const std::vector<uint32_t>& previous = cell_layers[(z + 1) & 1];
+		parallel_for(thread_count, samples, [&](const int y, RowScratch&) {
+			std::vector<uint32_t>& triangles = row_triangles[y];
+			triangles.clear();
+			const size_t row = static_cast<size_t>(y) * samples;
+			const size_t cell_row = static_cast<size_t>(y) * n;
+			const size_t previous_cell_row = static_cast<size_t>(y - 1) * n;
+			for (int x = 0; x < samples; x++) {
+				const float value = lower[row + x];
+				if (z > 0 && y > 0 && y < n && x < n && (value < 0.0f) != (lower[row + x + 1] < 0.0f)) {
+					add_quad(triangles, value >= 0.0f, previous[previous_cell_row + x], previous[cell_row + x], current[cell_row + x], current[previous_cell_row + x]);
+				}
+				if (z > 0 && x > 0 && x < n && y < n && (value < 0.0f) != (lower[row + samples + x] < 0.0f)) {
+					add_quad(triangles, value >= 0.0f, previous[cell_row + x - 1], current[cell_row + x - 1], current[cell_row + x], previous[cell_row + x]);
+				}
+				if (x > 0 && x < n && y > 0 && y < n && (value < 0.0f) != (upper[row + x] < 0.0f)) {
+					add_quad(triangles, value >= 0.0f, current[previous_cell_row + x - 1], current[previous_cell_row + x], current[cell_row + x], current[cell_row + x - 1]);
+				}
+			}
+		});
+		for (int y = 0; y < samples; y++) {
+			if (!row_triangles[y].empty() && !writer.add_triangles(row_triangles[y].data(), row_triangles[y].size() / 3)) {
+				return false;
+			}
+		}
+
+		if (progress) {
+			progress(z + 1, n);
+		}
+	}
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+	last_stats.resolution = n;
+	last_stats.thread_count = thread_count;
+	last_stats.seconds = elapsed.count();
+	last_stats.vertex_count = writer.get_vertex_count();
+	last_stats.triangle_count = writer.get_triangle_count();
+	last_stats.evaluated_samples = evaluated_samples;
+	last_stats.sample_count = static_cast<uint64_t>(samples) * samples * samples;
+	return true;
+}
+
+const MeshStats& MeshExtractor::stats() const {
+	return last_stats;
+}
+
+unsigned int MeshExtractor::get_thread_count() const {
+	return thread_count;
+}
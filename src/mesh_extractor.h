@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "app_settings.h"
+#include "mesh_writer.h"
+
+constexpr int default_mesh_resolution = 512;
+constexpr float default_mesh_extent = 1.5f;
+
+struct MeshStats {
+	int resolution = 0;
+	unsigned int thread_count = 0;
+	double seconds = 0.0;
+	uint64_t vertex_count = 0;
+	uint64_t triangle_count = 0;
+	// Grid samples whose distance estimate was evaluated, out of (resolution + 1)^3. The others
+	// are known to be outside from the estimate at the center of their block.
+	uint64_t evaluated_samples = 0;
+	uint64_t sample_count = 0;
+};
+
+// Extracts the surface of the fractal of an AppSettings as a triangle mesh with surface nets, a
+// dual method: the distance estimator is sampled on a grid of cells over a cube around the origin,
+// every cell the surface passes through gets one vertex at the mean of the points where the
+// surface crosses its edges, and every grid edge the surface crosses gets a quad between the
+// vertices of its four cells. The grid is processed a layer of cells at a time, and each layer's
+// vertices and triangles are streamed to a MeshStreamWriter, so memory grows with the area of a
+// layer rather than with the grid. Vertices are shared across layers by keeping the vertex indices
+// of the previous layer. Samples are evaluated in batches on worker threads, row by row, and blocks
+// of the grid that the distance estimate at their center proves empty are not sampled at all.
+class MeshExtractor {
+public:
+	// Cells along each edge of the blocks that are skipped when empty
+	static constexpr int block_size = 16;
+
+	explicit MeshExtractor(unsigned int thread_count = 0);
+
+	// Meshes a grid of resolution^3 cells over the cube from -extent to extent. The surface is where
+	// the distance estimate equals the ray marching epsilon, or half a cell if that is larger, so
+	// that details thinner than a cell are kept. progress, if set, is called after each layer with
+	// the number of layers done.
+	bool extract(const AppSettings& settings, int resolution, float extent, MeshStreamWriter& writer,
+		const std::function<void(int layers_done, int layer_count)>& progress = {});
+
+	[[nodiscard]] const MeshStats& stats() const;
+	[[nodiscard]] unsigned int get_thread_count() const;
+
+private:
+	unsigned int thread_count;
+	MeshStats last_stats;
+};
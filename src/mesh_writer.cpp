@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+
+#include "mesh_writer.h"
+
+// Digits reserved for each PLY element count, which parsers read with leading zeros
+static constexpr int ply_count_digits = 10;
+// Bytes of a PLY face: the index count, then three 32-bit indices
+static constexpr size_t ply_face_size = 1 + 3 * sizeof(uint32_t);
+static constexpr size_t copy_chunk_size = 1 << 20;
+
+MeshFormat mesh_format_for_path(const std::string& path) {
+	if (path.size() < 4) {
+		return MeshFormat::ply;
+	}
+	std::string extension = path.substr(path.size() - 4);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](const unsigned char c) {
+		return static_cast<char>(std::tolower(c));
+	});
+	return extension == ".obj" ? MeshFormat::obj : MeshFormat::ply;
+}
+
+static std::string padded_count(const uint64_t count) {
+	char digits[ply_count_digits + 1];
+	snprintf(digits, sizeof(digits), "%0*llu", ply_count_digits, static_cast<unsigned long long>(count));
+	return digits;
+}
+
+MeshStreamWriter::~MeshStreamWriter() {
+	if (is_open()) {
+		close();
+	}
+}
+
+bool MeshStreamWriter::open(const std::string& path) {
+	this->path = path;
+	format = mesh_format_for_path(path);
+	vertex_count = 0;
+	triangle_count = 0;
+
+	file.open(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		fprintf(stderr, "Error opening mesh file: %s\n", path.c_str());
+		return false;
+	}
+
+	if (format == MeshFormat::obj) {
+		file << "# cloven\n";
+		return check_stream();
+	}
+
+	face_path = path + ".faces.tmp";
+	face_file.open(face_path, std::ios::binary | std::ios::trunc | std::ios::in | std::ios::out);
+	if (!face_file) {
+		fprintf(stderr, "Error opening temporary file: %s\n", face_path.c_str());
+		file.close();
+		return false;
+	}
+
+	// PLY stores binary data in the byte order given here, which is that of every supported CPU.
+	file << "ply\nformat binary_little_endian 1.0\ncomment cloven\nelement vertex ";
+	vertex_count_offset = file.tellp();
+	file << padded_count(0) << "\nproperty float x\nproperty float y\nproperty float z\nelement face ";
+	face_count_offset = file.tellp();
+	file << padded_count(0) << "\nproperty list uchar uint vertex_indices\nend_header\n";
+	return check_stream();
+}
+
+bool MeshStreamWriter::add_vertices(const float* positions, const size_t count) {
+	if (!is_open()) {
+		return false;
+	}
+	if (format == MeshFormat::ply) {
+		file.write(reinterpret_cast<const char*>(positions), static_cast<std::streamsize>(count * 3 * sizeof(float)));
+	} else {
+		// Shortest representations that read back as the same floats
+		buffer.clear();
+		char line[96];
+		for (size_t i = 0; i < count; i++) {
+			char* end = line;
+			*end++ = 'v';
+			for (int axis = 0; axis < 3; axis++) {
+				*end++ = ' ';
+				end = std::to_chars(end, line + sizeof(line), positions[i * 3 + axis]).ptr;
+			}
+			*end++ = '\n';
+			buffer.insert(buffer.end(), line, end);
+		}
+		file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+	}
+	vertex_count += count;
+	return check_stream();
+}
+
+bool MeshStreamWriter::add_triangles(const uint32_t* indices, const size_t count) {
+	if (!is_open()) {
+		return false;
+	}
+	buffer.clear();
+	if (format == MeshFormat::ply) {
+		buffer.resize(count * ply_face_size);
+		for (size_t i = 0; i < count; i++) {
+			char* face = &buffer[i * ply_face_size];
+			face[0] = 3;
+			std::copy_n(reinterpret_cast<const char*>(&indices[i * 3]), 3 * sizeof(uint32_t), face + 1);
+		}
+		face_file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		if (!face_file) {
+			fprintf(stderr, "Error writing temporary file: %s\n", face_path.c_str());
+			return false;
+		}
+	} else {
+		// OBJ indices start at 1
+		char line[48];
+		for (size_t i = 0; i < count; i++) {
+			char* end = line;
+			*end++ = 'f';
+			for (int corner = 0; corner < 3; corner++) {
+				*end++ = ' ';
+				end = std::to_chars(end, line + sizeof(line), static_cast<uint64_t>(indices[i * 3 + corner]) + 1).ptr;
+			}
+			*end++ = '\n';
+			buffer.insert(buffer.end(), line, end);
+		}
+		file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+	}
+	triangle_count += count;
+	return check_stream();
+}
+
+bool MeshStreamWriter::close() {
+	if (!is_open()) {
+		return false;
+	}
+	bool complete = check_stream();
+
+	if (format == MeshFormat::ply) {
+		face_file.flush();
+		face_file.seekg(0);
+		buffer.resize(copy_chunk_size);
+		while (complete && face_file) {
+			face_file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+			file.write(buffer.data(), face_file.gcount());
+			complete &= check_stream();
+		}
+		face_file.close();
+		std::remove(face_path.c_str());
+
+		file.seekp(vertex_count_offset);
+		file << padded_count(vertex_count);
+		file.seekp(face_count_offset);
+		file << padded_count(triangle_count);
+		complete &= check_stream();
+	}
+
+	file.close();
+	return complete;
+}
+
+bool MeshStreamWriter::is_open() const {
+	return file.is_open();
+}
+
+uint64_t MeshStreamWriter::get_vertex_count() const {
+	return vertex_count;
+}
+
+uint64_t MeshStreamWriter::get_triangle_count() const {
+	return triangle_count;
+}
+
+bool MeshStreamWriter::check_stream() {
+	if (!file) {
+		fprintf(stderr, "Error writing mesh file: %s\n", path.c_str());
+		return false;
+	}
+	return true;
+}
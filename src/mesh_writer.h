@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+enum class MeshFormat {
+	ply,
+	obj
+};
+
+// OBJ for paths ending in .obj (any case), binary PLY otherwise.
+[[nodiscard]] MeshFormat mesh_format_for_path(const std::string& path);
+
+// Writes an indexed triangle mesh as it is produced, so a mesh of any size needs only the batch in
+// flight in memory. Triangles refer to vertices by the order they were added in, starting at 0,
+// and may only refer to vertices added before them. OBJ interleaves vertices and faces as they
+// arrive. Binary PLY needs every vertex before the first face, so faces are spilled to a temporary
+// file next to the output and appended by close(), which also fills in the element counts that the
+// header reserves fixed-width space for.
+class MeshStreamWriter {
+public:
+	MeshStreamWriter() = default;
+	~MeshStreamWriter();
+
+	MeshStreamWriter(const MeshStreamWriter&) = delete;
+	MeshStreamWriter& operator=(const MeshStreamWriter&) = delete;
+
+	bool open(const std::string& path);
+	// Adds count vertices given as consecutive x, y, z coordinates.
+	bool add_vertices(const float* positions, size_t count);
+	// Adds count triangles given as consecutive triples of vertex indices, counter-clockwise when
+	// seen from outside.
+	bool add_triangles(const uint32_t* indices, size_t count);
+	bool close();
+
+	[[nodiscard]] bool is_open() const;
+	[[nodiscard]] uint64_t get_vertex_count() const;
+	[[nodiscard]] uint64_t get_triangle_count() const;
+
+private:
+	std::ofstream file;
+	std::fstream face_file;
+	std::string path;
+	std::string face_path;
+	MeshFormat format = MeshFormat::ply;
+	uint64_t vertex_count = 0;
+	uint64_t triangle_count = 0;
+	// Offsets of the PLY header's vertex and face counts
+	std::streamoff vertex_count_offset = 0;
+	std::streamoff face_count_offset = 0;
+	std::vector<char> buffer;
+
+	bool check_stream();
+};
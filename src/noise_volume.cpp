@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#include "noise_volume.h"
+#include "simplex_noise.h"
+
+float periodic_surface_noise(const glm::vec3 p) {
+	const float coarse = periodic_snoise(p, noise_volume_lattice_period);
+	const float fine = periodic_snoise(p * static_cast<float>(noise_volume_octave_ratio), noise_volume_lattice_period * noise_volume_octave_ratio);
+	return glm::mix(coarse, fine, noise_volume_fine_weight);
+}
+
+bool bake_noise_volume(const int resolution, unsigned int thread_count, const std::atomic<bool>& cancel, NoiseVolume& volume) {
+	const auto start_time = std::chrono::steady_clock::now();
+	if (thread_count == 0) {
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	volume.resolution = std::max(resolution, 1);
+	const int size = volume.resolution;
+	volume.samples.resize(static_cast<size_t>(size) * size * size);
+	const float texel_size = noise_volume_period / static_cast<float>(size);
+
+	// A slice at a time from a shared counter
+	std::atomic<int> next = 0;
+	auto worker = [&] {
+		for (int z = next++; z < size && !cancel; z = next++) {
+			float* slice = volume.samples.data() + static_cast<size_t>(z) * size * size;
+			for (int y = 0; y < size; y++) {
+				for (int x = 0; x < size; x++) {
+					const glm::vec3 p = (glm::vec3(x, y, z) + 0.5f) * texel_size;
+					slice[y * size + x] = periodic_surface_noise(p);
+				}
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 1; i < thread_count; i++) {
+		workers.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& thread : workers) {
+		thread.join();
+	}
+	if (cancel) {
+		return false;
+	}
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+	volume.bake_time = elapsed.count();
+	return true;
+}
+
+NoiseVolumeBaker::NoiseVolumeBaker() {
+	// Started once every member it uses is constructed
+	thread = std::thread(&NoiseVolumeBaker::work, this);
+}
+
+NoiseVolumeBaker::~NoiseVolumeBaker() {
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+		cancel = true;
+	}
+	requested.notify_one();
+	thread.join();
+}
+
+void NoiseVolumeBaker::request(const int resolution) {
+	{
+		std::lock_guard lock(mutex);
+		if (resolution == request_resolution) {
+			return;
+		}
+		request_resolution = resolution;
+		has_request = true;
+		baking = true;
+		result.reset();
+		cancel = true;
+	}
+	requested.notify_one();
+}
+
+std::unique_ptr<NoiseVolume> NoiseVolumeBaker::take_result() {
+	std::lock_guard lock(mutex);
+	return std::move(result);
+}
+
+std::unique_ptr<NoiseVolume> NoiseVolumeBaker::wait_result() {
+	std::unique_lock lock(mutex);
+	bake_finished.wait(lock, [this] { return !baking; });
+	return std::move(result);
+}
+
+bool NoiseVolumeBaker::is_baking() const {
+	std::lock_guard lock(mutex);
+	return baking;
+}
+
+void NoiseVolumeBaker::work() {
+	std::unique_lock lock(mutex);
+	while (true) {
+		requested.wait(lock, [this] { return stopping || has_request; });
+		if (stopping) {
+			return;
+		}
+		const int resolution = request_resolution;
+		has_request = false;
+		cancel = false;
+		lock.unlock();
+
+		auto volume = std::make_unique<NoiseVolume>();
+		const bool finished = bake_noise_volume(resolution, 0, cancel, *volume);
+
+		lock.lock();
+		// A newer request cancels the bake, or finished it just too late
+		if (finished && !has_request) {
+			result = std::move(volume);
+			baking = false;
+			bake_finished.notify_all();
+		}
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// The noise volume holds the surface noise of shade() in shaders/shader.frag over one period of
+// noise space, where p = 2 * noise_scale * position. The constants below must match their
+// counterparts there.
+// Simplex lattice cells per period of the coarse octave, whose noise repeats every three times as
+// many units of noise space. The fine octave wraps every noise_volume_octave_ratio times as many
+// cells, so both repeat with the volume.
+constexpr int noise_volume_lattice_period = 2;
+constexpr float noise_volume_period = 3.0f * noise_volume_lattice_period;
+// Frequency of the fine octave relative to the coarse one, and its weight in the mix
+constexpr int noise_volume_octave_ratio = 4;
+constexpr float noise_volume_fine_weight = 0.1f;
+// Texels along each edge of the volume that can be selected
+constexpr int noise_volume_resolutions[] = {64, 128, 256};
+
+// One period of the two octaves of surface noise sampled at texel centers, so that it tiles.
+struct NoiseVolume {
+	// Texels along each edge
+	int resolution = 0;
+	// resolution^3 samples, x fastest
+	std::vector<float> samples;
+	double bake_time = 0.0; // seconds
+};
+
+// The noise that the volume samples at p in noise space
+[[nodiscard]] float periodic_surface_noise(glm::vec3 p);
+
+// Samples the volume on thread_count threads, or one per core if it is 0. Returns false, leaving
+// volume incomplete, as soon as cancel is set.
+bool bake_noise_volume(int resolution, unsigned int thread_count, const std::atomic<bool>& cancel, NoiseVolume& volume);
+
+// Bakes noise volumes on a background thread. A request for another resolution abandons the bake
+// in progress, so only the volume of the latest request is ever finished.
+class NoiseVolumeBaker {
+public:
+	NoiseVolumeBaker();
+	~NoiseVolumeBaker();
+
+	NoiseVolumeBaker(const NoiseVolumeBaker&) = delete;
+	NoiseVolumeBaker& operator=(const NoiseVolumeBaker&) = delete;
+
+	// Starts a bake unless resolution is that of the last request.
+	void request(int resolution);
+	// Returns the volume of the last request once it is finished, and null until then or after it
+	// was taken.
+	[[nodiscard]] std::unique_ptr<NoiseVolume> take_result();
+	// Blocks until the bake of the last request is finished, then returns its volume as
+	// take_result() does.
+	[[nodiscard]] std::unique_ptr<NoiseVolume> wait_result();
+	[[nodiscard]] bool is_baking() const;
+
+private:
+	std::thread thread;
+	mutable std::mutex mutex;
+	std::condition_variable requested;
+	std::condition_variable bake_finished;
+	int request_resolution = 0;
+	bool has_request = false;
+	bool baking = false;
+	bool stopping = false;
+	std::atomic<bool> cancel = false;
+	std::unique_ptr<NoiseVolume> result;
+
+	void work();
+};
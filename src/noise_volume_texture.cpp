@@ -0,0 +1,52 @@
+#include "noise_volume_texture.h"
+
+NoiseVolumeTexture::NoiseVolumeTexture() {
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_3D, texture);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+NoiseVolumeTexture::~NoiseVolumeTexture() {
+	glDeleteTextures(1, &texture);
+}
+
+void NoiseVolumeTexture::upload(const NoiseVolume& volume) {
+	const int resolution = volume.resolution;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_3D, texture);
+	// Half floats resolve the noise far below what an 8-bit color shows
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_R16F, resolution, resolution, resolution, 0, GL_RED, GL_FLOAT, volume.samples.data());
+	glBindTexture(GL_TEXTURE_3D, 0);
+
+	uploaded = true;
+	uploaded_resolution = resolution;
+	bake_time = volume.bake_time;
+	size = static_cast<size_t>(resolution) * resolution * resolution * sizeof(GLhalf);
+}
+
+void NoiseVolumeTexture::bind(const GLuint unit) const {
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_3D, texture);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+bool NoiseVolumeTexture::has_volume() const {
+	return uploaded;
+}
+
+int NoiseVolumeTexture::get_resolution() const {
+	return uploaded_resolution;
+}
+
+double NoiseVolumeTexture::get_bake_time() const {
+	return bake_time;
+}
+
+size_t NoiseVolumeTexture::get_size() const {
+	return size;
+}
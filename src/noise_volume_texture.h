@@ -0,0 +1,33 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include "noise_volume.h"
+
+// A NoiseVolume as an R16F 3D texture for shaders/shader.frag, filtered linearly and repeated so
+// that lookups anywhere in noise space wrap into the baked period. Requires a current OpenGL
+// context.
+class NoiseVolumeTexture {
+public:
+	NoiseVolumeTexture();
+	~NoiseVolumeTexture();
+
+	NoiseVolumeTexture(const NoiseVolumeTexture&) = delete;
+	NoiseVolumeTexture& operator=(const NoiseVolumeTexture&) = delete;
+
+	void upload(const NoiseVolume& volume);
+	void bind(GLuint unit) const;
+
+	[[nodiscard]] bool has_volume() const;
+	[[nodiscard]] int get_resolution() const;
+	[[nodiscard]] double get_bake_time() const;
+	// Texture memory in bytes
+	[[nodiscard]] size_t get_size() const;
+
+private:
+	GLuint texture = 0;
+	bool uploaded = false;
+	int uploaded_resolution = 0;
+	double bake_time = 0.0;
+	size_t size = 0;
+};
@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#include "profiler.h"
+
+static constexpr const char* phase_names[] = {
+	"Input",
+	"Uniform Upload",
+	"Gradient Upload",
+	"Geometry Pass",
+	"Shading Pass",
+	"Anti-Aliasing",
+	"Blit",
+	"GUI Build",
+	"GUI Render",
+	"Swap"
+};
+static_assert(std::size(phase_names) == profile_phase_count);
+
+// GPU time drifts against the CPU clock, so the offset between them is measured again this often.
+static constexpr std::chrono::seconds calibration_interval(1);
+
+const char* profile_phase_name(const ProfilePhase phase) {
+	return phase_names[static_cast<int>(phase)];
+}
+
+bool is_gpu_phase(const ProfilePhase phase) {
+	return phase == ProfilePhase::geometry_pass || phase == ProfilePhase::shading_pass || phase == ProfilePhase::anti_aliasing
+		|| phase == ProfilePhase::blit || phase == ProfilePhase::gui_render;
+}
+
+Profiler::Profiler() : epoch(std::chrono::steady_clock::now()) {
+	for (QuerySlot& slot : slots) {
+		glGenQueries(profile_phase_count * 2, slot.queries);
+	}
+	history.reserve(history_size);
+	calibrate();
+}
+
+Profiler::~Profiler() {
+	for (QuerySlot& slot : slots) {
+		glDeleteQueries(profile_phase_count * 2, slot.queries);
+	}
+}
+
+void Profiler::begin_frame() {
+	collect_results();
+	if (std::chrono::steady_clock::now() - last_calibration >= calibration_interval) {
+		calibrate();
+	}
+
+	ProfileFrame frame;
+	frame.frame = frame_count++;
+	frame.start = now();
+	for (double& duration : frame.phase_duration) {
+		duration = -1.0;
+	}
+	if (static_cast<int>(history.size()) == history_size) {
+		history.erase(history.begin());
+	}
+	history.push_back(frame);
+
+	active_slot = slots[next_slot].pending ? -1 : next_slot;
+	if (active_slot >= 0) {
+		QuerySlot& slot = slots[active_slot];
+		slot.frame = frame.frame;
+		for (bool& issued : slot.issued) {
+			issued = false;
+		}
+	}
+	in_frame = true;
+}
+
+void Profiler::end_frame() {
+	if (!in_frame) return;
+	in_frame = false;
+
+	if (active_slot >= 0) {
+		QuerySlot& slot = slots[active_slot];
+		for (const bool issued : slot.issued) {
+			slot.pending |= issued;
+		}
+		if (slot.pending) {
+			next_slot = (next_slot + 1) % query_slot_count;
+		}
+		active_slot = -1;
+	}
+}
+
+void Profiler::begin(const ProfilePhase phase) {
+	if (!in_frame) return;
+	const int index = static_cast<int>(phase);
+	if (is_gpu_phase(phase)) {
+		if (active_slot >= 0) {
+			glQueryCounter(slots[active_slot].queries[index * 2], GL_TIMESTAMP);
+		}
+	} else {
+		phase_begin_time[index] = std::chrono::steady_clock::now();
+	}
+}
+
+void Profiler::end(const ProfilePhase phase) {
+	if (!in_frame) return;
+	const int index = static_cast<int>(phase);
+	if (is_gpu_phase(phase)) {
+		if (active_slot >= 0) {
+			glQueryCounter(slots[active_slot].queries[index * 2 + 1], GL_TIMESTAMP);
+			slots[active_slot].issued[index] = true;
+		}
+		return;
+	}
+
+	const auto end_time = std::chrono::steady_clock::now();
+	ProfileFrame& frame = history.back();
+	const std::chrono::duration<double, std::milli> start = phase_begin_time[index] - epoch;
+	const std::chrono::duration<double, std::milli> duration = end_time - phase_begin_time[index];
+	// A phase that runs more than once per frame is summed
+	frame.phase_start[index] = frame.phase_duration[index] < 0.0 ? start.count() : frame.phase_start[index];
+	frame.phase_duration[index] = std::max(frame.phase_duration[index], 0.0) + duration.count();
+}
+
+std::vector<ProfileFrame> Profiler::get_history() const {
+	return history;
+}
+
+double Profiler::get_average(const ProfilePhase phase) const {
+	const int index = static_cast<int>(phase);
+	double sum = 0.0;
+	int count = 0;
+	for (const ProfileFrame& frame : history) {
+		if (frame.phase_duration[index] >= 0.0) {
+			sum += frame.phase_duration[index];
+			count++;
+		}
+	}
+	return count > 0 ? sum / count : 0.0;
+}
+
+bool Profiler::export_csv(const std::string& path) const {
+	std::ofstream file(path);
+	if (!file) {
+		fprintf(stderr, "Error opening profile file: %s\n", path.c_str());
+		return false;
+	}
+	file << "frame,phase,clock,start_ms,duration_ms\n";
+	for (const ProfileFrame& frame : history) {
+		for (int i = 0; i < profile_phase_count; i++) {
+			if (frame.phase_duration[i] < 0.0) continue;
+			const auto phase = static_cast<ProfilePhase>(i);
+			file << frame.frame << "," << profile_phase_name(phase) << "," << (is_gpu_phase(phase) ? "gpu" : "cpu") << ","
+				<< frame.phase_start[i] << "," << frame.phase_duration[i] << "\n";
+		}
+	}
+	if (!file) {
+		fprintf(stderr, "Error writing profile file: %s\n", path.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool Profiler::export_trace(const std::string& path) const {
+	std::ofstream file(path);
+	if (!file) {
+		fprintf(stderr, "Error opening profile file: %s\n", path.c_str());
+		return false;
+	}
+
+	// Complete ("X") events with microsecond timestamps, CPU phases on thread 1 and GPU phases on 2
+	file << "{\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+	file.precision(3);
+	file << std::fixed;
+	for (const ProfileFrame& frame : history) {
+		for (int i = 0; i < profile_phase_count; i++) {
+			if (frame.phase_duration[i] < 0.0) continue;
+			const auto phase = static_cast<ProfilePhase>(i);
+			file << ",\n{\"name\":\"" << profile_phase_name(phase) << "\",\"cat\":\"" << (is_gpu_phase(phase) ? "gpu" : "cpu")
+				<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (is_gpu_phase(phase) ? 2 : 1)
+				<< ",\"ts\":" << frame.phase_start[i] * 1000.0 << ",\"dur\":" << frame.phase_duration[i] * 1000.0
+				<< ",\"args\":{\"frame\":" << frame.frame << "}}";
+		}
+	}
+	file << "\n]}\n";
+
+	if (!file) {
+		fprintf(stderr, "Error writing profile file: %s\n", path.c_str());
+		return false;
+	}
+	return true;
+}
+
+double Profiler::now() const {
+	const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - epoch;
+	return elapsed.count();
+}
+
+void Profiler::calibrate() {
+	glGetInteger64v(GL_TIMESTAMP, &calibration_gpu_time);
+	calibration_time = now();
+	last_calibration = std::chrono::steady_clock::now();
+}
+
+void Profiler::collect_results() {
+	// Slots complete in submission order, starting with the oldest at next_slot. Timestamps are
+	// written in order too, so the last query of a frame being available means all of them are.
+	for (int i = 0; i < query_slot_count; i++) {
+		QuerySlot& slot = slots[(next_slot + i) % query_slot_count];
+		if (!slot.pending) continue;
+
+		GLuint last_query = 0;
+		for (int phase = 0; phase < profile_phase_count; phase++) {
+			if (slot.issued[phase]) {
+				last_query = slot.queries[phase * 2 + 1];
+			}
+		}
+		GLint available = 0;
+		glGetQueryObjectiv(last_query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) break;
+
+		ProfileFrame* frame = find_frame(slot.frame);
+		for (int phase = 0; phase < profile_phase_count; phase++) {
+			if (!slot.issued[phase]) continue;
+			GLuint64 begin_time = 0;
+			GLuint64 end_time = 0;
+			glGetQueryObjectui64v(slot.queries[phase * 2], GL_QUERY_RESULT, &begin_time);
+			glGetQueryObjectui64v(slot.queries[phase * 2 + 1], GL_QUERY_RESULT, &end_time);
+			if (frame) {
+				frame->phase_start[phase] = calibration_time + static_cast<double>(static_cast<GLint64>(begin_time) - calibration_gpu_time) * 1e-6;
+				frame->phase_duration[phase] = static_cast<double>(end_time - begin_time) * 1e-6;
+			}
+		}
+		if (frame) {
+			frame->has_gpu_times = true;
+		}
+		slot.pending = false;
+	}
+}
+
+ProfileFrame* Profiler::find_frame(const unsigned long long frame) {
+	if (history.empty() || frame < history.front().frame) {
+		return nullptr;
+	}
+	const auto index = static_cast<size_t>(frame - history.front().frame);
+	return index < history.size() ? &history[index] : nullptr;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Phases of a frame. CPU phases are timed with the steady clock, GPU phases with timestamp queries.
+enum class ProfilePhase {
+	input,
+	uniform_upload,
+	gradient_upload,
+	geometry_pass,
+	shading_pass,
+	// Edge and resolve passes of adaptive anti-aliasing
+	anti_aliasing,
+	blit,
+	gui_build,
+	gui_render,
+	// Swapping buffers, which includes waiting for vsync, and polling events
+	swap,
+	count
+};
+
+constexpr int profile_phase_count = static_cast<int>(ProfilePhase::count);
+
+[[nodiscard]] const char* profile_phase_name(ProfilePhase phase);
+[[nodiscard]] bool is_gpu_phase(ProfilePhase phase);
+
+// Timings of one frame in milliseconds on the CPU clock since the profiler was created. GPU phases
+// are placed on the same timeline. A phase that did not run has a negative duration.
+struct ProfileFrame {
+	unsigned long long frame = 0;
+	double start = 0.0;
+	double phase_start[profile_phase_count] = {};
+	double phase_duration[profile_phase_count] = {};
+	bool has_gpu_times = false;
+};
+
+// Times the phases of every frame between begin_frame() and end_frame() and keeps the last
+// history_size frames. GPU phases are bracketed with glQueryCounter timestamps. Each frame's
+// queries take one slot of a small ring and are read once the last of them is available, so
+// profiling never stalls the pipeline. A frame whose slot is still pending only gets CPU times.
+// Requires a current OpenGL context.
+class Profiler {
+public:
+	static constexpr int history_size = 240;
+	static constexpr int query_slot_count = 4;
+
+	Profiler();
+	~Profiler();
+
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	void begin_frame();
+	void end_frame();
+	// Phases outside a frame are ignored, so offscreen rendering is not recorded.
+	void begin(ProfilePhase phase);
+	void end(ProfilePhase phase);
+
+	// Frames in order from oldest to newest. The newest frames may still lack their GPU times.
+	[[nodiscard]] std::vector<ProfileFrame> get_history() const;
+	// Mean duration of phase over the recorded frames in which it ran, in milliseconds
+	[[nodiscard]] double get_average(ProfilePhase phase) const;
+
+	// One row per frame and phase
+	bool export_csv(const std::string& path) const;
+	// Chrome trace event format, for chrome://tracing or Perfetto
+	bool export_trace(const std::string& path) const;
+
+private:
+	struct QuerySlot {
+		GLuint queries[profile_phase_count * 2] = {};
+		bool issued[profile_phase_count] = {};
+		unsigned long long frame = 0;
+		bool pending = false;
+	};
+
+	std::chrono::steady_clock::time_point epoch;
+	// GPU timestamp in nanoseconds at CPU time calibration_time (milliseconds since epoch)
+	GLint64 calibration_gpu_time = 0;
+	double calibration_time = 0.0;
+	std::chrono::steady_clock::time_point last_calibration;
+
+	QuerySlot slots[query_slot_count];
+	int next_slot = 0;
+	// Slot of the current frame, or -1 if it only gets CPU times
+	int active_slot = -1;
+	bool in_frame = false;
+	unsigned long long frame_count = 0;
+	std::chrono::steady_clock::time_point phase_begin_time[profile_phase_count];
+
+	std::vector<ProfileFrame> history;
+
+	[[nodiscard]] double now() const;
+	void calibrate();
+	void collect_results();
+	ProfileFrame* find_frame(unsigned long long frame);
+};
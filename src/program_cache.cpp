@@ -0,0 +1,112 @@
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include "program_cache.h"
+
+// File layout: magic, binary format, binary length, binary.
+static constexpr uint32_t cache_magic = 0x4E564C43; // "CLVN"
+
+// 64-bit FNV-1a.
+static uint64_t hash_string(const std::string& s) {
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (const char c : s) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 0x100000001B3ull;
+	}
+	return hash;
+}
+
+static std::string gl_string(const GLenum name) {
+	const auto value = reinterpret_cast<const char*>(glGetString(name));
+	return value ? value : "";
+}
+
+ProgramCache::ProgramCache(std::string directory) : directory(std::move(directory)) {
+	driver = gl_string(GL_VENDOR) + "\n" + gl_string(GL_RENDERER) + "\n" + gl_string(GL_VERSION);
+
+	GLint format_count = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+	supported = format_count > 0;
+}
+
+bool ProgramCache::is_supported() const {
+	return supported;
+}
+
+std::string ProgramCache::key(const std::string& source) const {
+	char buffer[33];
+	snprintf(buffer, sizeof(buffer), "%016llx%016llx",
+		static_cast<unsigned long long>(hash_string(source)),
+		static_cast<unsigned long long>(hash_string(driver)));
+	return buffer;
+}
+
+std::string ProgramCache::entry_path(const std::string& key) const {
+	return (std::filesystem::path(directory) / (key + ".bin")).string();
+}
+
+bool ProgramCache::load(const GLuint program, const std::string& key) const {
+	if (!supported) return false;
+
+	std::ifstream file(entry_path(key), std::ios::binary);
+	if (!file) return false;
+
+	uint32_t magic = 0;
+	uint32_t format = 0;
+	uint32_t length = 0;
+	file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+	file.read(reinterpret_cast<char*>(&format), sizeof(format));
+	file.read(reinterpret_cast<char*>(&length), sizeof(length));
+	if (!file || magic != cache_magic || length == 0) return false;
+
+	std::vector<char> binary(length);
+	file.read(binary.data(), length);
+	if (!file) return false;
+
+	glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(length));
+
+	GLint success = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	return success != 0;
+}
+
+void ProgramCache::store(const GLuint program, const std::string& key) const {
+	if (!supported) return;
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	if (error) {
+		fprintf(stderr, "Error creating shader cache directory %s: %s\n", directory.c_str(), error.message().c_str());
+		return;
+	}
+
+	// Write to a temporary file first so a crash never leaves a truncated entry behind.
+	const std::string path = entry_path(key);
+	const std::string temporary_path = path + ".tmp";
+	{
+		std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+		const uint32_t header[3] = {cache_magic, static_cast<uint32_t>(format), static_cast<uint32_t>(length)};
+		file.write(reinterpret_cast<const char*>(header), sizeof(header));
+		file.write(binary.data(), length);
+		if (!file) {
+			fprintf(stderr, "Error writing shader cache entry %s\n", temporary_path.c_str());
+			return;
+		}
+	}
+	std::filesystem::rename(temporary_path, path, error);
+	if (error) {
+		fprintf(stderr, "Error writing shader cache entry %s: %s\n", path.c_str(), error.message().c_str());
+	}
+}
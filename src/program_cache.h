@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+#include <GL/glew.h>
+
+// On-disk cache of linked program binaries (glGetProgramBinary). Entries are keyed by a hash of the
+// shader sources together with the driver's vendor, renderer and version strings, so a driver
+// update or a different GPU never loads a stale binary. Requires a current OpenGL context.
+class ProgramCache {
+public:
+	static constexpr auto default_directory = "shader_cache";
+
+	explicit ProgramCache(std::string directory = default_directory);
+
+	[[nodiscard]] bool is_supported() const;
+	[[nodiscard]] std::string key(const std::string& source) const;
+
+	// Loads the binary stored under key into program and returns whether it linked. Fails if there
+	// is no entry or the driver rejects it, in which case the program has to be compiled.
+	bool load(GLuint program, const std::string& key) const;
+	// Stores a linked program that was created with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+	void store(GLuint program, const std::string& key) const;
+
+private:
+	std::string directory;
+	std::string driver;
+	bool supported = false;
+
+	[[nodiscard]] std::string entry_path(const std::string& key) const;
+};
@@ -0,0 +1,44 @@
+#include "ray_stats.h"
+
+// Counter indices within a bucket, as in shader.frag
+enum RayStatsCounter {
+	counter_pixels,
+	counter_march_steps,
+	counter_shadow_steps,
+	counter_de_evaluations,
+	counter_misses,
+	counter_step_limit_hits
+};
+
+RayStatsBuffer::RayStatsBuffer() : ring(ray_stats_binding, bucket_count * counter_count), counters(static_cast<size_t>(bucket_count) * counter_count) {}
+
+void RayStatsBuffer::begin() {
+	collect_results();
+	ring.begin();
+}
+
+void RayStatsBuffer::end() {
+	ring.end();
+}
+
+const RayStats& RayStatsBuffer::get_stats() const {
+	return stats;
+}
+
+void RayStatsBuffer::collect_results() {
+	while (ring.read_next(counters.data()) >= 0) {
+		unsigned long long totals[counter_count] = {};
+		for (int bucket = 0; bucket < bucket_count; bucket++) {
+			for (int counter = 0; counter < counter_count; counter++) {
+				totals[counter] += counters[bucket * counter_count + counter];
+			}
+		}
+		stats.pixels = totals[counter_pixels];
+		stats.march_steps = totals[counter_march_steps];
+		stats.shadow_steps = totals[counter_shadow_steps];
+		stats.de_evaluations = totals[counter_de_evaluations];
+		stats.misses = totals[counter_misses];
+		stats.step_limit_hits = totals[counter_step_limit_hits];
+		stats.valid = true;
+	}
+}
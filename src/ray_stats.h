@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+
+#include "counter_buffer_ring.h"
+
+// Binding point of the RayStats storage buffer in shaders/shader.frag.
+constexpr unsigned int ray_stats_binding = 1;
+
+// Totals of one frame, counted by the shader when it is built with COLLECT_STATS.
+struct RayStats {
+	unsigned long long pixels = 0;
+	// Distance estimates of the primary march
+	unsigned long long march_steps = 0;
+	unsigned long long shadow_steps = 0;
+	// All distance estimates: marching, normals (an analytic normal counts once) and shadows
+	unsigned long long de_evaluations = 0;
+	// Rays that went past the max distance
+	unsigned long long misses = 0;
+	// Rays that stopped at the step limit without hitting or missing
+	unsigned long long step_limit_hits = 0;
+	// Whether any frame was counted yet
+	bool valid = false;
+};
+
+// Storage buffers the shader accumulates RayStats into, a CounterBufferRing. Requires a current
+// OpenGL context.
+class RayStatsBuffer {
+public:
+	// Must match stats_bucket_count and stats_counter_count in shader.frag
+	static constexpr int bucket_count = 64;
+	static constexpr int counter_count = 6;
+
+	RayStatsBuffer();
+
+	RayStatsBuffer(const RayStatsBuffer&) = delete;
+	RayStatsBuffer& operator=(const RayStatsBuffer&) = delete;
+
+	// Binds a cleared buffer to ray_stats_binding for the draws that follow.
+	void begin();
+	void end();
+	// Totals of the last frame whose counters have arrived
+	[[nodiscard]] const RayStats& get_stats() const;
+
+private:
+	CounterBufferRing ring;
+	RayStats stats;
+	std::vector<GLuint> counters;
+
+	void collect_results();
+};
@@ -0,0 +1,102 @@
+#include <cstdio>
+
+#include "readback_ring.h"
+
+ReadbackRing::ReadbackRing(const int buffer_count, const int max_width, const int max_height) : slots(buffer_count) {
+	// The readback format is RGBA, whose rows are always 4-byte aligned
+	const auto buffer_size = static_cast<GLsizeiptr>(max_width) * max_height * 4;
+	for (Slot& slot : slots) {
+		glGenBuffers(1, &slot.buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, buffer_size, nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+ReadbackRing::~ReadbackRing() {
+	for (Slot& slot : slots) {
+		if (slot.mapped) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		if (slot.fence) {
+			glDeleteSync(slot.fence);
+		}
+		glDeleteBuffers(1, &slot.buffer);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void ReadbackRing::read(const int width, const int height) {
+	Slot& slot = slots[(first + pending_count) % static_cast<int>(slots.size())];
+	slot.size = static_cast<GLsizeiptr>(width) * height * 4;
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	pending_count++;
+}
+
+const unsigned char* ReadbackRing::map_oldest(const bool wait) {
+	if (pending_count == 0) {
+		return nullptr;
+	}
+	Slot& slot = slots[first];
+	if (slot.fence) {
+		const GLuint64 timeout = wait ? GL_TIMEOUT_IGNORED : 0;
+		const GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+		if (status == GL_TIMEOUT_EXPIRED) {
+			return nullptr;
+		}
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+		if (status == GL_WAIT_FAILED) {
+			fprintf(stderr, "Error: waiting for a pixel readback failed\n");
+			failed = true;
+			return nullptr;
+		}
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size, GL_MAP_READ_BIT);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	if (!pixels) {
+		fprintf(stderr, "Error: mapping a pixel readback failed\n");
+		failed = true;
+		return nullptr;
+	}
+	slot.mapped = true;
+	return static_cast<const unsigned char*>(pixels);
+}
+
+void ReadbackRing::release_oldest() {
+	if (pending_count == 0) {
+		return;
+	}
+	Slot& slot = slots[first];
+	if (slot.mapped) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		slot.mapped = false;
+	}
+	if (slot.fence) {
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+	}
+	first = (first + 1) % static_cast<int>(slots.size());
+	pending_count--;
+}
+
+int ReadbackRing::get_pending_count() const {
+	return pending_count;
+}
+
+bool ReadbackRing::is_full() const {
+	return pending_count == static_cast<int>(slots.size());
+}
+
+bool ReadbackRing::has_failed() const {
+	return failed;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+// Ring of pixel buffer objects that glReadPixels copies into asynchronously. Every readback is
+// fenced and only mapped once its fence has signaled, so reading pixels back neither stalls the
+// GPU nor the calling thread unless it asks to wait. Readbacks complete in the order they were
+// started. Requires a current OpenGL context.
+class ReadbackRing {
+public:
+	ReadbackRing(int buffer_count, int max_width, int max_height);
+	~ReadbackRing();
+
+	ReadbackRing(const ReadbackRing&) = delete;
+	ReadbackRing& operator=(const ReadbackRing&) = delete;
+
+	// Starts copying width x height RGBA pixels from color attachment 0 of the bound read
+	// framebuffer. The ring must not be full.
+	void read(int width, int height);
+	// Maps the oldest readback if it finished, waiting for it if asked to. Returns its pixels as
+	// bottom-up RGBA rows, or nullptr if it is still in flight, the ring is empty or mapping failed.
+	[[nodiscard]] const unsigned char* map_oldest(bool wait);
+	// Unmaps the oldest readback and frees its buffer for the next read().
+	void release_oldest();
+
+	[[nodiscard]] int get_pending_count() const;
+	[[nodiscard]] bool is_full() const;
+	[[nodiscard]] bool has_failed() const;
+
+private:
+	struct Slot {
+		GLuint buffer = 0;
+		GLsync fence = nullptr;
+		GLsizeiptr size = 0;
+		bool mapped = false;
+	};
+
+	std::vector<Slot> slots;
+	int first = 0;
+	int pending_count = 0;
+	bool failed = false;
+};
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <cstring>
+
+#include "mandelbulb.h"
+#include "render_params.h"
+
+RenderParams make_render_params(const AppSettings& settings) {
+	RenderParams params;
+	std::memset(static_cast<void*>(&params), 0, sizeof(params));
+
+	params.background_color = glm::vec3(settings.background_color[0], settings.background_color[1], settings.background_color[2]);
+	params.max_distance = settings.max_distance;
+	params.light_pos = settings.light_pos;
+	params.light_power = settings.light_power;
+	params.bloom_color = glm::vec3(settings.bloom_color[0], settings.bloom_color[1], settings.bloom_color[2]);
+	params.light_radius = settings.light_radius;
+	params.light_color = glm::vec3(settings.light_color[0], settings.light_color[1], settings.light_color[2]);
+	params.power = settings.power;
+
+	params.max_iterations = settings.max_iterations;
+	params.escape_radius = settings.escape_radius;
+	params.step_limit = settings.step_limit;
+	params.epsilon = settings.epsilon;
+	params.ray_hit_threshold = settings.ray_hit_threshold;
+	params.noise_scale = settings.noise_scale;
+	params.noise_amplitude = settings.noise_amplitude;
+	params.ambient_strength = settings.ambient_strength;
+	params.diffuse_strength = settings.diffuse_strength;
+	params.specular_strength = settings.specular_strength;
+	params.specular_shininess = settings.specular_shininess;
+	params.shadow_softness = settings.shadow_softness;
+	params.shadow_min_distance = settings.shadow_min_distance;
+	params.shadow_min_step_size = settings.shadow_min_step_size;
+	params.shadow_max_step_size = settings.shadow_max_step_size;
+	params.shadow_max_iterations = settings.shadow_max_iterations;
+	params.bloom_intensity_factor = settings.bloom_intensity_factor;
+
+	params.integer_power = integer_power(settings.power);
+	params.coloring_method = settings.coloring_method;
+	params.background_type = settings.background_type;
+	params.enable_normal_visualization = settings.enable_normal_visualization;
+	params.show_light = settings.show_light;
+	params.apply_noise = settings.apply_noise;
+	params.apply_blinn_phong = settings.apply_blinn_phong;
+	params.apply_soft_shadow = settings.apply_soft_shadow;
+	params.apply_bloom = settings.apply_bloom;
+	params.apply_ambient_occlusion = settings.apply_ambient_occlusion;
+	params.normal_method = settings.normal_method;
+	params.enable_step_heatmap = settings.enable_step_heatmap;
+	params.heatmap_max_steps = std::max(settings.heatmap_max_steps, 1);
+	params.precise_iterations = std::max(settings.precise_iterations, 0);
+	params.mandelbox_folding_limit = settings.mandelbox_folding_limit;
+
+	params.julia_c = glm::vec4(settings.julia_c[0], settings.julia_c[1], settings.julia_c[2], settings.julia_c[3]);
+	params.mandelbox_scale = settings.mandelbox_scale;
+	params.mandelbox_min_radius = settings.mandelbox_min_radius;
+	params.mandelbox_fixed_radius = settings.mandelbox_fixed_radius;
+	return params;
+}
+
+bool geometry_changed(const RenderParams& params, const RenderParams& last) {
+	return params.power != last.power
+		|| params.integer_power != last.integer_power
+		|| params.max_iterations != last.max_iterations
+		|| params.escape_radius != last.escape_radius
+		|| params.step_limit != last.step_limit
+		|| params.epsilon != last.epsilon
+		|| params.max_distance != last.max_distance
+		|| params.background_type != last.background_type
+		|| params.normal_method != last.normal_method
+		|| params.precise_iterations != last.precise_iterations
+		|| params.mandelbox_folding_limit != last.mandelbox_folding_limit
+		|| params.julia_c != last.julia_c
+		|| params.mandelbox_scale != last.mandelbox_scale
+		|| params.mandelbox_min_radius != last.mandelbox_min_radius
+		|| params.mandelbox_fixed_radius != last.mandelbox_fixed_radius;
+}
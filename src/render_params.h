@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "app_settings.h"
+
+// Binding point of the RenderParams uniform block in shaders/shader.frag.
+constexpr unsigned int render_params_binding = 0;
+
+// std140 mirror of the RenderParams uniform block. Every vec3 starts on a 16-byte boundary and is
+// followed by a scalar, and the vec4 follows a multiple of 16 bytes, so the C++ layout needs no
+// explicit padding. GLSL bools are 4 bytes.
+struct alignas(16) RenderParams {
+	glm::vec3 background_color;
+	float max_distance;
+	glm::vec3 light_pos;
+	float light_power;
+	glm::vec3 bloom_color;
+	float light_radius;
+	glm::vec3 light_color;
+	float power;
+
+	int max_iterations;
+	int escape_radius;
+	int step_limit;
+	float epsilon;
+	float ray_hit_threshold;
+	float noise_scale;
+	float noise_amplitude;
+	float ambient_strength;
+	float diffuse_strength;
+	float specular_strength;
+	float specular_shininess;
+	float shadow_softness;
+	float shadow_min_distance;
+	float shadow_min_step_size;
+	float shadow_max_step_size;
+	int shadow_max_iterations;
+	float bloom_intensity_factor;
+
+	int integer_power;
+	int coloring_method;
+	int background_type;
+	int enable_normal_visualization;
+	int show_light;
+	int apply_noise;
+	int apply_blinn_phong;
+	int apply_soft_shadow;
+	int apply_bloom;
+	int apply_ambient_occlusion;
+	int normal_method;
+	int enable_step_heatmap;
+	int heatmap_max_steps;
+	int precise_iterations;
+	float mandelbox_folding_limit;
+
+	glm::vec4 julia_c;
+	float mandelbox_scale;
+	float mandelbox_min_radius;
+	float mandelbox_fixed_radius;
+};
+
+static_assert(offsetof(RenderParams, light_pos) == 16);
+static_assert(offsetof(RenderParams, bloom_color) == 32);
+static_assert(offsetof(RenderParams, light_color) == 48);
+static_assert(offsetof(RenderParams, max_iterations) == 64);
+static_assert(offsetof(RenderParams, integer_power) == 132);
+static_assert(offsetof(RenderParams, normal_method) == 172);
+static_assert(offsetof(RenderParams, heatmap_max_steps) == 180);
+static_assert(offsetof(RenderParams, precise_iterations) == 184);
+static_assert(offsetof(RenderParams, julia_c) == 192);
+static_assert(offsetof(RenderParams, mandelbox_fixed_radius) == 216);
+static_assert(sizeof(RenderParams) == 224);
+
+// Fills every member, including padding, so two results for equal settings compare equal with memcmp.
+[[nodiscard]] RenderParams make_render_params(const AppSettings& settings);
+// Whether params differ from last in a member that changes where the rays hit, which needs the
+// geometry pass to run again rather than only the shading pass.
+[[nodiscard]] bool geometry_changed(const RenderParams& params, const RenderParams& last);
@@ -0,0 +1,612 @@
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "formula.h"
+#include "mandelbulb.h"
+#include "render_params.h"
+#include "renderer.h"
+
+static constexpr const char* gbuffer_uniform_names[] = {"u_gbuffer_position", "u_gbuffer_normal", "u_gbuffer_miss"};
+
+// G-buffer attachments, see the outputs of the geometry pass in shader.frag
+static constexpr GLenum gbuffer_formats[] = {GL_RGBA32F, GL_RGBA32F, GL_R8};
+
+// Passes of the compute geometry pass, see COMPUTE_PASS in shaders/march.comp
+enum ComputePass {
+	compute_pass_tiles = 1,
+	compute_pass_rays
+};
+// Size of the tiles of the compute geometry pass and of its work groups, as in march.comp
+static constexpr int compute_tile_size = 8;
+// Binding point of the ComputeMarch storage buffer in march.comp
+static constexpr GLuint compute_march_binding = 3;
+// Bytes of the ComputeMarch buffer before the tile cones, whose vec4 array std430 aligns to 16
+static constexpr GLsizeiptr compute_march_header_size = 16;
+// Work groups of persistent threads of the ray pass. Enough to fill the cores of large GPUs,
+// which keep taking rays until all are done.
+static constexpr int compute_persistent_groups = 1024;
+
+// Tag of the GPU timer queries of frames that ran both passes
+static constexpr int full_frame_tag = 1;
+// Units in the last place of the camera position per pixel at the surface below which auto mode
+// marches in df64. Float positions start to show as blocks and noise at a few.
+static constexpr float auto_precision_ulps = 16.0f;
+
+// Angle between the rays of neighboring rows of height pixels. projection_matrix[1][1] is the
+// cotangent of half the vertical field of view, so tiles of an export get that of their own pixels.
+static float pixel_angle(const glm::mat4& projection_matrix, const int height) {
+	return 2.0f / (projection_matrix[1][1] * static_cast<float>(height));
+}
+
+// Precision of the geometry pass. Pixels near the camera cover about its distance to the surface
+// times the pixel angle, and auto mode compares that with the spacing of floats at its position.
+static int select_precision(const AppSettings& settings, const Camera& camera, const float pixel_angle) {
+	if (settings.precision_mode != precision_auto) {
+		return settings.precision_mode;
+	}
+	const float dist = fractal_distance(camera.position, make_fractal_params(settings));
+	const float largest = std::max({std::fabs(camera.position.x), std::fabs(camera.position.y), std::fabs(camera.position.z),
+		std::numeric_limits<float>::min()});
+	const float ulp = std::nextafter(largest, std::numeric_limits<float>::infinity()) - largest;
+	return std::isfinite(dist) && dist * pixel_angle < auto_precision_ulps * ulp ? precision_df64 : precision_fp32;
+}
+
+// Feature switches compiled into the fragment shader (see shader.frag). Without specialization,
+// the generic variant reads them from uniforms instead. The geometry pass only depends on the
+// switches that change the march, so shading switches never build a new geometry variant.
+// FORMULA, COLLECT_STATS, DISTANCE_VOLUME, PRECISION and BAKED_NOISE are not feature switches and
+// are defined for the generic variant too; every formula has programs of its own.
+static ShaderDefines geometry_defines(const AppSettings& settings, const bool collect_stats, const bool use_distance_volume, const int precision) {
+	ShaderDefines defines = {{"GEOMETRY_PASS", 1}, {"FORMULA", make_fractal_params(settings).formula}};
+	if (settings.specialize_shaders) {
+		defines.insert(defines.end(), {
+			{"INTEGER_POWER", integer_power(settings.power)},
+			{"BACKGROUND_TYPE", settings.background_type},
+			{"NORMAL_METHOD", settings.normal_method}
+		});
+	}
+	if (collect_stats) {
+		defines.emplace_back("COLLECT_STATS", 1);
+	}
+	if (use_distance_volume) {
+		defines.emplace_back("DISTANCE_VOLUME", 1);
+	}
+	if (precision != precision_fp32) {
+		defines.emplace_back("PRECISION", precision);
+	}
+	return defines;
+}
+
+static ShaderDefines shading_defines(const AppSettings& settings, const bool collect_stats, const bool use_baked_noise) {
+	ShaderDefines defines;
+	if (settings.specialize_shaders) {
+		defines = {
+			{"ENABLE_NORMAL_VISUALIZATION", settings.enable_normal_visualization},
+			{"ENABLE_STEP_HEATMAP", settings.enable_step_heatmap},
+			{"INTEGER_POWER", integer_power(settings.power)},
+			{"COLORING_METHOD", settings.coloring_method},
+			{"BACKGROUND_TYPE", settings.background_type},
+			{"SHOW_LIGHT", settings.show_light},
+			{"APPLY_NOISE", settings.apply_noise},
+			{"APPLY_BLINN_PHONG", settings.apply_blinn_phong},
+			{"APPLY_SOFT_SHADOW", settings.apply_soft_shadow},
+			{"APPLY_BLOOM", settings.apply_bloom},
+			{"APPLY_AMBIENT_OCCLUSION", settings.apply_ambient_occlusion}
+		};
+	}
+	defines.emplace_back("FORMULA", make_fractal_params(settings).formula);
+	if (collect_stats) {
+		defines.emplace_back("COLLECT_STATS", 1);
+	}
+	if (use_baked_noise) {
+		defines.emplace_back("BAKED_NOISE", 1);
+	}
+	return defines;
+}
+
+Renderer::Renderer()
+	: shader("shaders/shader.vert", "shaders/shader.frag"),
+	  compute_shader(std::vector<std::string>{"shaders/shader.frag", "shaders/march.comp"}),
+	  render_params_buffer(render_params_binding, sizeof(RenderParams)),
+	  gbuffer(make_gbuffer()),
+	  framebuffer({GL_RGBA8}),
+	  interleaved_gbuffer(make_gbuffer()),
+	  history_gbuffer(make_gbuffer()),
+	  aa_edges({GL_R8}),
+	  aa_framebuffer({GL_RGBA8}),
+	  offscreen_shaded({GL_RGBA8}) {
+	constexpr float quad_vertices[] = {
+		-1.0f,  1.0f,
+		-1.0f, -1.0f,
+		 1.0f, -1.0f,
+
+		-1.0f,  1.0f,
+		 1.0f, -1.0f,
+		 1.0f,  1.0f
+	};
+	glGenVertexArrays(1, &quad_vao);
+	glGenBuffers(1, &quad_vbo);
+	glBindVertexArray(quad_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices), quad_vertices, GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+	glEnableVertexAttribArray(0);
+	glBindVertexArray(0);
+	glGenBuffers(1, &compute_march_buffer);
+}
+
+Renderer::~Renderer() {
+	glDeleteVertexArrays(1, &quad_vao);
+	glDeleteBuffers(1, &quad_vbo);
+	glDeleteBuffers(1, &compute_march_buffer);
+}
+
+void Renderer::render(const AppSettings& settings, const Camera& camera, const GradientEditor& gradient_editor, const Viewport& viewport, const float aspect_ratio) {
+	// Minimized window
+	if (viewport.width <= 0 || viewport.height <= 0) {
+		return;
+	}
+	stats.frame_count++;
+
+	// Every input is compared every frame rather than flagged where it is modified, since the GUI
+	// writes straight into the settings and the camera.
+	const glm::mat4 projection_matrix = glm::perspective(glm::radians(camera.zoom), aspect_ratio, 0.1f, 100.0f);
+	const float scale = update_resolution_scale(settings);
+	const int width = std::max(1, static_cast<int>(std::lround(static_cast<float>(viewport.width) * scale)));
+	const int height = std::max(1, static_cast<int>(std::lround(static_cast<float>(viewport.height) * scale)));
+	const View view{glm::inverse(camera.view_matrix()), glm::inverse(projection_matrix), camera.position, camera.position_low,
+		pixel_angle(projection_matrix, height)};
+	// The distance volume is float-only, and too coarse to help where extended precision is needed
+	const int precision = select_precision(settings, camera, view.pixel_angle);
+	const bool use_distance_volume = update_distance_volume(settings) && precision == precision_fp32;
+	ShaderDefines new_geometry_defines = geometry_defines(settings, settings.collect_ray_stats, use_distance_volume, precision);
+	// Noise is evaluated per pixel until the baked volume is uploaded
+	const bool use_baked_noise = update_noise_volume(settings, false);
+	ShaderDefines new_shading_defines = shading_defines(settings, settings.collect_ray_stats, use_baked_noise);
+	const AntiAliasing new_anti_aliasing = anti_aliasing_settings(settings, precision);
+	const int interleave = interleave_settings(settings, precision);
+	const bool compute_march = compute_march_settings(settings, precision, settings.collect_ray_stats);
+	const RenderParams render_params = make_render_params(settings);
+
+	// Changes that leave nothing of the G-buffer to reproject, so every pixel is marched again
+	bool reset_geometry = gbuffer.resize(width, height);
+	reset_geometry |= geometry_changed(render_params, last_render_params);
+	reset_geometry |= new_geometry_defines != last_geometry_defines;
+	reset_geometry |= interleave != last_interleave || compute_march != last_compute_march || !has_geometry;
+	const bool view_changed = view != last_view;
+	bool run_geometry = reset_geometry || view_changed;
+	// Statistics describe whole frames, so both passes run while they are collected
+	run_geometry |= !settings.render_on_demand || settings.collect_ray_stats;
+	// A still view keeps marching until every pixel was marched in it
+	run_geometry |= interleaved_frames < interleave;
+
+	bool run_shading = framebuffer.resize(width, height);
+	run_shading |= update_inputs(settings, gradient_editor, render_params);
+	run_shading |= new_shading_defines != last_shading_defines;
+	run_shading |= new_anti_aliasing != last_anti_aliasing;
+	run_shading |= run_geometry || !has_frame;
+	last_render_params = render_params;
+
+	gpu_timer.begin(run_geometry ? full_frame_tag : 0);
+	if (settings.collect_ray_stats) {
+		ray_stats.begin();
+	}
+	if (run_geometry) {
+		profiler.begin(ProfilePhase::geometry_pass);
+		if (interleave > 1 && !reset_geometry) {
+			interleaved_frames = view_changed ? 1 : std::min(interleaved_frames + 1, interleave);
+			interleaved_geometry_pass(new_geometry_defines, interleave, view, last_view, use_distance_volume);
+			stats.compute_march = false;
+		} else {
+			interleaved_frames = interleave;
+			geometry_pass(new_geometry_defines, gbuffer, view, use_distance_volume, compute_march);
+			stats.compute_march = compute_march;
+		}
+		if (interleave > 1) {
+			// The next frame reprojects this one
+			history_gbuffer.resize(width, height);
+			for (int i = 0; i < gbuffer_attachment_count; i++) {
+				glCopyImageSubData(gbuffer.get_texture(i), GL_TEXTURE_2D, 0, 0, 0, 0,
+					history_gbuffer.get_texture(i), GL_TEXTURE_2D, 0, 0, 0, 0, width, height, 1);
+			}
+		}
+		profiler.end(ProfilePhase::geometry_pass);
+		last_view = view;
+		last_interleave = interleave;
+		last_compute_march = compute_march;
+		last_geometry_defines = std::move(new_geometry_defines);
+		has_geometry = true;
+		stats.geometry_pass_count++;
+	}
+	if (run_shading) {
+		profiler.begin(ProfilePhase::shading_pass);
+		shading_pass(new_shading_defines, gbuffer, framebuffer, last_view);
+		profiler.end(ProfilePhase::shading_pass);
+		last_shading_defines = std::move(new_shading_defines);
+		if (new_anti_aliasing.enabled) {
+			profiler.begin(ProfilePhase::anti_aliasing);
+			anti_aliasing_pass(new_anti_aliasing, last_shading_defines, gbuffer, framebuffer, aa_framebuffer, last_view);
+			profiler.end(ProfilePhase::anti_aliasing);
+		}
+		last_anti_aliasing = new_anti_aliasing;
+		has_frame = true;
+		stats.shading_pass_count++;
+	}
+	if (settings.collect_ray_stats) {
+		ray_stats.end();
+	}
+	profiler.begin(ProfilePhase::blit);
+	(last_anti_aliasing.enabled ? aa_framebuffer : framebuffer).blit_to_screen(viewport);
+	profiler.end(ProfilePhase::blit);
+	gpu_timer.end();
+
+	stats.gpu_frame_time = gpu_timer.get_elapsed();
+	stats.last_geometry_pass = run_geometry;
+	stats.last_shading_pass = run_shading;
+	stats.resolution_scale = scale;
+	stats.render_width = width;
+	stats.render_height = height;
+	if (run_geometry) {
+		stats.precision = precision;
+	}
+	stats.interleave = interleave;
+	stats.interleaved_frames = interleaved_frames;
+}
+
+void Renderer::render_offscreen(const AppSettings& settings, const Camera& camera, const GradientEditor& gradient_editor,
+	const glm::mat4& projection_matrix, const int width, const int height, Framebuffer& geometry, Framebuffer& target) {
+	const View view{glm::inverse(camera.view_matrix()), glm::inverse(projection_matrix), camera.position, camera.position_low,
+		pixel_angle(projection_matrix, height)};
+	const RenderParams render_params = make_render_params(settings);
+
+	// A change of the settings also invalidates the window image, which is compared against the
+	// last render parameters and inputs on the next render().
+	if (update_inputs(settings, gradient_editor, render_params)) {
+		has_frame = false;
+	}
+	geometry.resize(width, height);
+	target.resize(width, height);
+	const int precision = select_precision(settings, camera, view.pixel_angle);
+	const ShaderDefines defines = shading_defines(settings, settings.collect_ray_stats, update_noise_volume(settings, true));
+	const AntiAliasing offscreen_anti_aliasing = anti_aliasing_settings(settings, precision);
+	if (settings.collect_ray_stats) {
+		ray_stats.begin();
+	}
+	geometry_pass(geometry_defines(settings, settings.collect_ray_stats, false, precision), geometry, view, false,
+		compute_march_settings(settings, precision, settings.collect_ray_stats));
+	if (offscreen_anti_aliasing.enabled) {
+		offscreen_shaded.resize(width, height);
+		shading_pass(defines, geometry, offscreen_shaded, view);
+		anti_aliasing_pass(offscreen_anti_aliasing, defines, geometry, offscreen_shaded, target, view);
+	} else {
+		shading_pass(defines, geometry, target, view);
+	}
+	if (settings.collect_ray_stats) {
+		ray_stats.end();
+	}
+}
+
+bool Renderer::update_inputs(const AppSettings& settings, const GradientEditor& gradient_editor, const RenderParams& render_params) {
+	profiler.begin(ProfilePhase::uniform_upload);
+	bool changed = render_params_buffer.update(&render_params);
+	profiler.end(ProfilePhase::uniform_upload);
+	profiler.begin(ProfilePhase::gradient_upload);
+	glActiveTexture(GL_TEXTURE0 + gradient_texture_unit);
+	changed |= gradient_texture.update(gradient_editor, settings.gradient_lut_size, settings.gradient_float_lut);
+	profiler.end(ProfilePhase::gradient_upload);
+	return changed;
+}
+
+void Renderer::geometry_pass(const ShaderDefines& defines, const Framebuffer& target, const View& view, const bool use_distance_volume,
+	const bool use_compute) {
+	if (use_compute) {
+		compute_geometry_pass(defines, target, view, use_distance_volume);
+		return;
+	}
+	target.bind();
+	shader.bind(defines);
+	set_view_uniforms(shader, view);
+	if (use_distance_volume) {
+		bind_distance_volume(shader);
+	}
+	draw_quad();
+}
+
+void Renderer::compute_geometry_pass(const ShaderDefines& defines, const Framebuffer& target, const View& view, const bool use_distance_volume) {
+	const int width = target.get_width();
+	const int height = target.get_height();
+	const int tiles_x = (width + compute_tile_size - 1) / compute_tile_size;
+	const int tiles_y = (height + compute_tile_size - 1) / compute_tile_size;
+
+	// Clears the ray counter, growing the buffer to hold the cone of every tile
+	const GLsizeiptr buffer_size = compute_march_header_size + static_cast<GLsizeiptr>(tiles_x) * tiles_y * 4 * sizeof(float);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, compute_march_buffer);
+	if (buffer_size > compute_march_buffer_size) {
+		glBufferData(GL_SHADER_STORAGE_BUFFER, buffer_size, nullptr, GL_DYNAMIC_DRAW);
+		compute_march_buffer_size = buffer_size;
+	}
+	constexpr GLuint next_ray = 0;
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(next_ray), &next_ray);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, compute_march_binding, compute_march_buffer);
+
+	ShaderDefines compute_defines = defines;
+	for (const ComputePass pass : {compute_pass_tiles, compute_pass_rays}) {
+		compute_defines.emplace_back("COMPUTE_PASS", pass);
+		compute_shader.bind(compute_defines);
+		compute_defines.pop_back();
+		set_view_uniforms(compute_shader, view);
+		compute_shader.set_uniform_2i("u_frame_size", width, height);
+		compute_shader.set_uniform_2i("u_tile_count", tiles_x, tiles_y);
+		if (use_distance_volume) {
+			bind_distance_volume(compute_shader);
+		}
+
+		if (pass == compute_pass_tiles) {
+			// One tile per invocation
+			glDispatchCompute((tiles_x + compute_tile_size - 1) / compute_tile_size, (tiles_y + compute_tile_size - 1) / compute_tile_size, 1);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		} else {
+			for (int i = 0; i < gbuffer_attachment_count; i++) {
+				glBindImageTexture(static_cast<GLuint>(i), target.get_texture(i), 0, GL_FALSE, 0, GL_WRITE_ONLY, gbuffer_formats[i]);
+			}
+			// One work group per tile at most, since a group marches as many rays at once as a tile has
+			glDispatchCompute(static_cast<GLuint>(std::min(tiles_x * tiles_y, compute_persistent_groups)), 1, 1);
+			// The buffer update orders the next frame's reset of the ray counter after the atomics
+			glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+		}
+	}
+}
+
+void Renderer::interleaved_geometry_pass(const ShaderDefines& defines, const int interleave, const View& view, const View& history_view,
+	const bool use_distance_volume) {
+	const int width = gbuffer.get_width();
+	const int height = gbuffer.get_height();
+	interleave_phase = (interleave_phase + 1) % interleave;
+
+	// A checkerboard marches half of each row, 2x2 interleaving half of every other row
+	ShaderDefines marched_defines = defines;
+	marched_defines.emplace_back("INTERLEAVE", interleave);
+	interleaved_gbuffer.resize((width + 1) / 2, interleave == 2 ? height : (height + 1) / 2);
+	interleaved_gbuffer.bind();
+	shader.bind(marched_defines);
+	set_view_uniforms(shader, view);
+	shader.set_uniform_1i("u_interleave_phase", interleave_phase);
+	shader.set_uniform_2i("u_frame_size", width, height);
+	if (use_distance_volume) {
+		bind_distance_volume(shader);
+	}
+	draw_quad();
+
+	static constexpr const char* history_uniform_names[] = {"u_history_position", "u_history_normal", "u_history_miss"};
+	gbuffer.bind();
+	shader.bind({{"RECONSTRUCT_PASS", 1}, {"INTERLEAVE", interleave}});
+	set_view_uniforms(shader, view);
+	shader.set_uniform_1i("u_interleave_phase", interleave_phase);
+	shader.set_uniform_2i("u_frame_size", width, height);
+	for (int i = 0; i < gbuffer_attachment_count; i++) {
+		bind_texture(gbuffer_texture_unit + static_cast<GLuint>(i), interleaved_gbuffer.get_texture(i), gbuffer_uniform_names[i]);
+		bind_texture(history_texture_unit + static_cast<GLuint>(i), history_gbuffer.get_texture(i), history_uniform_names[i]);
+	}
+	// projection_matrix * view_matrix of the history
+	shader.set_uniform_mat4("u_history_view_projection", glm::inverse(history_view.inverse_view_matrix * history_view.inverse_projection_matrix));
+	shader.set_uniform_1i("u_history_exact", history_view == view ? 1 : 0);
+	glActiveTexture(GL_TEXTURE0);
+	draw_quad();
+}
+
+void Renderer::shading_pass(const ShaderDefines& defines, const Framebuffer& geometry, const Framebuffer& target, const View& view) {
+	target.bind();
+	shader.bind(defines);
+	set_view_uniforms(shader, view);
+
+	bind_texture(gradient_texture_unit, gradient_texture.get_id(), "u_gradient_texture");
+	for (int i = 0; i < gbuffer_attachment_count; i++) {
+		bind_texture(gbuffer_texture_unit + static_cast<GLuint>(i), geometry.get_texture(i), gbuffer_uniform_names[i]);
+	}
+	bind_noise_volume();
+	glActiveTexture(GL_TEXTURE0);
+	draw_quad();
+}
+
+void Renderer::anti_aliasing_pass(const AntiAliasing& anti_aliasing, const ShaderDefines& shading_defines, const Framebuffer& geometry,
+	const Framebuffer& shaded, Framebuffer& target, const View& view) {
+	const int width = geometry.get_width();
+	const int height = geometry.get_height();
+	aa_edges.resize(width, height);
+	target.resize(width, height);
+	adaptive_aa.begin(width * height, anti_aliasing.samples);
+
+	// Edge pass, which also fills the histogram of edge strengths
+	aa_edges.bind();
+	shader.bind({{"AA_EDGE_PASS", 1}});
+	set_view_uniforms(shader, view);
+	bind_texture(aa_color_texture_unit, shaded.get_texture(0), "u_aa_color");
+	for (int i = 0; i < gbuffer_attachment_count; i++) {
+		bind_texture(gbuffer_texture_unit + static_cast<GLuint>(i), geometry.get_texture(i), gbuffer_uniform_names[i]);
+	}
+	shader.set_uniform_1f("u_aa_threshold", anti_aliasing.threshold);
+	draw_quad();
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	// Resolve pass, with the shading variant's switches since it shades the extra rays
+	ShaderDefines resolve_defines = shading_defines;
+	resolve_defines.emplace_back("AA_RESOLVE_PASS", 1);
+	target.bind();
+	shader.bind(resolve_defines);
+	set_view_uniforms(shader, view);
+	bind_texture(gradient_texture_unit, gradient_texture.get_id(), "u_gradient_texture");
+	bind_texture(aa_color_texture_unit, shaded.get_texture(0), "u_aa_color");
+	bind_texture(aa_edge_texture_unit, aa_edges.get_texture(0), "u_aa_edges");
+	bind_noise_volume();
+	shader.set_uniform_1i("u_aa_samples", anti_aliasing.samples);
+	shader.set_uniform_1i("u_aa_max_pixels", anti_aliasing.ray_budget / anti_aliasing.samples);
+	glActiveTexture(GL_TEXTURE0);
+	draw_quad();
+	adaptive_aa.end();
+}
+
+// The extra rays are marched in float, and the debug views have no extra rays to average
+Renderer::AntiAliasing Renderer::anti_aliasing_settings(const AppSettings& settings, const int precision) {
+	if (!settings.adaptive_aa || precision != precision_fp32 || settings.enable_normal_visualization || settings.enable_step_heatmap) {
+		return {};
+	}
+	return {true, settings.aa_threshold, std::clamp(settings.aa_samples, 1, 64), std::max(settings.aa_ray_budget, 0)};
+}
+
+// Interleaved pixels are reprojected in float, which cannot resolve the pixels of deep zooms
+int Renderer::interleave_settings(const AppSettings& settings, const int precision) {
+	if (precision != precision_fp32) {
+		return 1;
+	}
+	switch (settings.interleave_mode) {
+	case interleave_checkerboard:
+		return 2;
+	case interleave_quarter:
+		return 4;
+	default:
+		return 1;
+	}
+}
+
+// The compute pass marches in float and does not count ray statistics
+bool Renderer::compute_march_settings(const AppSettings& settings, const int precision, const bool collect_stats) {
+	return settings.compute_march && precision == precision_fp32 && !collect_stats;
+}
+
+void Renderer::bind_texture(const GLuint unit, const GLuint texture, const std::string_view uniform_name) const {
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	shader.set_uniform_1i(uniform_name, static_cast<int>(unit));
+}
+
+float Renderer::update_resolution_scale(const AppSettings& settings) {
+	const float min_scale = std::clamp(settings.min_resolution_scale, 0.1f, 1.0f);
+	if (!settings.dynamic_resolution) {
+		dynamic_resolution = false;
+		return std::clamp(settings.resolution_scale, 0.1f, 1.0f);
+	}
+	if (!dynamic_resolution) {
+		// Starts from the fixed scale, ignoring the results of frames rendered before
+		resolution_controller.reset(std::clamp(settings.resolution_scale, min_scale, 1.0f));
+		last_timer_result = gpu_timer.get_result_count();
+		dynamic_resolution = true;
+	}
+
+	// Only frames that ran both passes cost what a changing view costs. Results of frames that
+	// skipped them would let the scale climb while nothing is rendered.
+	if (gpu_timer.get_result_count() != last_timer_result) {
+		last_timer_result = gpu_timer.get_result_count();
+		if (gpu_timer.get_tag() == full_frame_tag) {
+			resolution_controller.add_sample(gpu_timer.get_elapsed(), settings.frame_time_budget, min_scale, 1.0f);
+		}
+	}
+	return resolution_controller.get_scale();
+}
+
+bool Renderer::update_distance_volume(const AppSettings& settings) {
+	if (!settings.use_distance_volume) {
+		return false;
+	}
+	const FractalParams params = make_fractal_params(settings);
+	distance_volume_baker.request(params, settings.distance_volume_resolution);
+	if (const std::unique_ptr<DistanceVolume> volume = distance_volume_baker.take_result()) {
+		distance_volume.upload(*volume);
+	}
+	return distance_volume.matches(params, settings.distance_volume_resolution);
+}
+
+// Noise that is turned off is never baked
+bool Renderer::update_noise_volume(const AppSettings& settings, const bool wait) {
+	if (!settings.baked_noise || !settings.apply_noise) {
+		return false;
+	}
+	noise_volume_baker.request(settings.noise_volume_resolution);
+	if (const std::unique_ptr<NoiseVolume> volume = wait ? noise_volume_baker.wait_result() : noise_volume_baker.take_result()) {
+		noise_volume.upload(*volume);
+	}
+	return noise_volume.has_volume() && noise_volume.get_resolution() == settings.noise_volume_resolution;
+}
+
+void Renderer::set_view_uniforms(const Shader& target_shader, const View& view) const {
+	target_shader.set_uniform_mat4("u_inverse_view_matrix", view.inverse_view_matrix);
+	target_shader.set_uniform_mat4("u_inverse_projection_matrix", view.inverse_projection_matrix);
+	target_shader.set_uniform_2f("u_resolution", default_width, default_height);
+	target_shader.set_uniform_vec3("u_camera_pos", view.camera_pos);
+	target_shader.set_uniform_vec3("u_camera_pos_low", view.camera_pos_low);
+	target_shader.set_uniform_1f("u_pixel_angle", view.pixel_angle);
+}
+
+void Renderer::bind_distance_volume(const Shader& target_shader) const {
+	distance_volume.bind(volume_indirection_texture_unit, volume_atlas_texture_unit);
+	target_shader.set_uniform_1i("u_volume_indirection", static_cast<int>(volume_indirection_texture_unit));
+	target_shader.set_uniform_1i("u_volume_atlas", static_cast<int>(volume_atlas_texture_unit));
+}
+
+// Programs without BAKED_NOISE have no u_noise_volume, which leaves the uniform unset
+void Renderer::bind_noise_volume() const {
+	noise_volume.bind(noise_texture_unit);
+	shader.set_uniform_1i("u_noise_volume", static_cast<int>(noise_texture_unit));
+}
+
+void Renderer::draw_quad() const {
+	glBindVertexArray(quad_vao);
+	glDrawArrays(GL_TRIANGLES, 0, 6);
+	glBindVertexArray(0);
+}
+
+Framebuffer Renderer::make_gbuffer() {
+	return Framebuffer(std::vector<GLenum>(std::begin(gbuffer_formats), std::end(gbuffer_formats)));
+}
+
+const RendererStats& Renderer::get_stats() const {
+	return stats;
+}
+
+const ShaderBuildStats& Renderer::get_shader_build_stats() const {
+	return shader.build_stats();
+}
+
+ImTextureID Renderer::get_gradient_texture_id() const {
+	return gradient_texture.get_imgui_id();
+}
+
+const RayStats& Renderer::get_ray_stats() const {
+	return ray_stats.get_stats();
+}
+
+const AdaptiveAaStats& Renderer::get_adaptive_aa_stats() const {
+	return adaptive_aa.get_stats();
+}
+
+Profiler& Renderer::get_profiler() {
+	return profiler;
+}
+
+const ResolutionController& Renderer::get_resolution_controller() const {
+	return resolution_controller;
+}
+
+const DistanceVolumeTexture& Renderer::get_distance_volume() const {
+	return distance_volume;
+}
+
+bool Renderer::is_baking_distance_volume() const {
+	return distance_volume_baker.is_baking();
+}
+
+const NoiseVolumeTexture& Renderer::get_noise_volume() const {
+	return noise_volume;
+}
+
+bool Renderer::is_baking_noise_volume() const {
+	return noise_volume_baker.is_baking();
+}
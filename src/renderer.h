@@ -0,0 +1,222 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <imgui.h>
+
+#include "adaptive_aa.h"
+#include "app_settings.h"
+#include "camera.h"
+#include "distance_volume.h"
+#include "distance_volume_texture.h"
+#include "framebuffer.h"
+#include "gpu_timer.h"
+#include "gradient_editor.h"
+#include "gradient_texture.h"
+#include "noise_volume_texture.h"
+#include "profiler.h"
+#include "ray_stats.h"
+#include "resolution_controller.h"
+#include "render_params.h"
+#include "shader.h"
+#include "uniform_ring.h"
+#include "window.h"
+
+struct RendererStats {
+	double gpu_frame_time = 0.0; // milliseconds
+	unsigned long long frame_count = 0;
+	unsigned long long geometry_pass_count = 0;
+	unsigned long long shading_pass_count = 0;
+	bool last_geometry_pass = false;
+	bool last_shading_pass = false;
+	// Size the fractal is rendered at, before it is scaled to the viewport
+	float resolution_scale = 1.0f;
+	int render_width = 0;
+	int render_height = 0;
+	// PrecisionMode the last geometry pass marched in, never precision_auto
+	int precision = precision_fp32;
+	// Frames the marched pixels are interleaved over, 1 if the geometry pass marches all of them
+	int interleave = 1;
+	// Geometry passes of the current view, whose image is exact once they reach interleave
+	int interleaved_frames = 0;
+	// Whether the last geometry pass ran as the compute ray marcher
+	bool compute_march = false;
+};
+
+// Renders the fractal in two passes and blits the result into the window. The geometry pass ray
+// marches into a G-buffer and the shading pass lights and colors it into an offscreen framebuffer.
+// The geometry pass only runs again when the camera, the viewport size or a setting that moves the
+// surface changed, so lighting and coloring edits cost a single shading pass. In render-on-demand
+// mode the shading pass is skipped too when nothing changed, and the frame only blits the last
+// image. The fractal can be rendered at a fraction of the viewport size and upscaled, with the
+// fraction either fixed or chosen by a ResolutionController from the GPU time of the frames that
+// ran both passes. The geometry pass marches in the precision of settings.precision_mode, which in
+// auto mode switches to df64 for deep zooms. With settings.interleave_mode, the geometry pass marches
+// only some of the pixels of each frame and reconstructs the others from the previous G-buffer,
+// and keeps running while the view is still until every pixel was marched in it. With
+// settings.compute_march, the geometry pass runs as a compute shader that starts the rays of each tile
+// from a shared cone march and keeps its threads busy with new rays. With
+// settings.use_distance_volume, render() bakes a
+// DistanceVolume of the current fractal in the background and marches through it once it is
+// uploaded. With settings.baked_noise, a NoiseVolume is baked in the background the same way, and
+// the surface noise is sampled from it once it is uploaded. With settings.adaptive_aa, an edge pass and a
+// resolve pass after the shading pass fire extra rays through the pixels on silhouettes and fine
+// detail. The passes of render() and the
+// input uploads are timed by a Profiler, which the caller brackets each window frame for.
+// Requires a current OpenGL context.
+class Renderer {
+public:
+	Renderer();
+	~Renderer();
+
+	Renderer(const Renderer&) = delete;
+	Renderer& operator=(const Renderer&) = delete;
+
+	// Draws the fractal into viewport of the default framebuffer, which is left bound.
+	void render(const AppSettings& settings, const Camera& camera, const GradientEditor& gradient_editor, const Viewport& viewport, float aspect_ratio);
+	// Runs both passes with projection_matrix into target, using geometry as the G-buffer (see
+	// make_gbuffer()), and leaves target bound. Both are resized to width x height. The window
+	// image stays cached. Offscreen images always use the exact distance estimator, so they do not
+	// depend on whether a bake has finished. With baked noise, they wait for the noise volume of the
+	// settings to be baked, so that every frame of an animation or export samples the same noise.
+	// With settings.collect_ray_stats, its passes are counted as those of render() are.
+	void render_offscreen(const AppSettings& settings, const Camera& camera, const GradientEditor& gradient_editor,
+		const glm::mat4& projection_matrix, int width, int height, Framebuffer& geometry, Framebuffer& target);
+
+	// Framebuffer with the attachments of the G-buffer, for render_offscreen()
+	[[nodiscard]] static Framebuffer make_gbuffer();
+
+	[[nodiscard]] const RendererStats& get_stats() const;
+	[[nodiscard]] const ShaderBuildStats& get_shader_build_stats() const;
+	[[nodiscard]] ImTextureID get_gradient_texture_id() const;
+	// Totals of the last counted frame, in the window or offscreen, while settings.collect_ray_stats is on
+	[[nodiscard]] const RayStats& get_ray_stats() const;
+	// Extra rays of the last counted frame that was anti-aliased
+	[[nodiscard]] const AdaptiveAaStats& get_adaptive_aa_stats() const;
+	[[nodiscard]] Profiler& get_profiler();
+	[[nodiscard]] const ResolutionController& get_resolution_controller() const;
+	// The last uploaded volume, which may be of other settings
+	[[nodiscard]] const DistanceVolumeTexture& get_distance_volume() const;
+	[[nodiscard]] bool is_baking_distance_volume() const;
+	// The last uploaded noise volume, which may be of another resolution
+	[[nodiscard]] const NoiseVolumeTexture& get_noise_volume() const;
+	[[nodiscard]] bool is_baking_noise_volume() const;
+
+private:
+	// G-buffer attachments, see the outputs of the geometry pass in shader.frag
+	enum GBufferAttachment {
+		gbuffer_position,
+		gbuffer_normal,
+		gbuffer_miss,
+		gbuffer_attachment_count
+	};
+
+	static constexpr GLuint gradient_texture_unit = 0;
+	static constexpr GLuint gbuffer_texture_unit = 1;
+	static constexpr GLuint volume_indirection_texture_unit = gbuffer_texture_unit + gbuffer_attachment_count;
+	static constexpr GLuint volume_atlas_texture_unit = volume_indirection_texture_unit + 1;
+	static constexpr GLuint aa_color_texture_unit = volume_atlas_texture_unit + 1;
+	static constexpr GLuint aa_edge_texture_unit = aa_color_texture_unit + 1;
+	static constexpr GLuint history_texture_unit = aa_edge_texture_unit + 1;
+	static constexpr GLuint noise_texture_unit = history_texture_unit + gbuffer_attachment_count;
+
+	struct View {
+		glm::mat4 inverse_view_matrix = glm::mat4(0.0f);
+		glm::mat4 inverse_projection_matrix = glm::mat4(0.0f);
+		glm::vec3 camera_pos = glm::vec3(0.0f);
+		glm::vec3 camera_pos_low = glm::vec3(0.0f);
+		// Angle between the rays of neighboring pixels
+		float pixel_angle = 0.0f;
+
+		bool operator==(const View&) const = default;
+	};
+
+	// Adaptive anti-aliasing of a frame, from the settings
+	struct AntiAliasing {
+		bool enabled = false;
+		float threshold = 0.0f;
+		int samples = 0;
+		int ray_budget = 0;
+
+		bool operator==(const AntiAliasing&) const = default;
+	};
+
+	Shader shader;
+	// shader.frag with shaders/march.comp, for the compute geometry pass
+	Shader compute_shader;
+	GLuint compute_march_buffer = 0;
+	GLsizeiptr compute_march_buffer_size = 0;
+	GLuint quad_vao = 0;
+	GLuint quad_vbo = 0;
+	GradientTexture gradient_texture;
+	UniformRing render_params_buffer;
+	Framebuffer gbuffer;
+	Framebuffer framebuffer;
+	// Pixels marched by an interleaved geometry pass, and the G-buffer of the previous frame
+	Framebuffer interleaved_gbuffer;
+	Framebuffer history_gbuffer;
+	// Edge strengths, and the anti-aliased image of the window
+	Framebuffer aa_edges;
+	Framebuffer aa_framebuffer;
+	// Shading pass output of render_offscreen() while it anti-aliases
+	Framebuffer offscreen_shaded;
+	AdaptiveAaBuffer adaptive_aa;
+	GpuTimer gpu_timer;
+	Profiler profiler;
+	RayStatsBuffer ray_stats;
+	ResolutionController resolution_controller;
+	unsigned long long last_timer_result = 0;
+	bool dynamic_resolution = false;
+	DistanceVolumeBaker distance_volume_baker;
+	DistanceVolumeTexture distance_volume;
+	NoiseVolumeBaker noise_volume_baker;
+	NoiseVolumeTexture noise_volume;
+	RendererStats stats;
+
+	// Inputs of the G-buffer and of the image in the framebuffer that are not covered by the uniform
+	// ring or the gradient texture.
+	RenderParams last_render_params{};
+	ShaderDefines last_geometry_defines;
+	ShaderDefines last_shading_defines;
+	View last_view;
+	AntiAliasing last_anti_aliasing;
+	int last_interleave = 1;
+	bool last_compute_march = false;
+	int interleave_phase = 0;
+	int interleaved_frames = 0;
+	bool has_geometry = false;
+	bool has_frame = false;
+
+	// The shading pass draws with the view of its geometry pass, since any view change runs that again.
+	void geometry_pass(const ShaderDefines& defines, const Framebuffer& target, const View& view, bool use_distance_volume, bool use_compute);
+	// geometry_pass() as a cone march per tile followed by persistent threads that march the rays
+	// and store them into the attachments of target.
+	void compute_geometry_pass(const ShaderDefines& defines, const Framebuffer& target, const View& view, bool use_distance_volume);
+	// Marches the pixels of the next phase of interleave and reconstructs the rest of gbuffer from
+	// history_gbuffer, which was rendered with history_view.
+	void interleaved_geometry_pass(const ShaderDefines& defines, int interleave, const View& view, const View& history_view, bool use_distance_volume);
+	void shading_pass(const ShaderDefines& defines, const Framebuffer& geometry, const Framebuffer& target, const View& view);
+	// Finds the edges of shaded, the output of the shading pass with shading_defines, and writes it
+	// with extra rays through the strongest of them into target, which is resized to match.
+	void anti_aliasing_pass(const AntiAliasing& anti_aliasing, const ShaderDefines& shading_defines, const Framebuffer& geometry,
+		const Framebuffer& shaded, Framebuffer& target, const View& view);
+	void bind_texture(GLuint unit, GLuint texture, std::string_view uniform_name) const;
+	[[nodiscard]] static AntiAliasing anti_aliasing_settings(const AppSettings& settings, int precision);
+	[[nodiscard]] static bool compute_march_settings(const AppSettings& settings, int precision, bool collect_stats);
+	// Frames the pixels are interleaved over, 1 for none
+	[[nodiscard]] static int interleave_settings(const AppSettings& settings, int precision);
+	// Brings the uniform ring and the gradient texture up to date and returns whether either changed.
+	bool update_inputs(const AppSettings& settings, const GradientEditor& gradient_editor, const RenderParams& render_params);
+	// Scale of this frame, fixed or from the resolution controller
+	float update_resolution_scale(const AppSettings& settings);
+	// Requests a bake for the current fractal, uploads a finished one and returns whether the
+	// uploaded volume matches the settings.
+	bool update_distance_volume(const AppSettings& settings);
+	void set_view_uniforms(const Shader& target_shader, const View& view) const;
+	void bind_distance_volume(const Shader& target_shader) const;
+	// Requests a bake of the noise volume the settings sample, uploads a finished one and returns
+	// whether the uploaded volume matches the settings. With wait, a bake in progress is waited for.
+	bool update_noise_volume(const AppSettings& settings, bool wait);
+	void bind_noise_volume() const;
+	void draw_quad() const;
+};
@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <cmath>
+
+#include "resolution_controller.h"
+
+ResolutionController::ResolutionController() {
+	history.reserve(history_size);
+}
+
+void ResolutionController::add_sample(const double milliseconds, const double budget, const float min_scale, const float max_scale) {
+	const float clamped_scale = std::clamp(scale, min_scale, max_scale);
+	if (clamped_scale != scale) {
+		reset(clamped_scale);
+	}
+
+	if (samples_to_skip > 0) {
+		samples_to_skip--;
+	} else {
+		frame_time = frame_time > 0.0 ? frame_time + (milliseconds - frame_time) * smoothing : milliseconds;
+		const double ratio = budget / std::max(frame_time, 1e-3);
+		if (std::abs(ratio - 1.0) > dead_band) {
+			float target = scale * static_cast<float>(std::sqrt(ratio));
+			target = std::clamp(target, scale * max_decrease, scale * max_increase);
+			// Whole percents, so that the render target is not resized for tiny changes
+			target = std::clamp(std::round(target * 100.0f) / 100.0f, min_scale, max_scale);
+			if (target != scale) {
+				scale = target;
+				frame_time = 0.0;
+				samples_to_skip = settle_samples;
+			}
+		}
+	}
+
+	if (static_cast<int>(history.size()) == history_size) {
+		history.erase(history.begin());
+	}
+	history.push_back(scale);
+}
+
+void ResolutionController::reset(const float new_scale) {
+	scale = new_scale;
+	frame_time = 0.0;
+	samples_to_skip = settle_samples;
+}
+
+float ResolutionController::get_scale() const {
+	return scale;
+}
+
+double ResolutionController::get_frame_time() const {
+	return frame_time;
+}
+
+const std::vector<float>& ResolutionController::get_history() const {
+	return history;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+// Chooses the fraction of the window resolution the fractal is rendered at so that its GPU time
+// stays within a budget. Ray marching costs about the same per pixel, so the time scales with the
+// square of the scale, and each step moves the scale towards the one that would meet the budget.
+// Frame times are smoothed, small deviations are ignored, and the scale falls faster than it rises,
+// so it settles instead of oscillating. Timer results arrive a few frames late, so the samples that
+// follow a change, which may still have been rendered at the old scale, are skipped.
+class ResolutionController {
+public:
+	static constexpr int history_size = 240;
+
+	ResolutionController();
+
+	// Feeds the GPU time in milliseconds of a frame rendered at get_scale().
+	void add_sample(double milliseconds, double budget, float min_scale, float max_scale);
+	// Starts over from scale, e.g. after the controller was switched off.
+	void reset(float scale);
+
+	[[nodiscard]] float get_scale() const;
+	// Smoothed GPU time at the current scale, or 0 before the first sample
+	[[nodiscard]] double get_frame_time() const;
+	// Scale after each sample, oldest first
+	[[nodiscard]] const std::vector<float>& get_history() const;
+
+private:
+	// Samples skipped after a change, one per query of the GpuTimer that measures them
+	static constexpr int settle_samples = 4;
+	static constexpr double smoothing = 0.3;
+	// Relative deviation from the budget that is tolerated
+	static constexpr double dead_band = 0.08;
+	static constexpr float max_decrease = 0.75f;
+	static constexpr float max_increase = 1.1f;
+
+	float scale = 1.0f;
+	double frame_time = 0.0;
+	int samples_to_skip = 0;
+	std::vector<float> history;
+};
@@ -1,41 +1,80 @@
-﻿#include "shader.h"
+﻿#include <algorithm>
+#include <charconv>
+#include <chrono>
 
-Shader::Shader(const std::string& vertex_path, const std::string& fragment_path) {
-	program_id = glCreateProgram();
+#include "shader.h"
 
-	attach_shader(vertex_path, GL_VERTEX_SHADER);
-	attach_shader(fragment_path, GL_FRAGMENT_SHADER);
+// Inserts define_block after the #version line, followed by a #line directive so compiler messages
+// keep the line numbers of the file.
+static std::string insert_defines(const std::string& source, const std::string& define_block) {
+	if (define_block.empty()) return source;
 
-	glLinkProgram(program_id);
+	const size_t version = source.find("#version");
+	const size_t line_end = version == std::string::npos ? std::string::npos : source.find('\n', version);
+	if (line_end == std::string::npos) return define_block + source;
 
-	int success;
-	char info_log[512];
+	const auto next_line = std::count(source.begin(), source.begin() + static_cast<std::ptrdiff_t>(line_end), '\n') + 2;
+	return source.substr(0, line_end + 1) + define_block + "#line " + std::to_string(next_line) + "\n" + source.substr(line_end + 1);
+}
 
-	glGetProgramiv(program_id, GL_LINK_STATUS, &success);
-	if (!success) {
-		glGetProgramInfoLog(program_id, 512, nullptr, info_log);
-		fprintf(stderr, "Error linking shader: %s\n", info_log);
-	}
+Shader::Shader(const std::string& vertex_path, const std::string& fragment_path) :
+	vertex_path(vertex_path),
+	fragment_path(fragment_path),
+	vertex_source(read_file(vertex_path)),
+	fragment_source(read_file(fragment_path)) {
+}
 
-	glValidateProgram(program_id);
-	glGetProgramiv(program_id, GL_VALIDATE_STATUS, &success);
-	if (!success) {
-		glGetProgramInfoLog(program_id, 512, nullptr, info_log);
-		fprintf(stderr, "Error validating shader: %s\n", info_log);
+Shader::Shader(const std::vector<std::string>& compute_paths) {
+	for (size_t i = 0; i < compute_paths.size(); i++) {
+		if (i > 0) {
+			compute_path.append(", ");
+			compute_source.append("\n#line 1 ").append(std::to_string(i)).append("\n");
+		}
+		compute_path.append(compute_paths[i]);
+		compute_source.append(read_file(compute_paths[i]));
 	}
 }
 
 Shader::~Shader() {
-	if (program_id != 0) {
-		glDeleteProgram(program_id);
-		program_id = 0;
+	for (const auto& [define_block, program] : variants) {
+		glDeleteProgram(program);
 	}
+	variants.clear();
+	program_id = 0;
 }
 
-void Shader::bind() {
+void Shader::bind(const ShaderDefines& defines) {
+	// The block is rebuilt in place each call, so once its capacity suffices this does not allocate.
+	define_block.clear();
+	for (const auto& [name, value] : defines) {
+		char number[16];
+		const auto result = std::to_chars(number, number + sizeof(number), value);
+		define_block.append("#define ").append(name).append(" ").append(number, result.ptr).append("\n");
+	}
+
+	auto variant = variants.find(define_block);
+	if (variant == variants.end()) {
+		variant = variants.emplace(define_block, build_variant(define_block)).first;
+	}
+	program_id = variant->second;
+	current_locations = &uniform_locations[program_id];
 	glUseProgram(program_id);
 }
 
+const ShaderBuildStats& Shader::build_stats() const {
+	return stats;
+}
+
+GLint Shader::uniform_location(const std::string_view name) const {
+	const auto cached = current_locations->find(name);
+	if (cached != current_locations->end()) {
+		return cached->second;
+	}
+	const GLint location = glGetUniformLocation(program_id, std::string(name).c_str());
+	current_locations->emplace(name, location);
+	return location;
+}
+
 std::string Shader::read_file(const std::string& path) {
 	std::ifstream file(path);
 	std::string content(
@@ -45,17 +84,87 @@ std::string Shader::read_file(const std::string& path) {
 	return content;
 }
 
-void Shader::attach_shader(const std::string& shader_path, const GLenum shader_type) {
-	const std::string shader_string = read_file(shader_path);
+GLuint Shader::build_variant(const std::string& define_block) {
+	const auto start = std::chrono::steady_clock::now();
 
-	const GLchar* source[1];
-	source[0] = shader_string.c_str();
+	std::vector<std::pair<GLenum, std::string>> stages;
+	if (compute_source.empty()) {
+		stages.emplace_back(GL_VERTEX_SHADER, insert_defines(vertex_source, define_block));
+		stages.emplace_back(GL_FRAGMENT_SHADER, insert_defines(fragment_source, define_block));
+	} else {
+		stages.emplace_back(GL_COMPUTE_SHADER, insert_defines(compute_source, define_block));
+	}
+	std::string sources;
+	for (const auto& [type, source] : stages) {
+		if (!sources.empty()) sources += '\0';
+		sources += source;
+	}
+	const std::string cache_key = program_cache.key(sources);
+
+	GLuint program = glCreateProgram();
+	const bool cached = program_cache.load(program, cache_key);
+	if (!cached) {
+		// A rejected binary leaves the program unusable, so compile into a fresh one.
+		glDeleteProgram(program);
+		program = glCreateProgram();
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		if (compile_and_link(program, stages)) {
+			program_cache.store(program, cache_key);
+		}
+	}
+
+	const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	stats.variant_count++;
+	stats.cached_variant_count += cached ? 1 : 0;
+	stats.total_build_time += elapsed.count();
+	stats.last_build_time = elapsed.count();
+	stats.last_build_cached = cached;
+
+	return program;
+}
+
+bool Shader::compile_and_link(const GLuint program, const std::vector<std::pair<GLenum, std::string>>& stages) {
+	std::vector<GLuint> shaders;
+	for (const auto& [type, source] : stages) {
+		const std::string& path = type == GL_VERTEX_SHADER ? vertex_path : type == GL_FRAGMENT_SHADER ? fragment_path : compute_path;
+		shaders.push_back(attach_shader(program, source, path, type));
+	}
+
+	glLinkProgram(program);
+
+	for (const GLuint shader : shaders) {
+		glDetachShader(program, shader);
+		glDeleteShader(shader);
+	}
+
+	int success;
+	char info_log[512];
+
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success) {
+		glGetProgramInfoLog(program, 512, nullptr, info_log);
+		fprintf(stderr, "Error linking shader: %s\n", info_log);
+		return false;
+	}
+
+	glValidateProgram(program);
+	glGetProgramiv(program, GL_VALIDATE_STATUS, &success);
+	if (!success) {
+		glGetProgramInfoLog(program, 512, nullptr, info_log);
+		fprintf(stderr, "Error validating shader: %s\n", info_log);
+	}
+	return true;
+}
+
+GLuint Shader::attach_shader(const GLuint program, const std::string& source, const std::string& shader_path, const GLenum shader_type) {
+	const GLchar* sources[1];
+	sources[0] = source.c_str();
 
 	GLint source_length[1];
-	source_length[0] = strlen(shader_string.c_str());
+	source_length[0] = static_cast<GLint>(source.size());
 
 	const unsigned int shader = glCreateShader(shader_type);
-	glShaderSource(shader, 1, source, source_length);
+	glShaderSource(shader, 1, sources, source_length);
 	glCompileShader(shader);
 
 	int success;
@@ -67,37 +176,42 @@ void Shader::attach_shader(const std::string& shader_path, const GLenum shader_t
 		fprintf(stderr, "Shader path: %s\n", shader_path.c_str());
 	}
 
-	glAttachShader(program_id, shader);
+	glAttachShader(program, shader);
+	return shader;
+}
+
+void Shader::set_uniform_1i(const std::string_view name, const int x) const {
+	glUniform1i(uniform_location(name), x);
 }
 
-void Shader::set_uniform_1i(const std::string& name, const int x) const {
-	glUniform1i(glGetUniformLocation(program_id, name.c_str()), x);
+void Shader::set_uniform_2i(const std::string_view name, const int x, const int y) const {
+	glUniform2i(uniform_location(name), x, y);
 }
 
-void Shader::set_uniform_1f(const std::string& name, const float x) const {
-	glUniform1f(glGetUniformLocation(program_id, name.c_str()), x);
+void Shader::set_uniform_1f(const std::string_view name, const float x) const {
+	glUniform1f(uniform_location(name), x);
 }
 
-void Shader::set_uniform_2f(const std::string& name, const float x, const float y) const {
-	glUniform2f(glGetUniformLocation(program_id, name.c_str()), x, y);
+void Shader::set_uniform_2f(const std::string_view name, const float x, const float y) const {
+	glUniform2f(uniform_location(name), x, y);
 }
 
-void Shader::set_uniform_1d(const std::string& name, const double x) const {
-	glUniform1d(glGetUniformLocation(program_id, name.c_str()), x);
+void Shader::set_uniform_1d(const std::string_view name, const double x) const {
+	glUniform1d(uniform_location(name), x);
 }
 
-void Shader::set_uniform_2d(const std::string& name, const double x, const double y) const {
-	glUniform2d(glGetUniformLocation(program_id, name.c_str()), x, y);
+void Shader::set_uniform_2d(const std::string_view name, const double x, const double y) const {
+	glUniform2d(uniform_location(name), x, y);
 }
 
-void Shader::set_uniform_vec3(const std::string& name, const glm::vec3 vec) const {
-	glUniform3f(glGetUniformLocation(program_id, name.c_str()), vec.x, vec.y, vec.z);
+void Shader::set_uniform_vec3(const std::string_view name, const glm::vec3 vec) const {
+	glUniform3f(uniform_location(name), vec.x, vec.y, vec.z);
 }
 
-void Shader::set_uniform_vec4(const std::string& name, const glm::vec4 vec) const {
-	glUniform4f(glGetUniformLocation(program_id, name.c_str()), vec.x, vec.y, vec.z, vec.w);
+void Shader::set_uniform_vec4(const std::string_view name, const glm::vec4 vec) const {
+	glUniform4f(uniform_location(name), vec.x, vec.y, vec.z, vec.w);
 }
 
-void Shader::set_uniform_mat4(const std::string& name, glm::mat4 mat) const {
-	glUniformMatrix4fv(glGetUniformLocation(program_id, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+void Shader::set_uniform_mat4(const std::string_view name, glm::mat4 mat) const {
+	glUniformMatrix4fv(uniform_location(name), 1, GL_FALSE, glm::value_ptr(mat));
 }
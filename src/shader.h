@@ -3,31 +3,84 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GL/gl.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "program_cache.h"
+
+// Preprocessor definitions that select a variant of a shader, e.g. {{"APPLY_NOISE", 1}}.
+using ShaderDefines = std::vector<std::pair<std::string_view, int>>;
+
+// Lets unordered_map<std::string, ...> be searched with a std::string_view without a temporary string.
+struct StringHash {
+	using is_transparent = void;
+
+	size_t operator()(const std::string_view s) const {
+		return std::hash<std::string_view>{}(s);
+	}
+};
+
+struct ShaderBuildStats {
+	int variant_count = 0;
+	int cached_variant_count = 0;
+	double total_build_time = 0.0; // milliseconds
+	double last_build_time = 0.0; // milliseconds
+	bool last_build_cached = false;
+};
+
 class Shader {
 public:
-	GLuint program_id;
+	// Program of the variant selected by the last bind().
+	GLuint program_id = 0;
 
 	Shader(const std::string& vertex_path, const std::string& fragment_path);
+	// Compute program of the files at compute_paths joined in order, the first of which has the
+	// #version line. Compiler messages give the index of the file as the source string number.
+	explicit Shader(const std::vector<std::string>& compute_paths);
 	~Shader();
 
-	void bind();
+	// Binds the variant built with defines inserted after the #version line of each stage. Each
+	// variant is built on first use, from the program binary cache if it has an entry.
+	void bind(const ShaderDefines& defines = {});
+	[[nodiscard]] const ShaderBuildStats& build_stats() const;
 
-	void set_uniform_1i(const std::string& name, int x) const;
-	void set_uniform_1f(const std::string& name, float x) const;
-	void set_uniform_2f(const std::string& name, float x, float y) const;
-	void set_uniform_1d(const std::string& name, double x) const;
-	void set_uniform_2d(const std::string& name, double x, double y) const;
-	void set_uniform_vec3(const std::string& name, glm::vec3 vec) const;
-	void set_uniform_vec4(const std::string& name, glm::vec4 vec) const;
-	void set_uniform_mat4(const std::string& name, glm::mat4 mat) const;
+	void set_uniform_1i(std::string_view name, int x) const;
+	void set_uniform_2i(std::string_view name, int x, int y) const;
+	void set_uniform_1f(std::string_view name, float x) const;
+	void set_uniform_2f(std::string_view name, float x, float y) const;
+	void set_uniform_1d(std::string_view name, double x) const;
+	void set_uniform_2d(std::string_view name, double x, double y) const;
+	void set_uniform_vec3(std::string_view name, glm::vec3 vec) const;
+	void set_uniform_vec4(std::string_view name, glm::vec4 vec) const;
+	void set_uniform_mat4(std::string_view name, glm::mat4 mat) const;
 
 private:
+	std::string vertex_path;
+	std::string fragment_path;
+	std::string vertex_source;
+	std::string fragment_source;
+	// Empty for vertex and fragment programs
+	std::string compute_path;
+	std::string compute_source;
+	ProgramCache program_cache;
+	std::unordered_map<std::string, GLuint, StringHash, std::equal_to<>> variants;
+	// Uniform locations of the bound variant, resolved on first use.
+	std::unordered_map<GLuint, std::unordered_map<std::string, GLint, StringHash, std::equal_to<>>> uniform_locations;
+	std::unordered_map<std::string, GLint, StringHash, std::equal_to<>>* current_locations = nullptr;
+	std::string define_block;
+	ShaderBuildStats stats;
+
 	std::string read_file(const std::string& path);
-	void attach_shader(const std::string& shader_path, GLenum shader_type);
+	GLint uniform_location(std::string_view name) const;
+	GLuint build_variant(const std::string& define_block);
+	// Compiles each stage of type and source into program and links it
+	bool compile_and_link(GLuint program, const std::vector<std::pair<GLenum, std::string>>& stages);
+	GLuint attach_shader(GLuint program, const std::string& source, const std::string& shader_path, GLenum shader_type);
 };
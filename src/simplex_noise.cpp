@@ -0,0 +1,156 @@
+/*
+MIT License for Simplex noise implementation by Ian McEwan and Ashima Arts:
+https://github.com/ashima/webgl-noise/blob/master/LICENSE
+
+Copyright (C) 2011 by Ashima Arts (Simplex noise)
+Copyright (C) 2011-2016 by Stefan Gustavson (Classic noise and others)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// The following code is a C++ port of the GLSL Simplex noise implementation by Ian McEwan and Ashima Arts.
+
+#include "simplex_noise.h"
+
+static glm::vec3 mod289(const glm::vec3 x) {
+	return x - glm::floor(x * (1.0f / 289.0f)) * 289.0f;
+}
+
+static glm::vec4 mod289(const glm::vec4 x) {
+	return x - glm::floor(x * (1.0f / 289.0f)) * 289.0f;
+}
+
+static glm::vec4 permute(const glm::vec4 x) {
+	return mod289(((x * 34.0f) + 10.0f) * x);
+}
+
+static glm::vec4 taylor_inv_sqrt(const glm::vec4 r) {
+	return 1.79284291400159f - 0.85373472095314f * r;
+}
+
+// Simplex containing a point: the lattice coordinates of its first corner, the offsets of the
+// second and third corners from it, and the offsets of the point from all four corners.
+struct SimplexCell {
+	glm::vec3 i;
+	glm::vec3 i1;
+	glm::vec3 i2;
+	glm::vec3 x0;
+	glm::vec3 x1;
+	glm::vec3 x2;
+	glm::vec3 x3;
+};
+
+static SimplexCell simplex_cell(const glm::vec3 v) {
+	const glm::vec2 C(1.0f / 6.0f, 1.0f / 3.0f);
+	const glm::vec4 D(0.0f, 0.5f, 1.0f, 2.0f);
+	SimplexCell cell;
+
+	// First corner
+	cell.i = glm::floor(v + glm::dot(v, glm::vec3(C.y)));
+	cell.x0 = v - cell.i + glm::dot(cell.i, glm::vec3(C.x));
+
+	// Other corners
+	const glm::vec3 g = glm::step(glm::vec3(cell.x0.y, cell.x0.z, cell.x0.x), cell.x0);
+	const glm::vec3 l = 1.0f - g;
+	cell.i1 = glm::min(g, glm::vec3(l.z, l.x, l.y));
+	cell.i2 = glm::max(g, glm::vec3(l.z, l.x, l.y));
+
+	cell.x1 = cell.x0 - cell.i1 + C.x;
+	cell.x2 = cell.x0 - cell.i2 + C.y; // 2.0*C.x = 1/3 = C.y
+	cell.x3 = cell.x0 - D.y;           // -1.0+3.0*C.x = -0.5 = -D.y
+	return cell;
+}
+
+// Noise of the cell from the permuted hashes p of its four corners
+static float simplex_gradients(const SimplexCell& cell, const glm::vec4 p) {
+	const glm::vec4 D(0.0f, 0.5f, 1.0f, 2.0f);
+	const glm::vec3 x0 = cell.x0;
+	const glm::vec3 x1 = cell.x1;
+	const glm::vec3 x2 = cell.x2;
+	const glm::vec3 x3 = cell.x3;
+
+	// Gradients: 7x7 points over a square, mapped onto an octahedron.
+	// The ring size 17*17 = 289 is close to a multiple of 49 (49*6 = 294)
+	constexpr float n_ = 0.142857142857f; // 1.0/7.0
+	const glm::vec3 ns = n_ * glm::vec3(D.w, D.y, D.z) - glm::vec3(D.x, D.z, D.x);
+
+	const glm::vec4 j = p - 49.0f * glm::floor(p * ns.z * ns.z); // mod(p,7*7)
+
+	const glm::vec4 x_ = glm::floor(j * ns.z);
+	const glm::vec4 y_ = glm::floor(j - 7.0f * x_); // mod(j,N)
+
+	const glm::vec4 x = x_ * ns.x + ns.y;
+	const glm::vec4 y = y_ * ns.x + ns.y;
+	const glm::vec4 h = 1.0f - glm::abs(x) - glm::abs(y);
+
+	const glm::vec4 b0(x.x, x.y, y.x, y.y);
+	const glm::vec4 b1(x.z, x.w, y.z, y.w);
+
+	const glm::vec4 s0 = glm::floor(b0) * 2.0f + 1.0f;
+	const glm::vec4 s1 = glm::floor(b1) * 2.0f + 1.0f;
+	const glm::vec4 sh = -glm::step(h, glm::vec4(0.0f));
+
+	const glm::vec4 a0 = glm::vec4(b0.x, b0.z, b0.y, b0.w) + glm::vec4(s0.x, s0.z, s0.y, s0.w) * glm::vec4(sh.x, sh.x, sh.y, sh.y);
+	const glm::vec4 a1 = glm::vec4(b1.x, b1.z, b1.y, b1.w) + glm::vec4(s1.x, s1.z, s1.y, s1.w) * glm::vec4(sh.z, sh.z, sh.w, sh.w);
+
+	glm::vec3 p0(a0.x, a0.y, h.x);
+	glm::vec3 p1(a0.z, a0.w, h.y);
+	glm::vec3 p2(a1.x, a1.y, h.z);
+	glm::vec3 p3(a1.z, a1.w, h.w);
+
+	// Normalise gradients
+	const glm::vec4 norm = taylor_inv_sqrt(glm::vec4(glm::dot(p0, p0), glm::dot(p1, p1), glm::dot(p2, p2), glm::dot(p3, p3)));
+	p0 *= norm.x;
+	p1 *= norm.y;
+	p2 *= norm.z;
+	p3 *= norm.w;
+
+	// Mix final noise value
+	glm::vec4 m = glm::max(0.5f - glm::vec4(glm::dot(x0, x0), glm::dot(x1, x1), glm::dot(x2, x2), glm::dot(x3, x3)), glm::vec4(0.0f));
+	m = m * m;
+	return 105.0f * glm::dot(m * m, glm::vec4(glm::dot(p0, x0), glm::dot(p1, x1), glm::dot(p2, x2), glm::dot(p3, x3)));
+}
+
+float snoise(const glm::vec3 v) {
+	const SimplexCell cell = simplex_cell(v);
+
+	// Permutations
+	const glm::vec3 i = mod289(cell.i);
+	const glm::vec4 p = permute(permute(permute(
+			  i.z + glm::vec4(0.0f, cell.i1.z, cell.i2.z, 1.0f))
+			+ i.y + glm::vec4(0.0f, cell.i1.y, cell.i2.y, 1.0f))
+			+ i.x + glm::vec4(0.0f, cell.i1.x, cell.i2.x, 1.0f));
+	return simplex_gradients(cell, p);
+}
+
+float periodic_snoise(const glm::vec3 v, const int period) {
+	const SimplexCell cell = simplex_cell(v);
+
+	// Permutations of the corners wrapped into [0, period) along each lattice axis
+	const float wrap = static_cast<float>(period);
+	const auto corners = [&](const float first, const float second, const float third) {
+		const glm::vec4 c = first + glm::vec4(0.0f, second, third, 1.0f);
+		return c - glm::floor(c / wrap) * wrap;
+	};
+	const glm::vec4 p = permute(permute(permute(
+			  corners(cell.i.z, cell.i1.z, cell.i2.z))
+			+ corners(cell.i.y, cell.i1.y, cell.i2.y))
+			+ corners(cell.i.x, cell.i1.x, cell.i2.x));
+	return simplex_gradients(cell, p);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// CPU port of snoise() from shaders/shader.frag.
+float snoise(glm::vec3 v);
+// snoise() with the lattice wrapped every period cells along each of its axes, which are skewed
+// against x, y and z. It repeats every 3 * period units along x, y and z, and is equal to snoise()
+// where all corners of the simplex lie within the first period.
+float periodic_snoise(glm::vec3 v, int period);
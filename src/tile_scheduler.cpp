@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <thread>
+
+#include "tile_scheduler.h"
+
+namespace {
+
+// A worker's deque of tiles is the run of task indices from begin to end, packed into one word so
+// that the owner and thieves can both take from it with a compare-exchange. Tasks only ever leave
+// a deque, so a packed value never repeats and the exchange cannot mistake one deque state for another.
+struct alignas(64) WorkerDeque {
+	std::atomic<uint64_t> range{0};
+};
+
+uint64_t pack_range(const int begin, const int end) {
+	return static_cast<uint64_t>(static_cast<uint32_t>(end)) << 32 | static_cast<uint32_t>(begin);
+}
+
+int range_begin(const uint64_t range) {
+	return static_cast<int>(static_cast<uint32_t>(range));
+}
+
+int range_end(const uint64_t range) {
+	return static_cast<int>(range >> 32);
+}
+
+// Takes the task at the front of the deque
+bool pop_front(WorkerDeque& deque, int& task) {
+	uint64_t range = deque.range.load();
+	while (range_begin(range) < range_end(range)) {
+		if (deque.range.compare_exchange_weak(range, pack_range(range_begin(range) + 1, range_end(range)))) {
+			task = range_begin(range);
+			return true;
+		}
+	}
+	return false;
+}
+
+// Takes the back half of the deque, rounded up, as the run of tasks from begin to end
+bool steal_back(WorkerDeque& deque, int& begin, int& end) {
+	uint64_t range = deque.range.load();
+	while (range_begin(range) < range_end(range)) {
+		const int count = (range_end(range) - range_begin(range) + 1) / 2;
+		if (deque.range.compare_exchange_weak(range, pack_range(range_begin(range), range_end(range) - count))) {
+			begin = range_end(range) - count;
+			end = range_end(range);
+			return true;
+		}
+	}
+	return false;
+}
+
+// Interleaves the bits of x and y, so that sorting by the code visits a grid in Morton order
+uint32_t morton_code(const int x, const int y) {
+	auto spread = [](uint32_t v) {
+		v &= 0xffff;
+		v = (v | v << 8) & 0x00ff00ff;
+		v = (v | v << 4) & 0x0f0f0f0f;
+		v = (v | v << 2) & 0x33333333;
+		v = (v | v << 1) & 0x55555555;
+		return v;
+	};
+	return spread(static_cast<uint32_t>(x)) | spread(static_cast<uint32_t>(y)) << 1;
+}
+
+// Pixels of tile inside region
+double clipped_pixels(const ImageRegion& region, const Tile& tile) {
+	const int width = std::clamp(region.x + region.width - tile.x, 0, tile.size);
+	const int height = std::clamp(region.y + region.height - tile.y, 0, tile.size);
+	return static_cast<double>(width) * height;
+}
+
+bool same_region(const ImageRegion& a, const ImageRegion& b) {
+	return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+}
+
+TileScheduler::TileScheduler(const int tile_size) : tile_size(tile_size) {
+
+}
+
+void TileScheduler::plan(const int width, const int height, const ImageRegion& region, const unsigned int thread_count) {
+	const int tiles_x = (region.width + tile_size - 1) / tile_size;
+	const int tiles_y = (region.height + tile_size - 1) / tile_size;
+	const int base_count = tiles_x * tiles_y;
+
+	std::vector<int> order(base_count);
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [tiles_x](const int a, const int b) {
+		return morton_code(a % tiles_x, a / tiles_x) < morton_code(b % tiles_x, b / tiles_x);
+	});
+
+	auto base_tile = [&](const int index) {
+		return Tile{region.x + (index % tiles_x) * tile_size, region.y + (index / tiles_x) * tile_size, tile_size};
+	};
+	auto base_cost = [&](const int index) {
+		return planned_from_history ? base_tile_costs[index] : clipped_pixels(region, base_tile(index));
+	};
+
+	planned_from_history = width == cost_width && height == cost_height && same_region(region, cost_region)
+		&& static_cast<int>(base_tile_costs.size()) == base_count;
+	double total_cost = 0.0;
+	for (int index = 0; index < base_count; index++) {
+		total_cost += base_cost(index);
+	}
+	const double max_cost = total_cost / (static_cast<double>(thread_count) * tiles_per_worker);
+
+	tasks.clear();
+	for (const int index : order) {
+		add_task(region, base_tile(index), base_cost(index), index, max_cost);
+	}
+}
+
+void TileScheduler::add_task(const ImageRegion& region, const Tile& tile, const double cost, const int base_tile, const double max_cost) {
+	const int half = tile.size / 2;
+	if (cost <= max_cost || half < min_tile_size || tile.size % 2 != 0) {
+		tasks.push_back(Task{tile, cost, base_tile});
+		return;
+	}
+
+	// Quarters in Morton order, sharing the cost by their pixels in the region
+	const double pixels = clipped_pixels(region, tile);
+	for (int quarter = 0; quarter < 4; quarter++) {
+		const Tile child{tile.x + (quarter % 2) * half, tile.y + (quarter / 2) * half, half};
+		const double child_pixels = clipped_pixels(region, child);
+		if (child_pixels > 0.0) {
+			add_task(region, child, cost * child_pixels / pixels, base_tile, max_cost);
+		}
+	}
+}
+
+void TileScheduler::run(const int width, const int height, const ImageRegion& region, const unsigned int thread_count,
+	const std::function<void(unsigned int worker, const Tile& tile)>& render_tile) {
+	plan(width, height, region, thread_count);
+	const int task_count = static_cast<int>(tasks.size());
+
+	// Contiguous runs of about equal predicted cost
+	const std::unique_ptr<WorkerDeque[]> deques(new WorkerDeque[thread_count]);
+	double total_cost = 0.0;
+	for (const Task& task : tasks) {
+		total_cost += task.cost;
+	}
+	int begin = 0;
+	double cost = 0.0;
+	for (unsigned int worker = 0; worker < thread_count; worker++) {
+		const double limit = total_cost * (worker + 1) / thread_count;
+		int end = begin;
+		while (end < task_count && (worker + 1 == thread_count || cost + 0.5 * tasks[end].cost < limit)) {
+			cost += tasks[end++].cost;
+		}
+		deques[worker].range = pack_range(begin, end);
+		begin = end;
+	}
+
+	std::vector<double> task_seconds(task_count);
+	last_stats.assign(thread_count, TileWorkerStats{});
+	// Tasks that no worker has taken yet. Workers keep looking for tasks to steal until it is zero,
+	// since a run of stolen tasks is out of every deque until the thief stores it in its own.
+	std::atomic<int> unclaimed = task_count;
+
+	auto worker = [&](const unsigned int index) {
+		TileWorkerStats stats;
+		unsigned int victim = index;
+		int task;
+		while (true) {
+			if (!pop_front(deques[index], task)) {
+				if (unclaimed == 0) {
+					break;
+				}
+				// Starts with the last worker stolen from, whose deque now ends where the stolen run began
+				int stolen_begin = 0;
+				int stolen_end = 0;
+				bool stolen = false;
+				for (unsigned int i = 0; i < thread_count && !stolen; i++) {
+					const unsigned int candidate = (victim + i) % thread_count;
+					if (candidate != index && steal_back(deques[candidate], stolen_begin, stolen_end)) {
+						victim = candidate;
+						stolen = true;
+					}
+				}
+				if (!stolen) {
+					std::this_thread::yield();
+					continue;
+				}
+				stats.steals++;
+				stats.stolen_tiles += stolen_end - stolen_begin;
+				deques[index].range = pack_range(stolen_begin, stolen_end);
+				continue;
+			}
+			unclaimed--;
+
+			const auto start = std::chrono::steady_clock::now();
+			render_tile(index, tasks[task].tile);
+			const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			task_seconds[task] = elapsed.count();
+			stats.busy_seconds += elapsed.count();
+			stats.tiles++;
+		}
+		last_stats[index] = stats;
+	};
+
+	const auto start_time = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (unsigned int i = 1; i < thread_count; i++) {
+		workers.emplace_back(worker, i);
+	}
+	worker(0);
+	for (std::thread& thread : workers) {
+		thread.join();
+	}
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+
+	for (TileWorkerStats& stats : last_stats) {
+		stats.utilization = stats.busy_seconds / std::max(elapsed.count(), 1e-9);
+	}
+
+	// Costs for planning the next run of the same region
+	const int tiles_x = (region.width + tile_size - 1) / tile_size;
+	const int tiles_y = (region.height + tile_size - 1) / tile_size;
+	base_tile_costs.assign(static_cast<size_t>(tiles_x) * tiles_y, 0.0);
+	for (int i = 0; i < task_count; i++) {
+		base_tile_costs[tasks[i].base_tile] += task_seconds[i];
+	}
+	cost_width = width;
+	cost_height = height;
+	cost_region = region;
+}
+
+const std::vector<TileWorkerStats>& TileScheduler::worker_stats() const {
+	return last_stats;
+}
+
+int TileScheduler::get_tile_count() const {
+	return static_cast<int>(tasks.size());
+}
+
+bool TileScheduler::used_cost_history() const {
+	return planned_from_history;
+}
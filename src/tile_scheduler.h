@@ -0,0 +1,78 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "image_writer.h"
+
+// Square tile in top-down image coordinates. Tiles on the right and bottom edges of a region are
+// clipped to it.
+struct Tile {
+	int x = 0;
+	int y = 0;
+	int size = 0;
+};
+
+struct TileWorkerStats {
+	// Time spent rendering tiles, and its share of the frame
+	double busy_seconds = 0.0;
+	double utilization = 0.0;
+	int tiles = 0;
+	// Tiles taken from other workers' deques, counting a tile again each time it is stolen on, and
+	// the number of steals that took them
+	int stolen_tiles = 0;
+	int steals = 0;
+};
+
+// Distributes the tiles of a region over worker threads. The region is split into square base
+// tiles, which are visited in Morton order so that consecutive tiles are close together. A base
+// tile that cost more than its share of the frame is subdivided into quarters, down to
+// min_tile_size, so that no single tile holds back the end of the frame. Costs are the render
+// times measured in the previous frame of the same region, or pixel counts without one.
+//
+// Each worker starts with a contiguous run of tiles of about equal cost as its deque. It renders
+// tiles from the front of its own deque and, once that is empty, steals the back half of another
+// worker's, which is a contiguous run of tiles too.
+class TileScheduler {
+public:
+	static constexpr int min_tile_size = 8;
+	// Tiles planned per worker, so that stealing can even out the costs that were mispredicted
+	static constexpr int tiles_per_worker = 16;
+
+	explicit TileScheduler(int tile_size);
+
+	// Calls render_tile(worker, tile) for every tile of region in a width x height image, on
+	// thread_count threads including the calling thread, and returns when all tiles are rendered.
+	// worker is the index of the calling thread, from 0 to thread_count - 1.
+	void run(int width, int height, const ImageRegion& region, unsigned int thread_count,
+		const std::function<void(unsigned int worker, const Tile& tile)>& render_tile);
+
+	// Statistics of the last run, one entry per thread
+	[[nodiscard]] const std::vector<TileWorkerStats>& worker_stats() const;
+	[[nodiscard]] int get_tile_count() const;
+	// Whether the last run planned its tiles from the costs of the run before it
+	[[nodiscard]] bool used_cost_history() const;
+
+private:
+	struct Task {
+		Tile tile;
+		// Predicted cost, in the units of the base tile costs it was planned from
+		double cost;
+		// Base tile that contains the tile
+		int base_tile;
+	};
+
+	void plan(int width, int height, const ImageRegion& region, unsigned int thread_count);
+	void add_task(const ImageRegion& region, const Tile& tile, double cost, int base_tile, double max_cost);
+
+	int tile_size;
+	std::vector<Task> tasks;
+	std::vector<TileWorkerStats> last_stats;
+	bool planned_from_history = false;
+
+	// Render seconds of each base tile of cost_region in the last run, in row order
+	std::vector<double> base_tile_costs;
+	int cost_width = 0;
+	int cost_height = 0;
+	ImageRegion cost_region;
+};
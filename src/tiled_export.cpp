@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "tiled_export.h"
+
+TiledExport::TiledExport(const int width, const int height, const int tile_size)
+	: width(width),
+	  height(height),
+	  tile_size(tile_size),
+	  tiles_x((width + tile_size - 1) / tile_size),
+	  tiles_y((height + tile_size - 1) / tile_size) {
+
+}
+
+bool TiledExport::open(const std::string& path) {
+	this->path = path;
+	tiles_done = 0;
+	strip.assign(static_cast<size_t>(width) * std::min(tile_size, height) * 3, 0);
+	start_time = std::chrono::steady_clock::now();
+	return writer.open(path, width, height);
+}
+
+bool TiledExport::add_tile(const unsigned char* pixels, const int channels, const bool bottom_up) {
+	if (is_done() || !writer.is_open()) {
+		return false;
+	}
+	const ImageRegion tile = get_tile(tiles_done);
+	const size_t strip_row_size = static_cast<size_t>(width) * 3;
+	for (int row = 0; row < tile.height; row++) {
+		const int source_row = bottom_up ? tile.height - 1 - row : row;
+		const unsigned char* source = pixels + static_cast<size_t>(source_row) * tile.width * channels;
+		unsigned char* destination = &strip[row * strip_row_size + static_cast<size_t>(tile.x) * 3];
+		for (int column = 0; column < tile.width; column++) {
+			destination[column * 3] = source[column * channels];
+			destination[column * 3 + 1] = source[column * channels + 1];
+			destination[column * 3 + 2] = source[column * channels + 2];
+		}
+	}
+	tiles_done++;
+
+	// Last tile of its row
+	if (tile.x + tile.width == width) {
+		return writer.write_rows(strip.data(), tile.height);
+	}
+	return true;
+}
+
+bool TiledExport::finish() {
+	if (!writer.is_open()) {
+		return false;
+	}
+	if (!is_done()) {
+		fprintf(stderr, "Export of %s cancelled after %d of %d tiles\n", path.c_str(), tiles_done, get_tile_count());
+	}
+	return writer.close() && is_done();
+}
+
+ImageRegion TiledExport::get_tile(const int index) const {
+	const int x = (index % tiles_x) * tile_size;
+	const int y = (index / tiles_x) * tile_size;
+	return {x, y, std::min(tile_size, width - x), std::min(tile_size, height - y)};
+}
+
+int TiledExport::get_tile_count() const {
+	return tiles_x * tiles_y;
+}
+
+int TiledExport::get_tiles_done() const {
+	return tiles_done;
+}
+
+bool TiledExport::is_done() const {
+	return tiles_done == get_tile_count();
+}
+
+ExportProgress TiledExport::get_progress() const {
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+	ExportProgress progress;
+	progress.tiles_done = tiles_done;
+	progress.tile_count = get_tile_count();
+	progress.seconds = elapsed.count();
+	progress.tiles_per_second = tiles_done / std::max(elapsed.count(), 1e-9);
+	return progress;
+}
+
+int TiledExport::get_width() const {
+	return width;
+}
+
+int TiledExport::get_height() const {
+	return height;
+}
+
+const std::string& TiledExport::get_path() const {
+	return path;
+}
+
+glm::mat4 tile_projection(const glm::mat4& projection_matrix, const int width, const int height, const ImageRegion& tile) {
+	// Bounds of the tile in normalized device coordinates, where y points up
+	const float left = 2.0f * static_cast<float>(tile.x) / static_cast<float>(width) - 1.0f;
+	const float right = 2.0f * static_cast<float>(tile.x + tile.width) / static_cast<float>(width) - 1.0f;
+	const float bottom = 1.0f - 2.0f * static_cast<float>(tile.y + tile.height) / static_cast<float>(height);
+	const float top = 1.0f - 2.0f * static_cast<float>(tile.y) / static_cast<float>(height);
+
+	// Scales and translates clip space so the tile covers [-1, 1] on both axes
+	glm::mat4 crop(1.0f);
+	crop[0][0] = 2.0f / (right - left);
+	crop[1][1] = 2.0f / (top - bottom);
+	crop[3][0] = -(right + left) / (right - left);
+	crop[3][1] = -(top + bottom) / (top - bottom);
+	return crop * projection_matrix;
+}
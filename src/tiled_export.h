@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "image_writer.h"
+
+constexpr int default_export_tile_size = 512;
+
+struct ExportProgress {
+	int tiles_done = 0;
+	int tile_count = 0;
+	double seconds = 0.0;
+	double tiles_per_second = 0.0;
+};
+
+// Assembles an image of any size from tiles and streams it into an ImageStreamWriter. Tiles are
+// numbered row by row from the top left and must be added in that order. Each row of tiles is
+// written out as soon as its last tile arrives, so memory stays at one row of tiles however tall
+// the image is.
+class TiledExport {
+public:
+	TiledExport(int width, int height, int tile_size);
+
+	bool open(const std::string& path);
+	// Adds the next tile as 8-bit rows of channels (3 or 4) components, of which the first three
+	// are RGB. OpenGL reads pixels back bottom-up.
+	bool add_tile(const unsigned char* pixels, int channels, bool bottom_up);
+	// Closes the file, which fails unless every tile was added.
+	bool finish();
+
+	[[nodiscard]] ImageRegion get_tile(int index) const;
+	[[nodiscard]] int get_tile_count() const;
+	[[nodiscard]] int get_tiles_done() const;
+	[[nodiscard]] bool is_done() const;
+	[[nodiscard]] ExportProgress get_progress() const;
+	[[nodiscard]] int get_width() const;
+	[[nodiscard]] int get_height() const;
+	[[nodiscard]] const std::string& get_path() const;
+
+private:
+	int width;
+	int height;
+	int tile_size;
+	int tiles_x;
+	int tiles_y;
+	int tiles_done = 0;
+	std::string path;
+	ImageStreamWriter writer;
+	// The current row of tiles, as top-down RGB rows of the full image width
+	std::vector<unsigned char> strip;
+	std::chrono::steady_clock::time_point start_time;
+};
+
+// Returns the projection that renders tile of a width x height image, drawn with projection_matrix,
+// into a viewport the size of the tile.
+[[nodiscard]] glm::mat4 tile_projection(const glm::mat4& projection_matrix, int width, int height, const ImageRegion& tile);
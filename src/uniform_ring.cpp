@@ -0,0 +1,62 @@
+#include <cstring>
+
+#include "uniform_ring.h"
+
+UniformRing::UniformRing(const GLuint binding, const size_t size, const int slot_count) :
+	binding(binding),
+	size(size),
+	slot_count(slot_count),
+	fences(slot_count, nullptr),
+	last_data(size) {
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	stride = (size + alignment - 1) / alignment * alignment;
+
+	constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferStorage(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(stride * slot_count), nullptr, flags);
+	mapped = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, static_cast<GLsizeiptr>(stride * slot_count), flags));
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+UniformRing::~UniformRing() {
+	for (const GLsync fence : fences) {
+		if (fence) glDeleteSync(fence);
+	}
+	if (buffer != 0) {
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		glDeleteBuffers(1, &buffer);
+	}
+}
+
+bool UniformRing::update(const void* data) {
+	// Compare against a CPU copy; reading back mapped memory can be uncached and slow.
+	if (current_slot >= 0 && std::memcmp(last_data.data(), data, size) == 0) {
+		return false;
+	}
+	std::memcpy(last_data.data(), data, size);
+
+	// Draws already submitted may still read the current slot, so fence it before moving on.
+	if (current_slot >= 0) {
+		fences[current_slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	current_slot = (current_slot + 1) % slot_count;
+
+	if (GLsync& fence = fences[current_slot]) {
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	std::memcpy(mapped + current_slot * stride, data, size);
+	glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, static_cast<GLintptr>(current_slot * stride), static_cast<GLsizeiptr>(size));
+	upload_count++;
+	return true;
+}
+
+unsigned long long UniformRing::get_upload_count() const {
+	return upload_count;
+}
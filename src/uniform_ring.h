@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Persistently mapped ring of uniform block copies bound to one binding point. update() writes a
+// new copy only when the data differs from the current one. Each slot gets a fence when the ring
+// moves past it, so a copy is never overwritten while draws that read it may still be in flight.
+class UniformRing {
+public:
+	static constexpr int default_slot_count = 3;
+
+	UniformRing(GLuint binding, size_t size, int slot_count = default_slot_count);
+	~UniformRing();
+
+	UniformRing(const UniformRing&) = delete;
+	UniformRing& operator=(const UniformRing&) = delete;
+
+	// Uploads and binds data if it changed since the last call. Returns whether it uploaded.
+	bool update(const void* data);
+	[[nodiscard]] unsigned long long get_upload_count() const;
+
+private:
+	GLuint buffer = 0;
+	GLuint binding;
+	size_t size;
+	size_t stride;
+	int slot_count;
+	int current_slot = -1;
+	unsigned char* mapped = nullptr;
+	std::vector<GLsync> fences;
+	std::vector<unsigned char> last_data;
+	unsigned long long upload_count = 0;
+};
@@ -7,7 +7,7 @@ void Window::glfw_error_callback(int error, const char* description) {
 	fprintf(stderr, "GLFW Error %d: %s\n", error, description);
 }
 
-Window::Window(const std::string& title, int width, int height) {
+Window::Window(const std::string& title, int width, int height, const bool visible) {
 	glfwSetErrorCallback(glfw_error_callback);
 	if (!glfwInit()) {
 		throw std::exception("Error initializing GLFW.");
@@ -16,6 +16,7 @@ Window::Window(const std::string& title, int width, int height) {
 	// Set OpenGL version
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
 
 	if (width == 0 || height == 0) {
 		GLFWmonitor* monitor = glfwGetPrimaryMonitor();
@@ -57,13 +58,22 @@ void Window::update() const {
 	glfwPollEvents();
 }
 
-void Window::update_viewport(const int x_offset) const {
+void Window::update_viewport(const int x_offset) {
 	int display_w, display_h;
 	glfwGetFramebufferSize(glfw_window, &display_w, &display_h);
+	if (display_w <= 0 || display_h <= 0) {
+		viewport = Viewport();
+		return;
+	}
 	const int available_width = display_w - x_offset;
 	const GLfloat screen_ratio = static_cast<GLfloat>(display_w) / static_cast<GLfloat>(display_h);
 	const int viewport_height = static_cast<int>(static_cast<float>(available_width) / screen_ratio);
-	glViewport(x_offset, (display_h - viewport_height) / 2, available_width, viewport_height);
+	viewport = {x_offset, (display_h - viewport_height) / 2, available_width, viewport_height};
+	glViewport(viewport.x, viewport.y, viewport.width, viewport.height);
+}
+
+const Viewport& Window::get_viewport() const {
+	return viewport;
 }
 
 void Window::toggle_fullscreen() {
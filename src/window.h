@@ -4,22 +4,33 @@
 
 #include <GLFW/glfw3.h>
 
+// Rectangle of the default framebuffer the fractal is drawn into, in pixels.
+struct Viewport {
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+};
+
 class Window {
 public:
 	static constexpr float default_window_scale = 0.75f;
 
 	GLFWwindow* glfw_window;
 
-	Window(const std::string& title, int width = 0, int height = 0);
+	// A hidden window only provides the OpenGL context, for rendering offscreen.
+	Window(const std::string& title, int width = 0, int height = 0, bool visible = true);
 	~Window();
 
 	[[nodiscard]] bool should_close() const;
 	void update() const;
-	void update_viewport(int x_offset = 0) const;
+	void update_viewport(int x_offset = 0);
+	[[nodiscard]] const Viewport& get_viewport() const;
 	void toggle_fullscreen();
 
 private:
 	bool is_fullscreen = false;
+	Viewport viewport;
 	int last_windowed_width = 1280;
     int last_windowed_height = 720;
     int last_windowed_pos_x = 0;